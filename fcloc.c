@@ -42,21 +42,133 @@
 *          9: 27-Nov-2013: Increased line length to 255, and functions to 64.
 *                          Fixed filename pointer compile warnings.
 *         11: 19-Oct-2022: Shortened token by 1 to avoid sprintf buffer overrun.
+*         12: 18-Oct-2026: Count every file named on the command line, one
+*                          report after another; until now only the last
+*                          file named was counted and the others were
+*                          ignored.  Added --dedupe to count identical
+*                          file contents only once.
+*         13: 18-Oct-2026: Count the C files inside .tar, .tar.gz and
+*                          .tar.zst archives without extracting them.
+*                          Where the platform has no popen, directories
+*                          or mmap (see the HAVE_ macros) the options
+*                          that need them say they are not supported.
+*         14: 18-Oct-2026: Added --git-diff to print the change in size of
+*                          the functions in files changed between commits.
+*         15: 18-Oct-2026: Added --compare to diff the functions of two
+*                          source trees.  Directories can be counted.
+*         16: 18-Oct-2026: Added --top and --sort for one ranked report of
+*                          the functions of all the files.
+*         17: 18-Oct-2026: Function names are interned in a string pool
+*                          instead of being truncated to 64 characters.
+*         18: 18-Oct-2026: Added --histogram for function size percentiles
+*                          by directory and for all of the files.
+*         19: 18-Oct-2026: Added --rollup for the totals of every directory
+*                          level, printed as soon as a directory is done.
+*         20: 18-Oct-2026: Added --sample to estimate the totals of a large
+*                          tree from a random sample of its files.
+*         21: 18-Oct-2026: Added per-file limits on size, time, nesting and
+*                          token length.  Fixed token buffer overrun.  The
+*                          time is wall clock time, and a file over a
+*                          limit still has its comment LOC counted.
+*         22: 18-Oct-2026: Added --lines-only for a fast count of only the
+*                          physical and comment lines of code.
+*         23: 18-Oct-2026: The lexer state is kept in a structure, and can
+*                          be saved after each function so that an edited
+*                          file is only lexed again around the edit.
+*         24: 18-Oct-2026: Added --perf-counters for the hardware counters
+*                          of the read, lex, collect and output phases,
+*                          with the kernel where that is allowed.
+*         25: 18-Oct-2026: All memory is allocated through mem_alloc, which
+*                          accounts for it by subsystem.  Added --mem-stats.
+*         26: 18-Oct-2026: Character classes come from a table instead of
+*                          ctype, so they do not depend on the locale.
+*         27: 18-Oct-2026: Keywords are compiled into a hash table at
+*                          startup.  Added --profile for the keywords and
+*                          aliases of a site.
+*         28: 18-Oct-2026: Files can be lexed as C89, C99/C11 or C++, with
+*                          the character classes and keywords of that
+*                          dialect, chosen by --lang or, with --lang auto,
+*                          by extension.  Without --lang every file is
+*                          still lexed as C++.
+*         29: 18-Oct-2026: Added --store, an append-only results history
+*                          with an index of each file and function, and
+*                          --history to print the sizes of a function.
+*         30: 18-Oct-2026: Added --checkpoint, which logs the results of
+*                          each finished input, and --resume, which
+*                          replays them and counts only the rest.
+*         31: 18-Oct-2026: Added --shard to count a share of the inputs,
+*                          picked by a hash of their names, and --merge
+*                          to report the checkpoints of the shards as
+*                          one run.
+*         32: 18-Oct-2026: The results are written to stdout in large
+*                          blocks instead of a line at a time, and once
+*                          per input when stdout is a terminal.
+*         33: 18-Oct-2026: The byte offsets and lines of each function
+*                          are kept beside the function list when they
+*                          are needed, and --locations writes them to an
+*                          index that other tools can map and seek with.
+*         34: 18-Oct-2026: Added --microbench and make microbench, to time
+*                          the keyword and name checks, the token builder,
+*                          the function detector and the lexer on their
+*                          own, against a baseline.
+*         35: 18-Oct-2026: --shard shares out the inputs by size, largest
+*                          first to the shard with the fewest bytes, so
+*                          the shards finish at about the same time.  The
+*                          checkpoints record the sizes, and --merge
+*                          refuses shards that saw different ones.
+*         36: 18-Oct-2026: Added --clones, which fingerprints the tokens
+*                          of each function as it is counted and reports
+*                          the groups of copied functions.
 **************************************************************************/
-static char version_date[]   = {"19-Oct-2022"};
-static char version_number[] = {"1.11"};
+static char version_date[]   = {"18-Oct-2026"};
+static char version_number[] = {"1.36"};
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
-#include <ctype.h>
 #include <math.h>
 #include <time.h>
 #include <string.h>
+#include <limits.h>
+
+/* what the platform has beyond the C library - elsewhere only the files
+   named are counted, and the options that need more say that they are
+   not supported on this platform */
+#if defined(_WIN32)
+  #define HAVE_POPEN          /* _popen - gzip, zstd and git */
+  #define HAVE_DIRECTORIES    /* stat and _findfirst */
+#elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+  #define HAVE_POSIX          /* getrusage and isatty */
+  #define HAVE_POPEN
+  #define HAVE_DIRECTORIES    /* stat and opendir */
+  #define HAVE_MMAP
+#endif
+
+#if defined(_WIN32)
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <io.h>
+#elif defined(HAVE_POSIX)
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <dirent.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/time.h>
+  #include <sys/resource.h>
+#endif
+#if defined(__linux__)
+  #include <unistd.h>
+  #include <sys/syscall.h>
+  #include <linux/perf_event.h>
+  #if defined(__NR_perf_event_open)
+    #define HAVE_PERF_EVENTS
+  #endif
+#endif
 
 /* LOCAL CONTSTANTS */
 #define MAX_LINE_SIZE (255)
-#define MAX_FUNCTION_NAME (64)
 #define TRUE (1)
 #define FALSE (0)
 
@@ -64,72 +176,175 @@ static char version_number[] = {"1.11"};
   #define stricmp strcasecmp
 #endif
 
+/* compressed archives are read through a decompressor on a pipe */
+#if defined(_WIN32)
+  #define popen _popen
+  #define pclose _pclose
+  #define POPEN_READ "rb"
+#else
+  #define POPEN_READ "r"
+#endif
+#if !defined(HAVE_POPEN)
+  /* no command can be run - open_archive and git_diff say so first */
+  #define popen(command,mode) ((FILE *) NULL)
+  #define pclose(fp) (-1)
+#endif
+
+/* the results are written to stdout in blocks of this size */
+#define OUTPUT_BUFFER_SIZE (256 * 1024)
+#if defined(_WIN32)
+  #define isatty _isatty
+  #define fileno _fileno
+#endif
+
+/* kinds of archive that can be counted without extracting them */
+#define ARCHIVE_NONE (0)
+#define ARCHIVE_TAR (1)
+#define ARCHIVE_TAR_GZIP (2)
+#define ARCHIVE_TAR_ZSTD (3)
+
+/* size of a tar header and of the blocks holding the member data */
+#define TAR_BLOCK_SIZE (512)
+/* a numeric field of a tar header that does not fit in unsigned long */
+#define TAR_NUMBER_BAD (ULONG_MAX)
+/* most characters of a member that are read into memory - a long name
+   or pax header, or a source file */
+#define TAR_HEADER_MAX (1024UL * 1024UL)
+#define TAR_MEMBER_MAX (1024UL * 1024UL * 1024UL)
+
+/* separator used to build the paths found in a directory tree */
+#if defined(_WIN32)
+  #define PATH_SEPARATOR '\\'
+#else
+  #define PATH_SEPARATOR '/'
+#endif
+
 /* set up counter type */
 typedef unsigned long int COUNTER;
 
+/* dialects of C that are lexed differently */
+#define LANG_C89 (0)
+#define LANG_C99 (1)      /* C99 and C11 */
+#define LANG_CPP (2)
+#define LANG_DIALECTS (3)
+#define LANG_AUTO (3)     /* picked by the extension of each file */
+
+/* dialects that have a keyword */
+#define IN_C99 (1 << LANG_C99)
+#define IN_CPP (1 << LANG_CPP)
+
 /* structure for keyword list */
 typedef struct keyword
 {
   char data[MAX_LINE_SIZE];  /* string containing the key word */
   unsigned char valid_flag;  /* is this used for LOC count? */
+  unsigned char dialects;    /* IN_ dialects that have it, 0 for all */
 } KEYWORD;
 
 /* array for keywords */
 static KEYWORD c_keywords[] =
 {
   /* ANSI C LOC countable reserved words and symbols (15) */
-  {"case",     TRUE},  {"default",  TRUE},  {"do",       TRUE},
-  {"else",     TRUE},  {"enum",     TRUE},  {"for",      TRUE},
-  {"if",       TRUE},  {"struct",   TRUE},  {"switch",   TRUE},
-  {"union",    TRUE},  {"while",    TRUE},  {"#",        TRUE},
-  {";",        TRUE},  {",",        TRUE},  {"}",        TRUE},
-
-  /* ANSI C++ LOC reserved words (26) */
-  {"bool",     FALSE},  {"catch",   TRUE},  {"class",    TRUE},
-  {"const_cast",FALSE}, {"delete",  FALSE}, {"dynamic_cast",FALSE},
-  {"false",    FALSE},  {"friend",  TRUE},  {"inline",   TRUE},
-  {"mutable",  FALSE},  {"namespace",FALSE},{"new",      FALSE},
-  {"operator", TRUE},   {"private", TRUE},  {"protected",TRUE},
-  {"public",   TRUE},   {"reinterpret_cast",FALSE},{"static_cast",FALSE},
-  {"template", TRUE},   {"this",    FALSE}, {"throw",   FALSE},
-  {"true",     FALSE},  {"try",     TRUE},  {"typeid",  FALSE},
-  {"using",    FALSE},  {"virtual", TRUE},
+  {"case",     TRUE,0},  {"default",  TRUE,0},  {"do",       TRUE,0},
+  {"else",     TRUE,0},  {"enum",     TRUE,0},  {"for",      TRUE,0},
+  {"if",       TRUE,0},  {"struct",   TRUE,0},  {"switch",   TRUE,0},
+  {"union",    TRUE,0},  {"while",    TRUE,0},  {"#",        TRUE,0},
+  {";",        TRUE,0},  {",",        TRUE,0},  {"}",        TRUE,0},
+
+  /* ANSI C++ LOC reserved words (26) - inline is in C99 too */
+  {"bool",     FALSE,IN_CPP}, {"catch",   TRUE, IN_CPP},
+  {"class",    TRUE, IN_CPP}, {"const_cast",FALSE,IN_CPP},
+  {"delete",   FALSE,IN_CPP}, {"dynamic_cast",FALSE,IN_CPP},
+  {"false",    FALSE,IN_CPP}, {"friend",  TRUE, IN_CPP},
+  {"inline",   TRUE, IN_C99|IN_CPP},
+  {"mutable",  FALSE,IN_CPP}, {"namespace",FALSE,IN_CPP},
+  {"new",      FALSE,IN_CPP}, {"operator",TRUE, IN_CPP},
+  {"private",  TRUE, IN_CPP}, {"protected",TRUE,IN_CPP},
+  {"public",   TRUE, IN_CPP}, {"reinterpret_cast",FALSE,IN_CPP},
+  {"static_cast",FALSE,IN_CPP},{"template",TRUE,IN_CPP},
+  {"this",     FALSE,IN_CPP}, {"throw",   FALSE,IN_CPP},
+  {"true",     FALSE,IN_CPP}, {"try",     TRUE, IN_CPP},
+  {"typeid",   FALSE,IN_CPP}, {"using",   FALSE,IN_CPP},
+  {"virtual",  TRUE, IN_CPP},
+
+  /* C99 and C11 reserved words that are not LOC countable (11) */
+  {"restrict", FALSE,IN_C99}, {"_Bool",   FALSE,IN_C99},
+  {"_Complex", FALSE,IN_C99}, {"_Imaginary",FALSE,IN_C99},
+  {"_Alignas", FALSE,IN_C99}, {"_Alignof",FALSE,IN_C99},
+  {"_Atomic",  FALSE,IN_C99}, {"_Generic",FALSE,IN_C99},
+  {"_Noreturn",FALSE,IN_C99}, {"_Static_assert",FALSE,IN_C99},
+  {"_Thread_local",FALSE,IN_C99},
 
   /* ANSI C Reserved words that are not LOC countable (28) */
-  {"asm",      FALSE},  {"auto",     FALSE},  {"break",    FALSE},
-  {"char",     FALSE},  {"const",    FALSE},  {"continue", FALSE},
-  {"do",       FALSE},  {"double",   FALSE},  {"entry",    FALSE},
-  {"enum",     FALSE},  {"extern",   FALSE},  {"float",    FALSE},
-  {"fortran",  FALSE},  {"goto",     FALSE},  {"int",      FALSE},
-  {"long",     FALSE},  {"register", FALSE},  {"return",   FALSE},
-  {"short",    FALSE},  {"signed",   FALSE},  {"sizeof",   FALSE},
-  {"static",   FALSE},  {"unsigned", FALSE},  {"void",     FALSE},
-  {"volatile", FALSE},
+  {"asm",      FALSE,0},  {"auto",     FALSE,0},  {"break",    FALSE,0},
+  {"char",     FALSE,0},  {"const",    FALSE,0},  {"continue", FALSE,0},
+  {"do",       FALSE,0},  {"double",   FALSE,0},  {"entry",    FALSE,0},
+  {"enum",     FALSE,0},  {"extern",   FALSE,0},  {"float",    FALSE,0},
+  {"fortran",  FALSE,0},  {"goto",     FALSE,0},  {"int",      FALSE,0},
+  {"long",     FALSE,0},  {"register", FALSE,0},  {"return",   FALSE,0},
+  {"short",    FALSE,0},  {"signed",   FALSE,0},  {"sizeof",   FALSE,0},
+  {"static",   FALSE,0},  {"unsigned", FALSE,0},  {"void",     FALSE,0},
+  {"volatile", FALSE,0},
 
   /* ANSI C symbols that are not countable (25) */
-  {"!", FALSE}, {"%", FALSE}, {"^",  FALSE}, {"&",  FALSE}, {"*",  FALSE},
-  {"(", FALSE}, {")", FALSE}, {"-",  FALSE}, {"_",  FALSE}, {"+",  FALSE},
-  {"=", FALSE}, {"~", FALSE}, {"[",  FALSE}, {"]",  FALSE}, {"\\", FALSE},
-  {"|", FALSE}, {":", FALSE}, {"'",  FALSE}, {"\"", FALSE}, {"{",  FALSE},
-  {".", FALSE}, {"<", FALSE}, {">",  FALSE}, {"/",  FALSE}, {"?",  FALSE},
+  {"!",  FALSE,0}, {"%",  FALSE,0}, {"^",  FALSE,0}, {"&",  FALSE,0},
+  {"*",  FALSE,0}, {"(",  FALSE,0}, {")",  FALSE,0}, {"-",  FALSE,0},
+  {"_",  FALSE,0}, {"+",  FALSE,0}, {"=",  FALSE,0}, {"~",  FALSE,0},
+  {"[",  FALSE,0}, {"]",  FALSE,0}, {"\\", FALSE,0}, {"|",  FALSE,0},
+  {":",  FALSE,0}, {"'",  FALSE,0}, {"\"", FALSE,0}, {"{",  FALSE,0},
+  {".",  FALSE,0}, {"<",  FALSE,0}, {">",  FALSE,0}, {"/",  FALSE,0},
+  {"?",  FALSE,0},
 
   /* ANSI C compound symbols that are not countable (21) */
   /* NOTE: the program as currently written
      does not recognize compound symbols */
-  {"+=",  FALSE}, {"-=",  FALSE}, {"*=", FALSE}, {"/=", FALSE}, {"%=", FALSE},
-  {"<<=", FALSE}, {">>=", FALSE}, {"&=", FALSE}, {"^=", FALSE}, {"|=", FALSE},
-  {"->",  FALSE}, {"++",  FALSE}, {"--", FALSE}, {"<<", FALSE}, {"<<", FALSE},
-  {"<=",  FALSE}, {">=",  FALSE}, {"==", FALSE}, {"!=", FALSE}, {"&&", FALSE},
-  {"||",  FALSE}
+  {"+=",  FALSE,0}, {"-=",  FALSE,0}, {"*=",  FALSE,0}, {"/=",  FALSE,0},
+  {"%=",  FALSE,0}, {"<<=", FALSE,0}, {">>=", FALSE,0}, {"&=",  FALSE,0},
+  {"^=",  FALSE,0}, {"|=",  FALSE,0}, {"->",  FALSE,0}, {"++",  FALSE,0},
+  {"--",  FALSE,0}, {"<<",  FALSE,0}, {"<<",  FALSE,0}, {"<=",  FALSE,0},
+  {">=",  FALSE,0}, {"==",  FALSE,0}, {"!=",  FALSE,0}, {"&&",  FALSE,0},
+  {"||",  FALSE,0}
 };
 
 /* Rather than use a constant (#define), this is easier to maintain */
 static size_t Max_Keywords = sizeof(c_keywords)/sizeof(KEYWORD);
 
+/* what a word of the keyword table is */
+#define KEY_RESERVED (0x01) /* a reserved word - never a function name */
+#define KEY_COUNTED (0x02)  /* counted as a logical line of code */
+
+/* one word of the keyword table */
+typedef struct keyword_entry
+{
+  char *word;               /* the word or symbol */
+  unsigned long hash;       /* hash of the word */
+  unsigned char flags[LANG_DIALECTS]; /* KEY_RESERVED and KEY_COUNTED */
+} KEYWORD_ENTRY;
+
+/* c_keywords and the --profile rules, compiled into an open addressing
+   hash set, so a token is found in time that depends on its length */
+typedef struct keyword_table
+{
+  KEYWORD_ENTRY *entries;   /* in the order that they were added */
+  size_t count;             /* number of words */
+  size_t size;              /* entries allocated */
+  size_t *slots;            /* 1 + index of an entry, 0 if empty */
+  size_t slot_count;        /* number of slots - a power of 2 */
+} KEYWORD_TABLE;
+
+static KEYWORD_TABLE Keywords;
+
+/* rules for counting that are added to c_keywords */
+static char *Profile_File = NULL;
+
+/* dialect of the file being lexed, and what --lang asked for */
+static int Dialect = LANG_CPP;
+static int Lang_Option = LANG_CPP;  /* every file as C++, as before */
+
 /* This element will hold function names and size of function */
 typedef struct function
 {
-  char name[MAX_FUNCTION_NAME]; /* function name */
+  char *name;                   /* function name, from Name_Pool */
   COUNTER loc_count;            /* number of logical lines of code */
   struct function *next;        /* next element in list - NULL if none */
 } FUNCTION;
@@ -140,30 +355,877 @@ typedef struct function ELEMENT;
 /* set up the start of the linked list */
 static ELEMENT *head;
 
+/* where a function is, and the fingerprint of its tokens - only needed
+   by --locations, --clones and --checkpoint, so it is kept apart from
+   the FUNCTION, which every run has one of for each function */
+typedef struct function_place
+{
+  size_t start;                 /* byte offset of the function name */
+  size_t end;                   /* byte offset after the closing brace */
+  COUNTER first_line;           /* line of the function name */
+  COUNTER last_line;            /* line of the closing brace */
+  unsigned long clone_a;        /* fingerprint of the tokens - see */
+  unsigned long clone_b;        /*   clone_token */
+  COUNTER tokens;               /* number of tokens fingerprinted */
+} FUNCTION_PLACE;
+
+/* the places of the functions of head, in the same order */
+typedef struct place_list
+{
+  FUNCTION_PLACE *items;
+  size_t count;
+  size_t size;
+} PLACE_LIST;
+
+static PLACE_LIST Places;
+static unsigned char Places_Flag = FALSE;  /* TRUE if Places is kept */
+
+/* block of memory that interned strings are carved from */
+typedef struct pool_block
+{
+  struct pool_block *next;  /* next (older) block - NULL if none */
+  size_t used;              /* characters used in this block */
+  size_t size;              /* characters that fit in this block */
+} POOL_BLOCK;
+
+/* size of a normal pool block - longer strings get a block of their own */
+#define POOL_BLOCK_SIZE (16384)
+
+/* interned strings - each different string is stored once */
+typedef struct string_pool
+{
+  POOL_BLOCK *blocks;       /* newest block first */
+  char **slots;             /* open addressing hash set of the strings */
+  unsigned long *hashes;    /* hash of the string in each slot */
+  size_t slot_count;        /* number of slots - a power of 2 */
+  size_t count;             /* number of strings in the pool */
+} STRING_POOL;
+
+/* function names of the whole run; a name is a handle into this pool */
+static STRING_POOL Name_Pool;
+
+/* state of the function detector - see check_for_function */
+typedef struct function_state
+{
+  ELEMENT *temp_node;          /* function currently being counted */
+  COUNTER loc_count;           /* logical lines of code in the function */
+  unsigned char count_flag;    /* TRUE once the function body is found */
+  unsigned char start_flag;    /* TRUE once a possible function is found */
+  COUNTER brace_count;         /* brace level inside the function body */
+  COUNTER parenthesis_count;   /* parenthesis level of the parameter list */
+  size_t word_start;           /* byte offset of the last word begun */
+  COUNTER word_line;           /* line of the last word begun */
+  size_t position;             /* byte offset of the last punctuation */
+  COUNTER line;                /* line of the last punctuation */
+  unsigned char slash;         /* TRUE if a / was held back from the
+                                  clone fingerprint, as it may start a
+                                  comment */
+  size_t place;                /* index in Places of temp_node */
+} FUNCTION_STATE;
+
+static FUNCTION_STATE Function_State;
+
+/* totals counted for one file */
+typedef struct file_counts
+{
+  COUNTER loc_count;      /* number of logical lines of code */
+  COUNTER physical_loc;   /* number of physical lines of code */
+  COUNTER comment_loc;    /* number of comment lines of code */
+} FILE_COUNTS;
+
+/* state of the lexer, which is saved after each function as a
+   checkpoint that lexing can be picked up again from */
+typedef struct lexer_state
+{
+  size_t index;                   /* next character to be lexed */
+  char last_char;                 /* the previous char read in */
+  char token[MAX_LINE_SIZE-1];    /* word in file */
+  char last_token[MAX_LINE_SIZE]; /* previous token */
+  unsigned char comment;     /* flag used for skipping stuff inside comments */
+  unsigned char quotation;   /* flag used for skipping stuff inside quotes */
+  unsigned char single_quote;/* skip stuff inside single quotes */
+  unsigned char precompiler; /* skip pre-compiler defines */
+  unsigned char precompiler_end; /* skip pre-compiler else to endif defines */
+  unsigned char precompiler_else; /* skip pre-compiler else to endif defines */
+  unsigned char precompiler_if; /* skip pre-compiler else to endif defines */
+  unsigned char control_code;/* skip control codes started with \ */
+  unsigned char c_plus_plus_comment; /* flag used to discern comment type */
+  COUNTER comment_nospace;   /* count of white space */
+  COUNTER comment_char;      /* count of total comment characters */
+  COUNTER depth;             /* nesting of braces and parenthesis */
+  int limit;                 /* limit reached, if any */
+  double deadline;           /* elapsed_seconds() when the time is up */
+  FILE_COUNTS counts;        /* totals so far */
+  FUNCTION_STATE functions;  /* function detector, saved at a checkpoint */
+  ELEMENT *tail;             /* last function found before a checkpoint */
+} LEXER_STATE;
+
+/* lexer states saved after each function, in order */
+typedef struct checkpoint_list
+{
+  LEXER_STATE *items;
+  size_t count;
+  size_t size;
+} CHECKPOINT_LIST;
+
+/* This element remembers the contents of a file that was counted */
+typedef struct fingerprint
+{
+  unsigned long hash_a;       /* FNV-1a hash of the file contents */
+  unsigned long hash_b;       /* shift-add-xor hash of the same bytes */
+  size_t length;              /* size of the file contents in bytes */
+  char *filename;             /* first file found with these contents */
+  char *contents;             /* copy of the contents if filename can not
+                                 be read again, as for an archive member,
+                                 else NULL */
+  unsigned char logged;       /* TRUE if the contents are from a log, so
+                                 no copy was kept */
+  struct fingerprint *next;   /* next fingerprint in the same bucket */
+} FINGERPRINT;
+
+/* hash buckets of the fingerprints - a power of 2, doubled as they fill */
+static FINGERPRINT **Fingerprint_Table = NULL;
+static size_t Fingerprint_Buckets = 0;
+static size_t Fingerprint_Count = 0;
+
+/* list of filenames to be counted */
+typedef struct file_list
+{
+  char **names;          /* filenames, each one allocated */
+  size_t count;          /* number of filenames in the list */
+  size_t size;           /* number of filenames allocated */
+} FILE_LIST;
+
+/* a function found in the old and/or the new version of the files */
+typedef struct function_match
+{
+  char *filename;                   /* file, relative to the tree */
+  char *name;                       /* function name, from Name_Pool */
+  COUNTER old_loc;                  /* logical lines of code before */
+  COUNTER new_loc;                  /* logical lines of code after */
+  unsigned char in_old;             /* TRUE if in the old version */
+  unsigned char in_new;             /* TRUE if in the new version */
+  unsigned long hash;               /* hash of filename and name */
+  struct function_match *next;      /* next match in the same bucket */
+} FUNCTION_MATCH;
+
+/* hash join of the functions of two versions, keyed by file and name */
+typedef struct match_table
+{
+  FUNCTION_MATCH **buckets;   /* hash buckets - a power of 2 */
+  size_t bucket_count;        /* number of buckets */
+  size_t count;               /* number of functions in the table */
+} MATCH_TABLE;
+
+/* a function kept for the ranked report */
+typedef struct ranked_function
+{
+  char *filename;                   /* file the function is in */
+  char *name;                       /* function name, from Name_Pool */
+  COUNTER loc_count;                /* number of logical lines of code */
+  unsigned long order;              /* order found, used to break ties */
+} RANKED_FUNCTION;
+
+/* functions for the ranked report - a bounded min-heap for --top */
+typedef struct rank_list
+{
+  RANKED_FUNCTION *items;   /* functions kept */
+  size_t count;             /* number of functions kept */
+  size_t size;              /* number of functions allocated */
+  unsigned long found;      /* number of functions offered */
+} RANK_LIST;
+
+/* functions of fewer tokens are not reported by --clones */
+#define CLONE_MIN_TOKENS (40)
+
+/* a function kept for the --clones report */
+typedef struct clone_function
+{
+  char *filename;                   /* file the function is in */
+  char *name;                       /* function name, from Name_Pool */
+  COUNTER loc_count;                /* number of logical lines of code */
+  unsigned long hash_a;             /* fingerprint of its tokens */
+  unsigned long hash_b;
+  COUNTER tokens;                   /* number of tokens */
+  unsigned long order;              /* order found, used to break ties */
+} CLONE_FUNCTION;
+
+/* functions kept for the --clones report */
+typedef struct clone_list
+{
+  CLONE_FUNCTION *items;
+  size_t count;
+  size_t size;
+} CLONE_LIST;
+
+/* functions of the --clones report with the same fingerprint */
+typedef struct clone_group
+{
+  size_t first;                     /* first function, in the sorted list */
+  size_t count;                     /* number of functions */
+  COUNTER loc_count;                /* their combined LOC */
+  unsigned long order;              /* order the first was found */
+} CLONE_GROUP;
+
+/* ways to order the ranked report */
+#define SORT_NONE (0)
+#define SORT_LOC (1)
+#define SORT_NAME (2)
+#define SORT_FILE (3)
+
+/* buckets of a function size histogram - sizes below HISTOGRAM_LINEAR
+   have a bucket each, then each power of 2 is split into 8 buckets */
+#define HISTOGRAM_BUCKETS (256)
+#define HISTOGRAM_LINEAR (16)
+
+/* mergeable summary of the sizes of many functions */
+typedef struct histogram
+{
+  unsigned long buckets[HISTOGRAM_BUCKETS];  /* functions in each bucket */
+  COUNTER count;              /* number of functions */
+  COUNTER sum;                /* total logical lines of code */
+  COUNTER min;                /* smallest function */
+  COUNTER max;                /* largest function */
+} HISTOGRAM;
+
+/* function size histogram of the files in one directory */
+typedef struct directory_histogram
+{
+  char *directory;                     /* name of the directory */
+  HISTOGRAM histogram;                 /* functions of its files */
+  struct directory_histogram *next;    /* next in the same bucket */
+} DIRECTORY_HISTOGRAM;
+
+/* hash buckets of the directory histograms - must be a power of 2 */
+#define MAX_DIRECTORY_BUCKETS (256)
+static DIRECTORY_HISTOGRAM *Directory_Table[MAX_DIRECTORY_BUCKETS];
+static size_t Directory_Count = 0;
+
+/* totals of a directory and everything below it */
+typedef struct rollup_node
+{
+  char *path;                    /* directory, as found in the filenames */
+  COUNTER files;                 /* files counted */
+  COUNTER functions;             /* functions found */
+  COUNTER function_loc;          /* logical lines of code in functions */
+  COUNTER loc_count;             /* logical lines of code */
+  COUNTER physical_loc;          /* physical lines of code */
+  COUNTER comment_loc;           /* comment lines of code */
+  unsigned long pending;         /* inputs and subdirectories not done */
+  unsigned char emitted;         /* TRUE once the totals are printed */
+  struct rollup_node *parent;    /* directory above - NULL for the top */
+  struct rollup_node *child;     /* first subdirectory */
+  struct rollup_node *last_child;/* last subdirectory */
+  struct rollup_node *sibling;   /* next subdirectory of the parent */
+} ROLLUP_NODE;
+
+/* per-file limits - a file over a limit only gets its physical LOC */
+#define LIMIT_NONE (0)
+#define LIMIT_BYTES (1)
+#define LIMIT_TIME (2)
+#define LIMIT_DEPTH (3)
+#define LIMIT_TOKEN (4)
+/* characters lexed between looks at the clock */
+#define LIMIT_CLOCK_INTERVAL (0x10000)
+
+/* states of the --lines-only scanner */
+#define LINES_CODE (0)
+#define LINES_COMMENT (1)
+#define LINES_QUOTE (2)
+#define LINES_SINGLE_QUOTE (3)
+#define LINES_PRECOMPILER_IF (4)    /* first word after the # */
+#define LINES_PRECOMPILER_ELSE (5)  /* skipping else to the next # */
+#define LINES_PRECOMPILER_END (6)   /* word after a skipped # */
+#define LINES_PRECOMPILER (7)       /* rest of the pre-compiler line */
+#define LINES_STATES (8)
+
+/* classes of characters - the same in every locale, and for 8-bit
+   characters, which are part of a word like letters are */
+#define CHAR_SPACE (0x01)       /* isspace() in the C locale */
+#define CHAR_NEWLINE (0x02)
+#define CHAR_PUNCT (0x04)       /* ispunct() in the C locale */
+#define CHAR_DIGIT (0x08)
+#define CHAR_WORD (0x10)        /* part of a word, including _ and ~ */
+#define CHAR_DELIMITER (0x20)   /* punctuation that ends a word */
+#define CHAR_QUOTE (0x40)
+#define CHAR_LINE_COMMENT (0x80) /* after a / it starts a // comment */
+#define char_class(c) (Char_Class[(unsigned char) (c)])
+
+/* parts of the program that memory is accounted to */
+#define MEM_FUNCTIONS (0) /* function records */
+#define MEM_NAMES (1)     /* function names and keywords */
+#define MEM_BUFFERS (2)   /* file contents and other I/O buffers */
+#define MEM_CACHES (3)    /* fingerprints, summaries and checkpoints */
+#define MEM_PATHS (4)     /* file lists and names of files */
+#define MEM_SUBSYSTEMS (5)
+
+/* phases that --perf-counters measures */
+#define PERF_OTHER (0)
+#define PERF_READ (1)
+#define PERF_LEX (2)      /* lexing, which also finds the functions */
+#define PERF_COLLECT (3)  /* keeping the results for the summaries */
+#define PERF_OUTPUT (4)
+#define PERF_PHASES (5)
+
+/* hardware events that --perf-counters counts */
+#define PERF_CYCLES (0)
+#define PERF_INSTRUCTIONS (1)
+#define PERF_BRANCH_MISSES (2)
+#define PERF_CACHE_MISSES (3)
+#define PERF_EVENTS (4)
+
+/* values counted for each file picked by --sample */
+#define SAMPLE_LOC (0)
+#define SAMPLE_PHYSICAL (1)
+#define SAMPLE_COMMENT (2)
+#define SAMPLE_FUNCTIONS (3)
+#define SAMPLE_VALUES (4)
+
+/* every allocation starts with one of these, so that it can be
+   accounted for when it is freed - the union keeps the memory after
+   it aligned for any type */
+typedef union mem_header
+{
+  struct
+  {
+    size_t size;                   /* bytes asked for */
+    int subsystem;                 /* one of the MEM_ values */
+  } info;
+  long double align_long_double;
+  double align_double;
+  long align_long;
+  void *align_pointer;
+} MEM_HEADER;
+
+/* memory accounting of one subsystem */
+typedef struct mem_stats
+{
+  unsigned long allocations;       /* number of allocations */
+  double allocated;                /* bytes of all of the allocations */
+  size_t in_use;                   /* bytes allocated and not freed */
+  size_t peak;                     /* most bytes in use at once */
+} MEM_STATS;
+
+/* counters for --perf-counters - the counters run all of the time,
+   and are read each time the phase changes */
+typedef struct perf_counters
+{
+  int fd[PERF_EVENTS];             /* -1 if the event is not open */
+  unsigned char counted[PERF_EVENTS]; /* TRUE if the event was opened */
+  double last[PERF_EVENTS];        /* value when the phase started */
+  double totals[PERF_PHASES][PERF_EVENTS];
+  clock_t last_clock;              /* clock() when the phase started */
+  double seconds[PERF_PHASES];
+  int phase;                       /* phase being measured */
+  unsigned long bytes;             /* bytes of input counted */
+  char *error;                     /* why there are no counters, if not */
+  unsigned char user_only;         /* TRUE if the kernel is left out */
+} PERF_COUNTERS;
+
+/* --microbench: the inner routines are timed on their own, each on a
+   fixed input held in memory */
+#define BENCH_KEYWORDS (0)        /* keyword_compare */
+#define BENCH_NAMES (1)           /* function_name_compare */
+#define BENCH_TOKENS (2)          /* build_token */
+#define BENCH_FUNCTIONS (3)       /* check_for_function */
+#define BENCH_LEXER (4)           /* lex_buffer, through count_buffer */
+#define BENCH_KERNELS (5)
+#define BENCH_SECONDS (0.05)      /* shortest time that is measured */
+#define BENCH_REPEATS (5)         /* measurements - the fastest is kept */
+#define BENCH_SOURCE_COPIES (256) /* copies of Bench_Source lexed */
+
+/* one input of a --sample run */
+typedef struct sample_unit
+{
+  unsigned long bytes;           /* size of the file on disk */
+  unsigned int stratum;          /* size class of the file */
+  unsigned char selected;        /* TRUE if picked to be counted */
+  COUNTER values[SAMPLE_VALUES]; /* totals counted for the file */
+} SAMPLE_UNIT;
+
+/* one input of a --shard run, for sharing them out by size */
+typedef struct shard_unit
+{
+  unsigned long bytes;           /* size of the file on disk */
+  char *name;                    /* name of the input */
+  size_t index;                  /* index of the input in Input_List */
+} SHARD_UNIT;
+
+/* size classes - each covers a factor of 4 in file size */
+#define SAMPLE_STRATA (20)
+
+/* the results history of --store and --history: an append-only file of
+   function records, each linked back to the one before it with the same
+   file name and function, and an index of the newest of each */
+#define HISTORY_MAGIC "FCLOCH01"
+#define HISTORY_INDEX_MAGIC "FCLOCI01"
+#define HISTORY_HEADER_SIZE (8)        /* magic at the start of the store */
+#define HISTORY_RECORD_SIZE (32)       /* before the file and function */
+#define HISTORY_INDEX_HEADER_SIZE (32)
+#define HISTORY_SLOT_SIZE (16)         /* hash, then offset of the record */
+#define HISTORY_DEFAULT_FILE "fcloc.history"
+
+/* a record is: length (4), hash of the key (4), offset of the record
+   before it with the same key, or 0 (8), time of the run (8), LOC (4),
+   length of the file name (2) and of the function name (2), then the
+   two names.  Numbers are little endian. */
+typedef struct history_store
+{
+  char *filename;             /* the store; the index is filename.idx */
+  char *data;                 /* the store as it was, mapped */
+  size_t length;              /* bytes in data */
+  unsigned char *added;       /* records added by this run */
+  size_t added_length;
+  size_t added_size;
+  char *index_map;            /* the index file, mapped */
+  size_t index_length;
+  unsigned char *slots;       /* the index - in index_map, or owned */
+  unsigned char slots_owned;  /* TRUE if slots was allocated */
+  unsigned long slot_count;   /* a power of 2 */
+  unsigned long used;         /* slots that are in use */
+  unsigned char index_stale;  /* TRUE if the index file must be written */
+  unsigned long run_time;     /* time of this run */
+} HISTORY_STORE;
+
+/* --checkpoint: the results of each file are written to a log as the
+   inputs are finished, so that --resume can carry on after them.  The
+   log starts with CHECKPOINT_MAGIC, the number of inputs (8), the N of
+   --shard i/N (4) and a fingerprint of the input sizes it shared them
+   out by (4), then the length (2) and name of each input - the work to
+   be done.  Then come
+   the records, each starting with its length (4) and type (1):
+     file:  limit (1), length of the name (2), input (8), length of the
+            contents (8), their fingerprint (4, 4), LOC (4), physical
+            LOC (4), comment LOC (4), number of functions (4), the name,
+            then for each function its LOC (4), start and end offsets
+            (8, 8), first and last lines (4, 4), clone fingerprint (4, 4)
+            and tokens (4), name length (2) and name
+     done:  return status of the input (1), 2 unused, input (8)
+   Numbers are little endian, like the results history. */
+#define CHECKPOINT_MAGIC "FCLOCC04"
+#define CHECKPOINT_HEADER_SIZE (24)
+#define CHECKPOINT_FILE (1)
+#define CHECKPOINT_DONE (2)
+#define CHECKPOINT_FILE_SIZE (48)      /* before the names */
+#define CHECKPOINT_DONE_SIZE (16)
+#define CHECKPOINT_FUNCTION_SIZE (42)  /* before the name */
+#define CHECKPOINT_SECONDS (10)        /* most time between writes */
+#define CHECKPOINT_DEFAULT_FILE "fcloc.checkpoint"
+
+typedef struct results_log
+{
+  char *filename;             /* the log */
+  FILE *fp;                   /* the log, appended to */
+  unsigned char *pending;     /* records not written yet */
+  size_t pending_length;
+  size_t pending_size;
+  time_t last_write;          /* when pending was last written */
+  char **maps;                /* logs replayed from, mapped */
+  size_t *map_lengths;        /* bytes in each of maps */
+  size_t map_count;
+  unsigned char **replay;     /* first record of each finished input in
+                                 maps, NULL if it was not finished */
+  unsigned long shard_count;  /* --shard N of the log mapped last */
+  unsigned long shard_plan;   /* and its fingerprint of the input sizes */
+} RESULTS_LOG;
+
+/* what map_results_log found */
+#define LOG_READY (0)
+#define LOG_MISSING (1)
+#define LOG_CUT_SHORT (2)           /* stopped before listing its inputs */
+#define LOG_DIFFERENT (3)           /* for other inputs, or not a log */
+
+/* --locations: where each function is, for tools that look at the code
+   of a function without parsing the file again.  The index starts with
+   LOCATION_MAGIC, the number of files (8) and functions (8) and where
+   the names start (8).  Then come the files, each with the offset (8)
+   and length (4) of its name, its number of functions (4) and index of
+   its first function (8); then the functions, each with the offset (8)
+   and length (4) of its name, LOC (4), byte offsets of its name and
+   after its closing brace (8, 8), and the lines of those (4, 4); then
+   the names, each ending with a 0.  Offsets are from the start of the
+   index and numbers are little endian, like the results history. */
+#define LOCATION_MAGIC "FCLOCL01"
+#define LOCATION_HEADER_SIZE (32)
+#define LOCATION_FILE_SIZE (24)
+#define LOCATION_FUNCTION_SIZE (40)
+
+typedef struct location_index
+{
+  unsigned char *files;       /* the files, name offsets from names */
+  size_t files_length;
+  size_t files_size;
+  unsigned char *functions;   /* the functions, name offsets from names */
+  size_t functions_length;
+  size_t functions_size;
+  unsigned char *names;
+  size_t names_length;
+  size_t names_size;
+  unsigned long file_count;
+  unsigned long function_count;
+} LOCATION_INDEX;
+
+/* short names for the table below */
+#define W_ (CHAR_WORD)
+#define D_ (CHAR_WORD | CHAR_DIGIT)
+#define S_ (CHAR_SPACE)
+#define N_ (CHAR_SPACE | CHAR_NEWLINE)
+#define P_ (CHAR_PUNCT | CHAR_DELIMITER)
+#define Q_ (CHAR_PUNCT | CHAR_DELIMITER | CHAR_QUOTE)
+#define U_ (CHAR_PUNCT | CHAR_WORD)
+
+/* class of each character, used by the lexer and the function checks */
+static const unsigned char Char_Class[256] =
+{
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, S_, N_, S_, S_, S_, W_, W_, /* 00-0F */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* 10-1F */
+  S_, P_, Q_, P_, P_, P_, P_, Q_, P_, P_, P_, P_, P_, P_, P_, P_, /* 20-2F */
+  D_, D_, D_, D_, D_, D_, D_, D_, D_, D_, P_, P_, P_, P_, P_, P_, /* 30-3F */
+  P_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* 40-4F */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, P_, P_, P_, P_, U_, /* 50-5F */
+  P_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* 60-6F */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, P_, P_, P_, U_, W_, /* 70-7F */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* 80-8F */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* 90-9F */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* A0-AF */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* B0-BF */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* C0-CF */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* D0-DF */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, /* E0-EF */
+  W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_, W_  /* F0-FF */
+};
+
+#undef W_
+#undef D_
+#undef S_
+#undef N_
+#undef P_
+#undef Q_
+#undef U_
+
 /* set up debug */
 static unsigned char Debug_Flag = FALSE;
 static FILE *debug_file_ptr = NULL;
 /*static char debug_string[256];*/
 static char Append_File_Name[256] = {""};
-static char C_Filename[256] = {""};
 static unsigned char WKS_Flag = FALSE;
 static unsigned char WKS_Header_Flag = FALSE;
+/* -h also heads the summaries printed after all of the files */
+static unsigned char WKS_Summary_Header_Flag = FALSE;
+static unsigned char Dedupe_Flag = FALSE;
+static char *Git_Range = NULL;
+static char *Compare_Old_Tree = NULL;
+static char *Compare_New_Tree = NULL;
+static unsigned char Sort_Key = SORT_NONE;
+static unsigned long Top_Count = 0;
+static RANK_LIST Rank_List;
+static FILE_LIST Rank_Files;
+static unsigned char Histogram_Flag = FALSE;
+static unsigned char Clones_Flag = FALSE;
+static CLONE_LIST Clone_List;
+static FILE_LIST Clone_Files;
+/* FALSE when only summary reports of all the files are printed */
+static unsigned char File_Report_Flag = TRUE;
+static unsigned char Rollup_Flag = FALSE;
+static ROLLUP_NODE *Rollup_Root = NULL;
+static double Sample_Size = 0.0;        /* fraction, or number of files */
+static unsigned char Sample_Fraction = FALSE; /* TRUE if a fraction */
+static unsigned long Sample_Seed = 0;   /* 0 picks a seed from the time */
+static unsigned long Sample_Seed_Used = 0;  /* seed the sample was picked
+                                               with, for the report */
+static SAMPLE_UNIT *Sample_Units = NULL;
+static size_t Current_Input = 0;        /* index into Input_List */
+/* per-file limits, 0 for none - the token limit is the token buffer */
+static unsigned long Limit_Bytes = 0;
+static double Limit_Seconds = 0.0;
+static COUNTER Limit_Depth = 0;
+static size_t Limit_Token = MAX_LINE_SIZE - 2;
+static unsigned char Lines_Only_Flag = FALSE;
+static FILE_COUNTS Lines_Total;         /* totals of --lines-only */
+static size_t Lines_Files = 0;          /* files counted by --lines-only */
+/* characters that can change the state of the --lines-only scanner */
+static unsigned char Line_Stops[LINES_STATES][256];
+static unsigned char Line_Stops_Ready = FALSE;
+static MEM_STATS Mem_Stats[MEM_SUBSYSTEMS + 1]; /* last is the total */
+static unsigned char Mem_Stats_Flag = FALSE;
+static unsigned char Perf_Flag = FALSE;
+static PERF_COUNTERS Perf;
+
+/* names of the --microbench kernels, as in the baseline file */
+static char *Bench_Names[BENCH_KERNELS] =
+{
+  "keyword_compare","function_name_compare","build_token",
+  "check_for_function","lex_buffer"
+};
+
+/* tokens for the keyword and name checks */
+static char *Bench_Tokens[] =
+{
+  "static","int","table","[","LIMIT","]","=","{","1",",","}",";",
+  "sum_table","(","const","*","values","unsigned","count",")","total",
+  "0","index","for","<","++","if",">","+=","else","printf","return",
+  "~Buffer","_reserved","0x1F","while","switch","case","default",":",
+  NULL
+};
+
+/* tokens of a function, as check_token hands them on */
+static char *Bench_Function[] =
+{
+  "int","sum_table","(","const","int","*","values",",","unsigned","int",
+  "count",")","{","int","total","=","0",";","unsigned","int","index",";",
+  "for","(","index","=","0",";","index","<","count",";","index","+","+",
+  ")","{","if","(","values","[","index","]",">","0",")","total","+","=",
+  "values","[","index","]",";","else","printf","(",")",";","}","return",
+  "total",";","}",NULL
+};
+
+/* C program text for the token builder and the lexer */
+static char Bench_Source[] =
+  "/* sum of a table, for --microbench */\n"
+  "#include <stdio.h>\n"
+  "#define LIMIT (16)\n"
+  "\n"
+  "static int table[LIMIT] = { 1, 2, 3, 0x1F };\n"
+  "\n"
+  "int sum_table(const int *values,unsigned int count)\n"
+  "{\n"
+  "  int total = 0;             // running total\n"
+  "  unsigned int index;\n"
+  "\n"
+  "  for (index = 0; index < count; index++)\n"
+  "  {\n"
+  "    if (values[index] > 0)\n"
+  "      total += values[index];\n"
+  "    else\n"
+  "      printf(\"skipped %u\\n\",index);\n"
+  "  }\n"
+  "  return total;\n"
+  "}\n"
+  "\n";
+static int Bench_Found = 0;       /* results, so calls are not dropped */
+static char *Relex_Old_File = NULL;     /* --relex old_file new_file */
+static char *Relex_New_File = NULL;
+static HISTORY_STORE Store;
+static char *Store_File = NULL;         /* --store file */
+static char *History_Key = NULL;        /* --history file:function */
+static RESULTS_LOG Results_Log;
+static LOCATION_INDEX Locations;
+static char *Locations_File = NULL;     /* --locations file */
+static char *Microbench_File = NULL;    /* --microbench baseline */
+static char *Results_File = NULL;       /* --checkpoint file */
+static unsigned char Resume_Flag = FALSE;
+static unsigned long Shard_Index = 0;   /* --shard i/N, from 0 */
+static unsigned long Shard_Count = 0;   /* 0 if not sharded */
+static unsigned char Merge_Flag = FALSE;
+static unsigned char *Shard_Member = NULL; /* TRUE for each input counted */
+static unsigned long Shard_Plan = 0;    /* fingerprint of the input sizes */
+/* buffer of stdout, and TRUE if it is a terminal to be kept up to date */
+static char Output_Buffer[OUTPUT_BUFFER_SIZE];
+static unsigned char Output_Interactive = FALSE;
+/* character classes that each dialect is lexed with */
+static unsigned char Dialect_Class[LANG_DIALECTS][256];
+
+/* the C filenames to be counted, in command line order */
+static FILE_LIST Input_List;
 
 /* FUNCTION PROTOTYPES */
+void *mem_alloc(int subsystem,size_t size);
+void *mem_calloc(int subsystem,size_t count,size_t size);
+void *mem_realloc(int subsystem,void *memory,size_t size);
+void mem_free(void *memory);
+void mem_account(int subsystem,size_t old_size,size_t new_size);
+void print_mem_stats(void);
 ELEMENT *create_list_element(void);
+unsigned long hash_bytes(unsigned long hash,char *data,size_t length);
+char *intern_string(STRING_POOL *pool,char *string);
+void delete_string_pool(STRING_POOL *pool);
 void add_element(ELEMENT *e);
 void delete_elements(void);
+void delete_list(ELEMENT *list);
+size_t add_place(void);
+void delete_places(void);
 ELEMENT *last_element(void);
 FILE *open_input_file(char *filename);
+char *read_input_file(char *filename,size_t *length);
+char *read_stream(FILE *fp,size_t *length);
+char *read_command(char *command,size_t *length);
+FILE *open_git_blob(char *revision,char *path);
+char *read_git_blob(FILE *fp,char *revision,char *path,size_t *length);
+ELEMENT *count_version(char *buffer,size_t length,FILE_COUNTS *counts);
+int git_diff(char *range);
+int count_file(char *filename);
+void count_contents(char *filename,char *buffer,size_t length,int member);
+int is_source_file(char *filename);
+int archive_type(char *filename);
+FILE *open_archive(char *filename,int type);
+int close_archive(FILE *fp,int type);
+char *shell_command(char *program,char *argument);
+int has_suffix(char *string,char *suffix);
+unsigned long tar_number(char *field,size_t size);
+int skip_archive_bytes(FILE *fp,unsigned long count);
+char *read_archive_member(FILE *fp,unsigned long size,unsigned long limit);
+char *pax_path(char *data,unsigned long size);
+int count_archive(char *filename);
+void init_lexer(LEXER_STATE *lexer);
+int count_buffer(char *buffer,size_t length,FILE_COUNTS *counts);
+int build_token(LEXER_STATE *lexer,char new_char,size_t index);
+int lex_buffer(LEXER_STATE *lexer,char *buffer,size_t length,
+  unsigned char stop);
+void save_checkpoint(CHECKPOINT_LIST *list,LEXER_STATE *lexer);
+void delete_checkpoints(CHECKPOINT_LIST *list);
+int count_checkpoints(char *buffer,size_t length,FILE_COUNTS *counts,
+  CHECKPOINT_LIST *list);
+int same_lexer_state(LEXER_STATE *a,LEXER_STATE *b);
+size_t find_checkpoint(CHECKPOINT_LIST *list,size_t first,size_t index);
+size_t relex_buffer(char *old_buffer,size_t old_length,char *buffer,
+  size_t length,FILE_COUNTS *counts,CHECKPOINT_LIST *list);
+void shift_counts(FILE_COUNTS *counts,FILE_COUNTS *before,
+  FILE_COUNTS *after);
+int relex_files(char *old_file,char *new_file);
+void perf_open(void);
+double perf_read(int event);
+void perf_phase(int phase);
+void perf_close(void);
+void print_perf_counters(void);
+size_t bench_kernel(int kernel,char *text,size_t length,size_t *bytes);
+int run_microbench(char *filename);
+double elapsed_seconds(void);
+char *limit_name(int limit);
+void init_line_stops(void);
+void count_lines_only(char *buffer,size_t length,FILE_COUNTS *counts);
+void init_dialects(void);
+void set_dialect(char *filename);
+void put_number(unsigned char *data,unsigned long value,int size);
+unsigned long get_number(unsigned char *data,int size);
+char *map_file(char *filename,size_t *length);
+void unmap_file(char *data,size_t length);
+char *base_name(char *path);
+unsigned char *history_record(HISTORY_STORE *store,unsigned long offset);
+unsigned long history_slot(HISTORY_STORE *store,unsigned long hash,
+  char *filename,size_t file_len,char *name,size_t name_len);
+int history_grow(HISTORY_STORE *store);
+unsigned long history_link(HISTORY_STORE *store,unsigned char *record,
+  unsigned long offset);
+int load_history_index(HISTORY_STORE *store);
+int open_store(HISTORY_STORE *store,char *filename);
+int store_functions(HISTORY_STORE *store,char *filename);
+int close_store(HISTORY_STORE *store);
+int print_history(char *key);
+int check_duplicate(char *filename,char *buffer,unsigned long hash_a,
+  unsigned long hash_b,size_t length,int member);
+void report_contents(char *filename,FILE_COUNTS *counts,int limit);
+unsigned char *add_log_bytes(RESULTS_LOG *log,size_t size);
+int write_results_log(RESULTS_LOG *log);
+int map_results_log(RESULTS_LOG *log,char *filename,size_t given,
+  size_t *records);
+size_t find_finished_inputs(RESULTS_LOG *log,unsigned char *data,
+  size_t length,size_t offset);
+int open_results_log(RESULTS_LOG *log,char *filename,unsigned char resume);
+int open_partials(RESULTS_LOG *log,FILE_LIST *partials);
+int compare_shard_units(const void *a,const void *b);
+int select_shard(void);
+int in_shard(size_t input);
+unsigned char *add_location_bytes(unsigned char **data,size_t *length,
+  size_t *size,size_t more);
+void index_locations(LOCATION_INDEX *index,char *filename);
+int write_locations(LOCATION_INDEX *index,char *filename);
+void open_output(void);
+void log_file_results(RESULTS_LOG *log,char *filename,unsigned long hash_a,
+  unsigned long hash_b,size_t length,FILE_COUNTS *counts,int limit);
+void log_input_done(RESULTS_LOG *log,size_t input,int status);
+int replay_input(RESULTS_LOG *log,size_t input);
+int close_results_log(RESULTS_LOG *log);
+void print_lines(char *filename,FILE_COUNTS *counts,unsigned char header);
+void print_lines_total(void);
 FILE *open_debug_file(void);
 char *debug_file_date(void);
 void Interpret_Arguments(int argc, char *argv[]);
 void Usage(char *filename);
 
+void hash_step(unsigned long *hash_a,unsigned long *hash_b,char *data,
+  size_t length);
+void fingerprint_contents(char *buffer,size_t length,
+  unsigned long *hash_a,unsigned long *hash_b);
+FINGERPRINT *find_fingerprint(unsigned long hash_a,unsigned long hash_b,
+  size_t length,char *filename,char *buffer,int member);
+int contents_differ(FINGERPRINT *original,char *filename,char *buffer,
+  size_t length);
+void delete_fingerprints(void);
+void print_duplicate(char *filename,char *original);
 void print_functions(char *filename,COUNTER loc,COUNTER ploc,COUNTER cloc);
 void print_functions_wks(char *filename,COUNTER loc,unsigned char header);
+void print_diff_header(void);
+void print_diff_line(char *filename,char *function,COUNTER old_loc,
+  COUNTER new_loc);
+void print_function_diff(char *filename,ELEMENT *old_list,ELEMENT *new_list,
+  COUNTER old_loc,COUNTER new_loc);
+void add_file_name(FILE_LIST *list,char *name);
+void add_input_name(FILE_LIST *list,char *name);
+void delete_file_list(FILE_LIST *list);
+int is_directory(char *path);
+unsigned long file_bytes(char *filename);
+void walk_directory(FILE_LIST *list,char *path);
+int compare_file_names(const void *a,const void *b);
+unsigned long hash_match_key(char *filename,char *name);
+FUNCTION_MATCH *insert_match(MATCH_TABLE *table,char *filename,char *name,
+  unsigned long hash);
+void match_build(MATCH_TABLE *table,char *filename,ELEMENT *list);
+void match_probe(MATCH_TABLE *table,char *filename,ELEMENT *list);
+int compare_match_delta(const void *a,const void *b);
+FUNCTION_MATCH **sort_matches(MATCH_TABLE *table,size_t *count);
+void delete_matches(MATCH_TABLE *table);
+ELEMENT *count_tree_file(char *filename,FILE_COUNTS *counts);
+int compare_trees(char *old_tree,char *new_tree);
+void print_compare_line(char *change,char *function,COUNTER old_loc,
+  COUNTER new_loc,char *filename);
+int rank_less(RANKED_FUNCTION *a,RANKED_FUNCTION *b);
+void rank_sift_down(RANK_LIST *list,size_t index);
+void rank_sift_up(RANK_LIST *list,size_t index);
+void rank_functions(char *filename);
+int compare_ranked_loc(const void *a,const void *b);
+int compare_ranked_name(const void *a,const void *b);
+int compare_ranked_file(const void *a,const void *b);
+void print_ranked_functions(void);
+void clone_token(FUNCTION_STATE *state,char *token);
+void collect_clones(char *filename);
+int compare_clone_functions(const void *a,const void *b);
+int compare_clone_groups(const void *a,const void *b);
+void print_clones(void);
+unsigned int histogram_bucket(COUNTER loc);
+COUNTER histogram_bucket_value(unsigned int bucket);
+void add_histogram(HISTOGRAM *histogram,COUNTER loc);
+void merge_histogram(HISTOGRAM *total,HISTOGRAM *histogram);
+COUNTER histogram_percentile(HISTOGRAM *histogram,unsigned int percent);
+char *directory_name(char *filename);
+DIRECTORY_HISTOGRAM *find_directory_histogram(char *directory);
+void histogram_functions(char *filename);
+void print_histogram_line(HISTOGRAM *histogram,char *name);
+int compare_directory_histograms(const void *a,const void *b);
+void print_histograms(void);
+ROLLUP_NODE *rollup_child(ROLLUP_NODE *node,char *path,size_t length,
+  unsigned char add_pending);
+ROLLUP_NODE *find_rollup_node(char *filename,unsigned char add_pending);
+void register_rollup(char *filename);
+void rollup_file(char *filename,FILE_COUNTS *counts);
+void rollup_done(char *filename);
+void emit_rollup(ROLLUP_NODE *node,unsigned char cascade);
+void print_rollup_header(void);
+void delete_rollup(ROLLUP_NODE *node);
+unsigned long sample_random(void);
+size_t select_sample(void);
+void sample_file(FILE_COUNTS *counts);
+void sample_estimate(double *values,double *estimate,double *variance);
+void print_sample_line(char *name,double counted,double estimate,
+  double variance);
+void print_sample_estimates(size_t selected);
 void check_token(char *token,char *prev_token,COUNTER *count,COUNTER ploc);
+void reset_function_state(void);
 void check_for_function(char *token,char *prev_token);
+KEYWORD_ENTRY *find_keyword(const char *word);
+KEYWORD_ENTRY *add_keyword(char *word);
+int load_keywords(void);
+int load_profile(char *filename);
+void delete_keywords(void);
 int keyword_compare(const char *word);
 int function_name_compare(char *word);
 void keyword_print(void);
@@ -172,7 +1234,7 @@ void keyword_print(void);
 *
 * Function:    main
 *
-* Description: Reads in a C program file and counts the number of
+* Description: Reads in C program files and counts the number of
 *              logical lines of code.  Also displays each function
 *              and displays the number of logical lines of code
 *              for that function.
@@ -182,612 +1244,9141 @@ void keyword_print(void);
 *              argv - a pointer to each of the arguments passed into
 *                     the program from the command line.
 *
-* Return:      none
+* Return:      0 if every file was counted, 1 if any file failed.
 *
 **************************************************************************/
 int main(int argc,char *argv[])
 {
-  COUNTER loc_count;      /* number of logical lines of code */
-  COUNTER physical_loc;   /* number of physical lines of code */
-  COUNTER comment_loc;    /* number of comment lines of code */
-  COUNTER comment_nospace;/* count of white space */
-  COUNTER comment_char;   /* count of total comment characters */
-
-  FILE *file_ptr;      /* C program file stream */
-
-  char last_char;      /* the previous char read in from file */
-  char new_char;       /* the current char read in from file */
-
-  char token[MAX_LINE_SIZE-1]; /* word in file */
-  char token1[MAX_LINE_SIZE]; /* used for tokenizing characters */
-  char token2[MAX_LINE_SIZE];/* another word in a file. */
-  char last_token[MAX_LINE_SIZE];/* previous token */
-  unsigned short token_len;  /* length of the token string */
-
-  unsigned char comment;     /* flag used for skipping stuff inside comments */
-  unsigned char quotation;   /* flag used for skipping stuff inside quotes */
-  unsigned char single_quote;/* skip stuff inside single quotes */
-  unsigned char precompiler; /* skip pre-compiler defines */
-  unsigned char precompiler_end; /* skip pre-compiler else to endif defines */
-  unsigned char precompiler_else; /* skip pre-compiler else to endif defines */
-  unsigned char precompiler_if; /* skip pre-compiler else to endif defines */
-  unsigned char control_code;/* skip control codes started with \ */
-  unsigned char c_plus_plus_comment; /* flag used to discern comment type */
-
-  /* INITIALIZE */
-  new_char = 0;
-  last_char = 0;
-
-  token[0] = 0;
-  token2[0] = 0;
-  last_token[0] = 0;
-
-  comment = FALSE;
-  quotation = FALSE;
-  single_quote = FALSE;
-  precompiler = FALSE;
-  precompiler_end = FALSE; 
-  precompiler_else = FALSE;
-  precompiler_if = FALSE;
-  control_code = FALSE;
-  c_plus_plus_comment = FALSE;
-
-  loc_count = 0;
-  token_len = 0;
-  physical_loc = 0;
-
-  comment_loc = 0;
-  comment_nospace = 0;
-  comment_char = 0;
+  size_t file_index;   /* index into the list of files to count */
+  size_t sample_count = 0; /* number of files picked by --sample */
+  FILE_LIST partials;      /* checkpoints of the shards for --merge */
+  int status = 0;      /* program return status */
+  int input_status;    /* return status of one input */
 
+  open_output();
+  init_dialects();
+  if (load_keywords() != 0)
+    return (1);
   Interpret_Arguments(argc,argv);
-
-  /* === COUNT LOGICAL LOC === */
-
-  /* open the file */
-  file_ptr = open_input_file(C_Filename);
-  if (file_ptr == NULL)
+  if ((Profile_File != NULL) && (load_profile(Profile_File) != 0))
     return (1);
-
-  if (Debug_Flag)
+  if (Microbench_File != NULL)
   {
-    debug_file_ptr = open_debug_file();
-    fprintf(debug_file_ptr,"Reading file: %s\n",C_Filename);
+    status = run_microbench(Microbench_File);
+    delete_keywords();
+    return status;
   }
-
-  /* read the file one character at a time */
-  while ((new_char = fgetc(file_ptr)) != EOF)
+  if (History_Key != NULL)
   {
-    /* count physical lines of code */
-    if (new_char == '\n')
-      physical_loc++;
-
-    /* COMMENT - skip until end of comment */
-    if (comment != FALSE)
+    status = print_history(History_Key);
+    delete_keywords();
+    return status;
+  }
+  /* --shard: only this share of the inputs is counted; it is worked out
+     before the checkpoint is started, which records how the inputs were
+     shared out, unless the inputs come from the checkpoint */
+  if ((Shard_Count > 0) && (Input_List.count > 0) && (select_shard() != 0))
+    return (1);
+  /* --resume carries on from the inputs of the log */
+  if (Resume_Flag && (Results_File == NULL))
+    Results_File = CHECKPOINT_DEFAULT_FILE;
+  if ((Results_File != NULL) &&
+      (open_results_log(&Results_Log,Results_File,Resume_Flag) != 0))
+    return (1);
+  /* --merge: the files named are the checkpoints of the shards, and the
+     inputs come from them */
+  if (Merge_Flag)
+  {
+    if ((Results_File != NULL) || (Input_List.count == 0))
     {
-      /* count the number of characters in the comment */
-      comment_char++;
-      /* conditions to end the comment */
-      if ((last_char == '*') && (new_char == '/'))
-      {
-        comment = FALSE;
-      }
+      Usage(argv[0]);
+      return (1);
+    }
+    partials = Input_List;
+    memset(&Input_List,0,sizeof(FILE_LIST));
+    status = open_partials(&Results_Log,&partials);
+    delete_file_list(&partials);
+    if (status != 0)
+    {
+      close_results_log(&Results_Log);
+      return (1);
+    }
+  }
+  if ((Input_List.count == 0) && (Git_Range == NULL) &&
+      (Compare_Old_Tree == NULL) && (Relex_Old_File == NULL))
+  {
+    Usage(argv[0]);
+    return (1);
+  }
+  if ((Shard_Count > 0) && (Shard_Member == NULL) && (select_shard() != 0))
+    return (1);
+  /* a shard resumed after its inputs changed size would not share them
+     out the way the other shards did */
+  if ((Results_Log.replay != NULL) && !Merge_Flag &&
+      ((Results_Log.shard_count != Shard_Count) ||
+       (Results_Log.shard_plan != Shard_Plan)))
+  {
+    printf("%s: the inputs were shared out differently by the stopped "
+      "run.\n",Results_File);
+    return (1);
+  }
+  if ((Store_File != NULL) && (open_store(&Store,Store_File) != 0))
+    return (1);
 
-      /* End of line */
-      if (new_char == '\n')
-      {
-        /* conditions to end the comment */
-        if (c_plus_plus_comment != FALSE)
-        {
-          c_plus_plus_comment = FALSE;
-          comment = FALSE;
-        }
-        /* count comment lines of code */
-        else
-        {
-          comment_loc++;
-        }
-      }
-      /* count the number of whitespace chars in the comment */
-      if (!(isspace(new_char)))
-        comment_nospace++;
-    } /* end of comment */
+  if (Debug_Flag)
+    debug_file_ptr = open_debug_file();
+  if (Perf_Flag)
+    perf_open();
 
-    /* QUOTES - skip until end of quotation */
-    else if (quotation != FALSE)
+  /* === COUNT CHANGED FUNCTIONS === */
+  if (Git_Range != NULL)
+    status = git_diff(Git_Range);
+  if (Compare_Old_Tree != NULL)
+    status |= compare_trees(Compare_Old_Tree,Compare_New_Tree);
+  if (Relex_Old_File != NULL)
+    status |= relex_files(Relex_Old_File,Relex_New_File);
+
+  /* the places of the functions of the inputs are only kept for the
+     reports and the log that need them */
+  Places_Flag = (Locations_File != NULL) || Clones_Flag ||
+    (Results_File != NULL);
+
+  /* every input is known before counting starts, so each directory
+     knows how many inputs it is waiting for */
+  if (Rollup_Flag)
+  {
+    for (file_index = 0; file_index < Input_List.count; file_index++)
     {
-      /* conditions to end the quotation */
-      if (control_code != FALSE)
-        control_code = FALSE;
-      else if (new_char == '\\')
-        control_code = TRUE;
-      else if (new_char == '"')
-        quotation = FALSE;
+      if (in_shard(file_index))
+        register_rollup(Input_List.names[file_index]);
     }
+    print_rollup_header();
+  }
 
-    /* SINGLE QUOTES - skip until end of quotes */
-    else if (single_quote != FALSE)
+  /* only a sample of the files is counted, then scaled up */
+  if (Sample_Size > 0.0)
+    sample_count = select_sample();
+
+  /* === COUNT LOGICAL LOC === */
+  for (file_index = 0; file_index < Input_List.count; file_index++)
+  {
+    Current_Input = file_index;
+    if ((Sample_Units != NULL) && !Sample_Units[file_index].selected)
+      continue;
+    if (!in_shard(file_index))
+      continue;
+    input_status = 0;
+    if ((Results_Log.replay != NULL) &&
+        (Results_Log.replay[file_index] != NULL))
+      input_status = replay_input(&Results_Log,file_index);
+    else if (Merge_Flag)
     {
-      /* conditions to end the quotation */
-      if (control_code != FALSE)
-        control_code = FALSE;
-      else if (new_char == '\\')
-        control_code = TRUE;
-      else if (new_char == '\'')
-        single_quote = FALSE;
+      printf("%s: not finished by any shard.\n",
+        Input_List.names[file_index]);
+      input_status = 1;
     }
-
-    /* PRE-COMPILER - skip until end of line but not \ eol */
-    else if (precompiler != FALSE)
+    else
     {
-      /* conditions to end the pre compile */
-
-      /* skip else or elif to endif on pre-compile */
-      if (precompiler_if && precompiler_else && precompiler_end)
-      {
-        /* is it an endif? */
-        if ((new_char != ' ') &&
-            (new_char != '\\') &&
-            (new_char != '\n'))
-        {
-          sprintf(token1,"%s%c",token,new_char);
-          strcpy(token,token1);
-        }
-        else
-        {
-          if (stricmp(token,"endif") == 0)
-          {
-            precompiler = FALSE;
-            precompiler_if = FALSE;
-            precompiler_else = FALSE;
-            precompiler_end = FALSE;
-          }
-          else
-            precompiler_end = FALSE;
-        }
-      }
-      else if (precompiler_if && precompiler_else)
+      if (archive_type(Input_List.names[file_index]) != ARCHIVE_NONE)
       {
-        /* look for Pre-compiler endif */
-        if (new_char == '#')
-        {
-          precompiler_end = TRUE;
-          token[0] = 0;
-        }
+        if (count_archive(Input_List.names[file_index]) != 0)
+          input_status = 1;
       }
-      else if (precompiler_if && (precompiler_else == FALSE))
-      {
-        if ((new_char != ' ') &&
-            (new_char != '\\') &&
-            (new_char != '\n'))
-        {
-          sprintf(token1,"%s%c",token,new_char);
-          strcpy(token,token1);
-        }
-        else
-        {
-          if ((stricmp(token,"else") == 0) ||
-              (stricmp(token,"elif") == 0))
-          {
-            precompiler_else = TRUE;
-          }
-          else
-          {
-            if (new_char == '\n')
-            {
-              precompiler = FALSE;
-              precompiler_if = FALSE;
-              precompiler_else = FALSE;
-              precompiler_end = FALSE;
-            }
-            else
-              precompiler_if = FALSE;
-          }
-        }
+      else if (count_file(Input_List.names[file_index]) != 0)
+        input_status = 1;
+      if (Results_File != NULL)
+        log_input_done(&Results_Log,file_index,input_status);
+    }
+    status |= input_status;
+    if (Rollup_Flag)
+      rollup_done(Input_List.names[file_index]);
+    /* a terminal shows each input as it is finished */
+    if (Output_Interactive)
+      fflush(stdout);
+  }
+  if (((Results_File != NULL) || Merge_Flag) &&
+      (close_results_log(&Results_Log) != 0))
+    status = 1;
+  if (Rollup_Flag)
+  {
+    /* only needed when nothing at all was counted */
+    if (Rollup_Root != NULL)
+      emit_rollup(Rollup_Root,FALSE);
+    delete_rollup(Rollup_Root);
+    Rollup_Root = NULL;
+  }
+  if (Perf_Flag)
+    perf_phase(PERF_OUTPUT);
+  if (Lines_Only_Flag && File_Report_Flag)
+    print_lines_total();
+  if (Sort_Key != SORT_NONE)
+    print_ranked_functions();
+  if (Histogram_Flag)
+    print_histograms();
+  if (Clones_Flag)
+    print_clones();
+  if (Sample_Units != NULL)
+  {
+    print_sample_estimates(sample_count);
+    mem_free(Sample_Units);
+    Sample_Units = NULL;
+  }
+  if (Perf_Flag)
+  {
+    perf_close();
+    print_perf_counters();
+  }
+  if ((Store_File != NULL) && (close_store(&Store) != 0))
+    status = 1;
+  if ((Locations_File != NULL) &&
+      (write_locations(&Locations,Locations_File) != 0))
+    status = 1;
+
+  if (debug_file_ptr != NULL)
+    fclose(debug_file_ptr);
+
+  /* House Keeping */
+  delete_fingerprints();
+  delete_places();
+  delete_file_list(&Input_List);
+  mem_free(Shard_Member);
+  Shard_Member = NULL;
+  delete_string_pool(&Name_Pool);
+  delete_keywords();
+  /* after the house keeping, so what is in use was not freed */
+  if (Mem_Stats_Flag)
+    print_mem_stats();
+
+  return status;
+}
+
+/**************************************************************************
+*
+* Function:    open_output
+*
+* Description: Gives stdout a large buffer, so that the results are
+*              written in a few large blocks instead of a line at a time
+*              and counting does not wait on a slow terminal or pipe.
+*              The output stays in the same order as the inputs.
+*
+* Parameters:  none
+*
+* Globals:     Output_Buffer, Output_Interactive
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void open_output(void)
+{
+#if defined(_WIN32) || defined(HAVE_POSIX)
+  Output_Interactive = isatty(fileno(stdout)) ? TRUE : FALSE;
+#endif
+  setvbuf(stdout,Output_Buffer,_IOFBF,sizeof(Output_Buffer));
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    count_file
+*
+* Description: Reads in a C program file, then counts and prints it.
+*
+* Parameters:  filename - string containing the name of the file to be
+*                         counted.
+*
+* Globals:     none
+*
+* Locals:      read_input_file, count_contents functions.
+*
+* Return:      0 if the file was counted, 1 if the file could not be read.
+*
+**************************************************************************/
+int count_file(char *filename)
+{
+  char *buffer;             /* contents of the file */
+  size_t length = 0;        /* number of bytes in buffer */
+
+  if (Perf_Flag)
+    perf_phase(PERF_READ);
+  buffer = read_input_file(filename,&length);
+  if (buffer == NULL)
+    return (1);
+
+  count_contents(filename,buffer,length,FALSE);
+  mem_free(buffer);
+
+  return (0);
+}
+
+/**************************************************************************
+*
+* Function:    count_contents
+*
+* Description: Counts the number of logical lines of code for C program
+*              text held in memory and each of its functions, and prints
+*              the results.  When deduplication is enabled, contents that
+*              were already counted are only reported as a reference to
+*              the first file.
+*
+* Parameters:  filename - name the contents are reported under.
+*              buffer - C program text to be counted.
+*              length - number of characters in buffer.
+*              member - TRUE if the contents can not be read again from
+*                  filename, as for an archive member.
+*
+* Globals:     Dedupe_Flag, Results_File
+*
+* Locals:      check_duplicate, log_file_results, report_contents
+*              functions.
+*
+* Return:      none
+*
+**************************************************************************/
+void count_contents(char *filename,char *buffer,size_t length,int member)
+{
+  FILE_COUNTS counts;       /* totals for the file */
+  unsigned long hash_a = 0; /* fingerprint of the contents */
+  unsigned long hash_b = 0;
+  int limit;                /* limit the file went over, if any */
+
+  if (Perf_Flag)
+  {
+    perf_phase(PERF_OTHER);
+    Perf.bytes += (unsigned long) length;
+  }
+
+  /* identical contents were counted before - only report a reference */
+  if (Dedupe_Flag)
+  {
+    fingerprint_contents(buffer,length,&hash_a,&hash_b);
+    if (check_duplicate(filename,buffer,hash_a,hash_b,length,member))
+    {
+      if (Results_File != NULL)
+        log_file_results(&Results_Log,filename,hash_a,hash_b,length,NULL,
+          LIMIT_NONE);
+      return;
+    }
+  }
+
+  if (Debug_Flag && (debug_file_ptr != NULL))
+    fprintf(debug_file_ptr,"Reading file: %s\n",filename);
+
+  if (Perf_Flag)
+    perf_phase(PERF_LEX);
+  set_dialect(filename);
+  limit = LIMIT_NONE;
+  if (Lines_Only_Flag)
+    count_lines_only(buffer,length,&counts);
+  else
+    limit = count_buffer(buffer,length,&counts);
+
+  if (Debug_Flag && (debug_file_ptr != NULL))
+    fprintf(debug_file_ptr,"%-32s %6lu\n","PROGRAM TOTAL",counts.loc_count);
+
+  if (Results_File != NULL)
+    log_file_results(&Results_Log,filename,hash_a,hash_b,length,&counts,
+      limit);
+  report_contents(filename,&counts,limit);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    check_duplicate
+*
+* Description: Looks up the fingerprint of some file contents, and if the
+*              same contents were counted before, reports the file as a
+*              reference to the first one.
+*
+* Parameters:  filename - name the contents are reported under.
+*              buffer - the contents, or NULL to read them from filename.
+*              hash_a, hash_b - fingerprint of the contents.
+*              length - number of characters in the contents.
+*              member - TRUE if the contents can not be read again from
+*                  filename, as for an archive member.
+*
+* Globals:     File_Report_Flag
+*
+* Locals:      find_fingerprint, print_duplicate functions.
+*
+* Return:      TRUE if the contents were counted before, FALSE if not.
+*
+**************************************************************************/
+int check_duplicate(char *filename,char *buffer,unsigned long hash_a,
+  unsigned long hash_b,size_t length,int member)
+{
+  FINGERPRINT *original;    /* earlier file with the same contents */
+  char *display_name;       /* copy of filename that printing can modify */
+
+  original = find_fingerprint(hash_a,hash_b,length,filename,buffer,member);
+  if (original == NULL)
+    return FALSE;
+
+  /* the summary reports count each function only once */
+  if (File_Report_Flag)
+  {
+    display_name = (char *) mem_alloc(MEM_PATHS,strlen(filename) + 1);
+    if (display_name == NULL)
+    {
+      printf("check_duplicate: malloc failed.\n");
+      exit(1);
+    }
+    strcpy(display_name,filename);
+    print_duplicate(display_name,original->filename);
+    mem_free(display_name);
+  }
+
+  return TRUE;
+}
+
+/**************************************************************************
+*
+* Function:    report_contents
+*
+* Description: Keeps the results of a file for the summary reports and
+*              prints them, then deletes its functions.
+*
+* Parameters:  filename - name the contents are reported under.
+*              counts - reference to the totals for the file.
+*              limit - limit the file went over, if any.
+*
+* Globals:     WKS_Flag, WKS_Header_Flag
+*
+* Locals:      head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void report_contents(char *filename,FILE_COUNTS *counts,int limit)
+{
+  char *display_name;       /* copy of filename that printing can modify */
+
+  display_name = (char *) mem_alloc(MEM_PATHS,strlen(filename) + 1);
+  if (display_name == NULL)
+  {
+    printf("report_contents: malloc failed.\n");
+    exit(1);
+  }
+  strcpy(display_name,filename);
+
+  /* Keep the results for the summary reports */
+  if (Perf_Flag)
+    perf_phase(PERF_COLLECT);
+  if (Sort_Key != SORT_NONE)
+    rank_functions(filename);
+  if (Histogram_Flag)
+    histogram_functions(filename);
+  if (Clones_Flag)
+    collect_clones(filename);
+  if (Rollup_Flag)
+    rollup_file(filename,counts);
+  if (Sample_Units != NULL)
+    sample_file(counts);
+  if ((Store_File != NULL) && (store_functions(&Store,filename) != 0))
+  {
+    printf("report_contents: malloc failed.\n");
+    exit(1);
+  }
+  if (Locations_File != NULL)
+    index_locations(&Locations,filename);
+
+  /* Print the results */
+  if (Perf_Flag)
+    perf_phase(PERF_OUTPUT);
+  if (!File_Report_Flag)
+  {
+    /* only the summary reports are printed */
+  }
+  else if (Lines_Only_Flag)
+  {
+    print_lines(display_name,counts,WKS_Header_Flag || !WKS_Flag);
+    WKS_Header_Flag = FALSE;
+  }
+  else if (WKS_Flag)
+  {
+    print_functions_wks(display_name,counts->loc_count,WKS_Header_Flag);
+    /* only the first file gets the header */
+    WKS_Header_Flag = FALSE;
+    if (limit != LIMIT_NONE)
+      printf(",(over %s - physical and comment LOC only),\n",
+        limit_name(limit));
+  }
+  else
+  {
+    print_functions(display_name,counts->loc_count,counts->physical_loc,
+      counts->comment_loc);
+    if (limit != LIMIT_NONE)
+      printf("%-12s over %s - only physical and comment LOC counted\n",
+        "Limited",limit_name(limit));
+  }
+
+  /* House Keeping */
+  if (Perf_Flag)
+    perf_phase(PERF_OTHER);
+  mem_free(display_name);
+  delete_elements();
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    init_lexer
+*
+* Description: Sets the lexer to the start of C program text, outside of
+*              any function.
+*
+* Parameters:  lexer - reference to the state of the lexer.
+*
+* Globals:     Function_State
+*
+* Locals:      reset_function_state function.
+*
+* Return:      none
+*
+**************************************************************************/
+void init_lexer(LEXER_STATE *lexer)
+{
+  lexer->index = 0;
+  lexer->last_char = 0;
+  lexer->token[0] = 0;
+  lexer->last_token[0] = 0;
+  lexer->comment = FALSE;
+  lexer->quotation = FALSE;
+  lexer->single_quote = FALSE;
+  lexer->precompiler = FALSE;
+  lexer->precompiler_end = FALSE;
+  lexer->precompiler_else = FALSE;
+  lexer->precompiler_if = FALSE;
+  lexer->control_code = FALSE;
+  lexer->c_plus_plus_comment = FALSE;
+  lexer->comment_nospace = 0;
+  lexer->comment_char = 0;
+  lexer->depth = 0;
+  lexer->limit = LIMIT_NONE;
+  lexer->deadline = 0.0;
+  lexer->counts.loc_count = 0;
+  lexer->counts.physical_loc = 0;
+  lexer->counts.comment_loc = 0;
+  lexer->tail = NULL;
+
+  /* each file starts outside of any function */
+  reset_function_state();
+  lexer->functions = Function_State;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    count_buffer
+*
+* Description: Counts the logical lines of code, physical lines of code
+*              and comment lines of code of C program text held in memory.
+*              Each function found is added to the linked list with its
+*              own count of logical lines of code.  Text that goes over
+*              one of the per-file limits - size, time, nesting depth or
+*              token length - is not lexed any further, and only its
+*              physical and comment lines of code are counted.
+*
+* Parameters:  buffer - C program text to be counted.
+*              length - number of characters in buffer.
+*              counts - reference to the totals for the buffer.
+*
+* Globals:     Limit_Bytes, Limit_Seconds
+*
+* Locals:      init_lexer, lex_buffer, count_lines_only, elapsed_seconds
+*              functions.
+*
+* Return:      the LIMIT_ that was reached, or LIMIT_NONE.
+*
+**************************************************************************/
+int count_buffer(char *buffer,size_t length,FILE_COUNTS *counts)
+{
+  LEXER_STATE lexer;      /* state of the lexer */
+
+  init_lexer(&lexer);
+  if ((Limit_Bytes > 0) && (length > Limit_Bytes))
+    lexer.limit = LIMIT_BYTES;
+  if (Limit_Seconds > 0.0)
+    lexer.deadline = elapsed_seconds() + Limit_Seconds;
+
+  (void) lex_buffer(&lexer,buffer,length,FALSE);
+  *counts = lexer.counts;
+
+  /* over a limit - what was found so far is thrown away, and only the
+     lines are counted, which can not be held up by any of the limits */
+  if (lexer.limit != LIMIT_NONE)
+  {
+    delete_elements();
+    reset_function_state();
+    count_lines_only(buffer,length,counts);
+    if (Debug_Flag && (debug_file_ptr != NULL))
+      fprintf(debug_file_ptr,"Over %s - only physical and comment LOC "
+        "counted\n",limit_name(lexer.limit));
+  }
+
+  return lexer.limit;
+}
+
+/**************************************************************************
+*
+* Function:    build_token
+*
+* Description: Adds a character to the word the lexer is building, and
+*              keeps where a word starts for the function locations.
+*
+* Parameters:  lexer - reference to the state of the lexer.
+*              new_char - the character.
+*              index - offset of the character in the text.
+*
+* Globals:     Limit_Token, Function_State
+*
+* Locals:      none
+*
+* Return:      TRUE if the word is too long to add to, FALSE if not.
+*
+**************************************************************************/
+int build_token(LEXER_STATE *lexer,char new_char,size_t index)
+{
+  char token[MAX_LINE_SIZE];
+
+  if (strlen(lexer->token) >= Limit_Token)
+    return (TRUE);
+  /* where a function name starts */
+  if (lexer->token[0] == 0)
+  {
+    Function_State.word_start = index;
+    Function_State.word_line = lexer->counts.physical_loc + 1;
+  }
+  sprintf(token,"%s%c",lexer->token,new_char);
+  strcpy(lexer->token,token);
+
+  return (FALSE);
+}
+
+/**************************************************************************
+*
+* Function:    lex_buffer
+*
+* Description: Lexes C program text held in memory, from where the lexer
+*              left off to the end of the text or to a per-file limit,
+*              counting its lines of code.  Each function found is added
+*              to the linked list with its own count of logical lines of
+*              code.  It can also stop just after each function that ends
+*              outside of any other, so that the state can be saved there
+*              and lexing picked up again later from that point.
+*
+* Parameters:  lexer - reference to the state of the lexer.
+*              buffer - C program text to be counted.
+*              length - number of characters in buffer.
+*              stop - TRUE to stop after each function.
+*
+* Globals:     Limit_Depth, Function_State, Dialect_Class, Dialect
+*
+* Locals:      check_token, build_token, elapsed_seconds functions.
+*
+* Return:      TRUE if it stopped after a function, FALSE at the end.
+*
+**************************************************************************/
+int lex_buffer(LEXER_STATE *lexer,char *buffer,size_t length,
+  unsigned char stop)
+{
+  size_t index;           /* index of the current char in the buffer */
+  char new_char;          /* the current char read in from file */
+  char token1[MAX_LINE_SIZE]; /* used for tokenizing characters */
+  char token2[MAX_LINE_SIZE];/* another word in a file. */
+  unsigned short token_len;  /* length of the token string */
+  unsigned char counting = FALSE; /* TRUE if inside a function body */
+  unsigned char *classes = Dialect_Class[Dialect];
+
+  token2[0] = 0;
+  token_len = 0;
+
+  /* read the buffer one character at a time */
+  for (index = lexer->index; (lexer->limit == LIMIT_NONE) && (index < length);
+       index++)
+  {
+    new_char = buffer[index];
+    if (stop)
+      counting = Function_State.count_flag;
+
+    /* the clock is only read now and then */
+    if ((lexer->deadline > 0.0) && ((index % LIMIT_CLOCK_INTERVAL) == 0) &&
+        (elapsed_seconds() > lexer->deadline))
+    {
+      lexer->limit = LIMIT_TIME;
+      break;
+    }
+
+    /* count physical lines of code */
+    if (new_char == '\n')
+      lexer->counts.physical_loc++;
+
+    /* COMMENT - skip until end of comment */
+    if (lexer->comment != FALSE)
+    {
+      /* count the number of characters in the comment */
+      lexer->comment_char++;
+      /* conditions to end the comment */
+      if ((lexer->last_char == '*') && (new_char == '/'))
+      {
+        lexer->comment = FALSE;
       }
-      else if ((last_char != '\\') && (new_char == '\n'))
+
+      /* End of line */
+      if (new_char == '\n')
       {
-        precompiler = FALSE;
-        precompiler_if = FALSE;
-        precompiler_else = FALSE;
-        precompiler_end = FALSE;
+        /* conditions to end the comment */
+        if (lexer->c_plus_plus_comment != FALSE)
+        {
+          lexer->c_plus_plus_comment = FALSE;
+          lexer->comment = FALSE;
+        }
+        /* count comment lines of code */
+        else
+        {
+          lexer->counts.comment_loc++;
+        }
       }
+      /* count the number of whitespace chars in the comment */
+      if (!(char_class(new_char) & CHAR_SPACE))
+        lexer->comment_nospace++;
+    } /* end of comment */
+
+    /* QUOTES - skip until end of quotation */
+    else if (lexer->quotation != FALSE)
+    {
+      /* conditions to end the quotation */
+      if (lexer->control_code != FALSE)
+        lexer->control_code = FALSE;
+      else if (new_char == '\\')
+        lexer->control_code = TRUE;
+      else if (new_char == '"')
+        lexer->quotation = FALSE;
+    }
+
+    /* SINGLE QUOTES - skip until end of quotes */
+    else if (lexer->single_quote != FALSE)
+    {
+      /* conditions to end the quotation */
+      if (lexer->control_code != FALSE)
+        lexer->control_code = FALSE;
+      else if (new_char == '\\')
+        lexer->control_code = TRUE;
+      else if (new_char == '\'')
+        lexer->single_quote = FALSE;
+    }
+
+    /* PRE-COMPILER - skip until end of line but not \ eol */
+    else if (lexer->precompiler != FALSE)
+    {
+      /* conditions to end the pre compile */
+
+      /* skip else or elif to endif on pre-compile */
+      if (lexer->precompiler_if && lexer->precompiler_else &&
+          lexer->precompiler_end)
+      {
+        /* is it an endif? */
+        if ((new_char != ' ') &&
+            (new_char != '\\') &&
+            (new_char != '\n'))
+        {
+          /* longer words can not be else, elif or endif anyway */
+          if (strlen(lexer->token) < (MAX_LINE_SIZE - 2))
+          {
+            sprintf(token1,"%s%c",lexer->token,new_char);
+            strcpy(lexer->token,token1);
+          }
+        }
+        else
+        {
+          if (stricmp(lexer->token,"endif") == 0)
+          {
+            lexer->precompiler = FALSE;
+            lexer->precompiler_if = FALSE;
+            lexer->precompiler_else = FALSE;
+            lexer->precompiler_end = FALSE;
+          }
+          else
+            lexer->precompiler_end = FALSE;
+        }
+      }
+      else if (lexer->precompiler_if && lexer->precompiler_else)
+      {
+        /* look for Pre-compiler endif */
+        if (new_char == '#')
+        {
+          lexer->precompiler_end = TRUE;
+          lexer->token[0] = 0;
+        }
+      }
+      else if (lexer->precompiler_if && (lexer->precompiler_else == FALSE))
+      {
+        if ((new_char != ' ') &&
+            (new_char != '\\') &&
+            (new_char != '\n'))
+        {
+          /* longer words can not be else, elif or endif anyway */
+          if (strlen(lexer->token) < (MAX_LINE_SIZE - 2))
+          {
+            sprintf(token1,"%s%c",lexer->token,new_char);
+            strcpy(lexer->token,token1);
+          }
+        }
+        else
+        {
+          if ((stricmp(lexer->token,"else") == 0) ||
+              (stricmp(lexer->token,"elif") == 0))
+          {
+            lexer->precompiler_else = TRUE;
+          }
+          else
+          {
+            if (new_char == '\n')
+            {
+              lexer->precompiler = FALSE;
+              lexer->precompiler_if = FALSE;
+              lexer->precompiler_else = FALSE;
+              lexer->precompiler_end = FALSE;
+            }
+            else
+              lexer->precompiler_if = FALSE;
+          }
+        }
+      }
+      else if ((lexer->last_char != '\\') && (new_char == '\n'))
+      {
+        lexer->precompiler = FALSE;
+        lexer->precompiler_if = FALSE;
+        lexer->precompiler_else = FALSE;
+        lexer->precompiler_end = FALSE;
+      }
+    }
+
+    else
+    {
+      /* Turn on Comment Flag */
+      if (((new_char == '*') ||
+           (classes[(unsigned char) new_char] & CHAR_LINE_COMMENT)) &&
+          (lexer->last_char == '/'))
+      {
+        if (new_char == '/')
+          lexer->c_plus_plus_comment = TRUE;
+        /* count comment lines of code */
+        lexer->counts.comment_loc++;
+        /* count the number of characters in the comment */
+        lexer->comment_char++;
+        lexer->comment_char++;
+        /* turn on flag to start looking for end of comment */
+        lexer->comment = TRUE;
+        /* the / was not code */
+        Function_State.slash = FALSE;
+        /* shrink token by 1 to remove / */
+        token_len = strlen(lexer->token);
+        /* check to see if tokens are countable */
+        switch(token_len)
+        {
+          case 0:
+            break;
+          case 1:
+            lexer->token[0] = 0;
+            break;
+          default:
+            lexer->token[token_len-1] = 0;
+            check_token(lexer->token,lexer->last_token,
+              &lexer->counts.loc_count,lexer->counts.physical_loc);
+            break;
+        }
+      }
+
+      /* Turn on Quotation Flag */
+      else if (new_char == '"')
+      {
+        lexer->quotation = TRUE;
+        check_token(lexer->token,lexer->last_token,
+          &lexer->counts.loc_count,lexer->counts.physical_loc);
+      }
+
+      /* Turn on Single Quotation Flag */
+      else if (new_char == '\'')
+      {
+        lexer->single_quote = TRUE;
+        check_token(lexer->token,lexer->last_token,
+          &lexer->counts.loc_count,lexer->counts.physical_loc);
+      }
+
+      /* Turn on Pre-compiler Flag */
+      else if (new_char == '#')
+      {
+        lexer->precompiler = TRUE;
+        lexer->precompiler_if = TRUE;
+        lexer->precompiler_else = FALSE;
+        lexer->precompiler_end = FALSE;
+        sprintf(token2,"%c",new_char);
+        check_token(token2,lexer->last_token,
+          &lexer->counts.loc_count,lexer->counts.physical_loc);
+        lexer->token[0] = 0;
+      }
+
+      /* Force token check - EOL */
+      else if (new_char == '\n')
+        check_token(lexer->token,lexer->last_token,
+          &lexer->counts.loc_count,lexer->counts.physical_loc);
+
+      /* Force token check - WHITE SPACE */
+      else if (char_class(new_char) & CHAR_SPACE)
+        check_token(lexer->token,lexer->last_token,
+          &lexer->counts.loc_count,lexer->counts.physical_loc);
+
+      /* Force token check - PUNCTUATION, but not _ and ~ (used in
+         c++ destructors), which are part of the token */
+      else if (classes[(unsigned char) new_char] & CHAR_DELIMITER)
+      {
+        if ((new_char == '{') || (new_char == '('))
+        {
+          lexer->depth++;
+          if ((Limit_Depth > 0) && (lexer->depth > Limit_Depth))
+          {
+            lexer->limit = LIMIT_DEPTH;
+            break;
+          }
+        }
+        else if (((new_char == '}') || (new_char == ')')) &&
+                 (lexer->depth > 0))
+          lexer->depth--;
+        check_token(lexer->token,lexer->last_token,
+          &lexer->counts.loc_count,lexer->counts.physical_loc);
+        /* where a function ends */
+        Function_State.position = index;
+        Function_State.line = lexer->counts.physical_loc + 1;
+        /* check punct to see if it is a countable token */
+        sprintf(token2,"%c",new_char);
+        check_token(token2,lexer->last_token,
+          &lexer->counts.loc_count,lexer->counts.physical_loc);
+      } /* end of token delimiter */
+      /* BUILD TOKEN */
+      else if (build_token(lexer,new_char,index))
+      {
+        lexer->limit = LIMIT_TOKEN;
+        break;
+      }
+    }
+
+    /* update any previous variables */
+    lexer->last_char = new_char;
+
+    /* a function just ended - a place to save or compare the state */
+    if (stop && counting && (new_char == '}') && !Function_State.count_flag)
+    {
+      lexer->index = index + 1;
+      lexer->functions = Function_State;
+      lexer->functions.temp_node = NULL;
+      /* the function that just ended is the last one in the list */
+      lexer->tail = Function_State.temp_node;
+      return TRUE;
+    }
+  }
+  lexer->index = index;
+
+
+  return FALSE;
+}
+
+/**************************************************************************
+*
+* Function:    save_checkpoint
+*
+* Description: Adds a copy of the state of the lexer to the end of a list
+*              of checkpoints.
+*
+* Parameters:  list - reference to the list of checkpoints.
+*              lexer - reference to the state of the lexer.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void save_checkpoint(CHECKPOINT_LIST *list,LEXER_STATE *lexer)
+{
+  LEXER_STATE *items;
+  size_t size;
+
+  if (list->count >= list->size)
+  {
+    size = (list->size == 0) ? 64 : (list->size * 2);
+    items = (LEXER_STATE *) mem_realloc(MEM_CACHES,list->items,
+      size * sizeof(LEXER_STATE));
+    if (items == NULL)
+    {
+      printf("save_checkpoint: malloc failed.\n");
+      exit(1);
+    }
+    list->items = items;
+    list->size = size;
+  }
+  list->items[list->count++] = *lexer;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    delete_checkpoints
+*
+* Description: De-allocates memory for a list of checkpoints.
+*
+* Parameters:  list - reference to the list of checkpoints.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_checkpoints(CHECKPOINT_LIST *list)
+{
+  mem_free(list->items);
+  list->items = NULL;
+  list->count = 0;
+  list->size = 0;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    count_checkpoints
+*
+* Description: Counts C program text held in memory like count_buffer,
+*              but saves the state of the lexer at the start and after
+*              each function, so that an edited copy of the text can be
+*              counted again by relex_buffer.  The per-file limits on
+*              size and time are not used here.
+*
+* Parameters:  buffer - C program text to be counted.
+*              length - number of characters in buffer.
+*              counts - reference to the totals for the buffer.
+*              list - reference to an empty list of checkpoints.
+*
+* Globals:     none
+*
+* Locals:      init_lexer, lex_buffer, save_checkpoint functions.
+*
+* Return:      the LIMIT_ that was reached, or LIMIT_NONE.
+*
+**************************************************************************/
+int count_checkpoints(char *buffer,size_t length,FILE_COUNTS *counts,
+  CHECKPOINT_LIST *list)
+{
+  LEXER_STATE lexer;      /* state of the lexer */
+
+  init_lexer(&lexer);
+  save_checkpoint(list,&lexer);
+  while (lex_buffer(&lexer,buffer,length,TRUE))
+    save_checkpoint(list,&lexer);
+  *counts = lexer.counts;
+
+  return lexer.limit;
+}
+
+/**************************************************************************
+*
+* Function:    same_lexer_state
+*
+* Description: Compares two checkpoints, without their position or their
+*              totals.  Lexing the same text from either one gives the
+*              same results from then on.
+*
+* Parameters:  a, b - references to the states to compare.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      TRUE if lexing goes on the same way from both.
+*
+**************************************************************************/
+int same_lexer_state(LEXER_STATE *a,LEXER_STATE *b)
+{
+  return ((a->last_char == b->last_char) &&
+          (a->comment == b->comment) &&
+          (a->quotation == b->quotation) &&
+          (a->single_quote == b->single_quote) &&
+          (a->precompiler == b->precompiler) &&
+          (a->precompiler_end == b->precompiler_end) &&
+          (a->precompiler_else == b->precompiler_else) &&
+          (a->precompiler_if == b->precompiler_if) &&
+          (a->control_code == b->control_code) &&
+          (a->c_plus_plus_comment == b->c_plus_plus_comment) &&
+          (a->depth == b->depth) &&
+          (a->limit == b->limit) &&
+          (a->functions.count_flag == b->functions.count_flag) &&
+          (a->functions.start_flag == b->functions.start_flag) &&
+          (a->functions.brace_count == b->functions.brace_count) &&
+          (a->functions.parenthesis_count ==
+           b->functions.parenthesis_count) &&
+          (strcmp(a->token,b->token) == 0) &&
+          (strcmp(a->last_token,b->last_token) == 0));
+}
+
+/**************************************************************************
+*
+* Function:    find_checkpoint
+*
+* Description: Binary search for the last checkpoint at or before a
+*              position in the text.
+*
+* Parameters:  list - reference to the list of checkpoints.
+*              first - first checkpoint to search.
+*              index - position in the text.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      number of the checkpoint - first if none is before index.
+*
+**************************************************************************/
+size_t find_checkpoint(CHECKPOINT_LIST *list,size_t first,size_t index)
+{
+  size_t low = first;
+  size_t high = list->count;
+  size_t middle;
+
+  /* the answer is below high */
+  while ((high - low) > 1)
+  {
+    middle = low + ((high - low) / 2);
+    if (list->items[middle].index <= index)
+      low = middle;
+    else
+      high = middle;
+  }
+
+  return low;
+}
+
+/**************************************************************************
+*
+* Function:    relex_buffer
+*
+* Description: Counts an edited copy of C program text again, using the
+*              checkpoints saved when the text before the edit was
+*              counted.  The edit is found from the text that is the same
+*              at the start and at the end of both copies.  Lexing picks
+*              up at the last checkpoint before the edit, and stops at
+*              the first checkpoint after the edit where the state is the
+*              same as it was before the edit; the functions and totals
+*              from there on are taken from before the edit.  So the work
+*              depends on the size of the edit, not the size of the text.
+*
+* Parameters:  old_buffer - C program text before the edit.
+*              old_length - number of characters in old_buffer.
+*              buffer - C program text after the edit.
+*              length - number of characters in buffer.
+*              counts - reference to the totals, before the edit on entry
+*                       and after the edit on return.
+*              list - reference to the checkpoints, before the edit on
+*                     entry and after the edit on return.
+*
+* Globals:     head - functions before the edit on entry and after the
+*                     edit on return.
+*              Function_State
+*
+* Locals:      lex_buffer, save_checkpoint, find_checkpoint,
+*              same_lexer_state, count_lines_only functions.
+*
+* Return:      number of characters that were lexed again.
+*
+**************************************************************************/
+size_t relex_buffer(char *old_buffer,size_t old_length,char *buffer,
+  size_t length,FILE_COUNTS *counts,CHECKPOINT_LIST *list)
+{
+  CHECKPOINT_LIST relexed = {NULL, 0, 0}; /* checkpoints after the edit */
+  LEXER_STATE lexer;      /* state of the lexer */
+  LEXER_STATE shifted;    /* checkpoint from before the edit, moved */
+  LEXER_STATE *old;       /* checkpoint from before the edit */
+  ELEMENT *rest;          /* functions after the resume point */
+  ELEMENT *next;
+  size_t prefix = 0;      /* characters the same at the start */
+  size_t suffix = 0;      /* characters the same at the end */
+  size_t resume;          /* checkpoint that lexing picks up from */
+  size_t match;           /* checkpoint from before the edit */
+  size_t index;
+  int same = FALSE;       /* TRUE once the state is the same again */
+
+  while ((prefix < old_length) && (prefix < length) &&
+         (old_buffer[prefix] == buffer[prefix]))
+    prefix++;
+  while (((suffix + prefix) < old_length) && ((suffix + prefix) < length) &&
+         (old_buffer[old_length - suffix - 1] == buffer[length - suffix - 1]))
+    suffix++;
+
+  /* pick up from the last checkpoint before the edit */
+  resume = find_checkpoint(list,0,prefix);
+  lexer = list->items[resume];
+  Function_State = lexer.functions;
+  Function_State.temp_node = lexer.tail;
+  for (index = 0; index <= resume; index++)
+    save_checkpoint(&relexed,&list->items[index]);
+
+  /* the functions after it are found again */
+  if (lexer.tail != NULL)
+  {
+    rest = lexer.tail->next;
+    lexer.tail->next = NULL;
+  }
+  else
+  {
+    rest = head;
+    head = NULL;
+  }
+
+  while (!same && lex_buffer(&lexer,buffer,length,TRUE))
+  {
+    save_checkpoint(&relexed,&lexer);
+    if (lexer.index < (length - suffix))
+      continue;
+
+    /* past the edit - was the state the same here before the edit? */
+    index = lexer.index - length + old_length;
+    match = find_checkpoint(list,resume,index);
+    old = &list->items[match];
+    if ((old->index != index) || !same_lexer_state(old,&lexer))
+      continue;
+    same = TRUE;
+
+    /* keep the functions after it, and their checkpoints */
+    if (match > resume)
+    {
+      while (rest != old->tail)
+      {
+        next = rest->next;
+        mem_free(rest);
+        rest = next;
+      }
+      next = rest->next;
+      mem_free(rest);
+      rest = next;
+    }
+    lexer.tail->next = rest;
+    rest = NULL;
+    for (match++; match < list->count; match++)
+    {
+      shifted = list->items[match];
+      shifted.index = shifted.index - old_length + length;
+      shift_counts(&shifted.counts,&old->counts,&lexer.counts);
+      save_checkpoint(&relexed,&shifted);
+    }
+    shift_counts(counts,&old->counts,&lexer.counts);
+  }
+  if (!same)
+  {
+    delete_list(rest);
+    *counts = lexer.counts;
+  }
+  /* over a limit - only the physical and comment LOC, as in
+     count_buffer */
+  if (lexer.limit != LIMIT_NONE)
+  {
+    delete_elements();
+    count_lines_only(buffer,length,counts);
+  }
+
+  delete_checkpoints(list);
+  *list = relexed;
+
+  return lexer.index - list->items[resume].index;
+}
+
+/**************************************************************************
+*
+* Function:    shift_counts
+*
+* Description: Moves totals that were counted up to a point before an edit
+*              to the same point after the edit.
+*
+* Parameters:  counts - reference to the totals to move.
+*              before - reference to the totals at the point before it.
+*              after - reference to the totals at the point after it.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void shift_counts(FILE_COUNTS *counts,FILE_COUNTS *before,FILE_COUNTS *after)
+{
+  counts->loc_count = counts->loc_count - before->loc_count +
+    after->loc_count;
+  counts->physical_loc = counts->physical_loc - before->physical_loc +
+    after->physical_loc;
+  counts->comment_loc = counts->comment_loc - before->comment_loc +
+    after->comment_loc;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    relex_files
+*
+* Description: Counts a file, then counts an edited copy of it again from
+*              the checkpoints of the first count, and prints the results
+*              for the edited copy along with how much of it was lexed
+*              again.  This is what an editor would do on each change.
+*
+* Parameters:  old_file - name of the file before the edit.
+*              new_file - name of the file after the edit.
+*
+* Globals:     WKS_Flag, WKS_Header_Flag, Perf_Flag
+*
+* Locals:      count_checkpoints, relex_buffer, perf_phase functions.
+*
+* Return:      0 if both files were read, 1 if not.
+*
+**************************************************************************/
+int relex_files(char *old_file,char *new_file)
+{
+  CHECKPOINT_LIST list = {NULL, 0, 0};
+  FILE_COUNTS counts;       /* totals for the file */
+  char *old_buffer;
+  char *buffer;
+  char *display_name;       /* copy of new_file that printing can modify */
+  size_t old_length = 0;
+  size_t length = 0;
+  size_t relexed;           /* characters that were lexed again */
+  int limit;
+
+  if (Perf_Flag)
+    perf_phase(PERF_READ);
+  old_buffer = read_input_file(old_file,&old_length);
+  if (old_buffer == NULL)
+    return (1);
+  buffer = read_input_file(new_file,&length);
+  if (buffer == NULL)
+  {
+    mem_free(old_buffer);
+    return (1);
+  }
+
+  if (Perf_Flag)
+  {
+    perf_phase(PERF_LEX);
+    Perf.bytes += (unsigned long) (old_length + length);
+  }
+  set_dialect(new_file);
+  limit = count_checkpoints(old_buffer,old_length,&counts,&list);
+  if (limit != LIMIT_NONE)
+  {
+    /* nothing to pick up from - just count the edited copy */
+    delete_elements();
+    delete_checkpoints(&list);
+    count_contents(new_file,buffer,length,FALSE);
+    mem_free(old_buffer);
+    mem_free(buffer);
+    return (0);
+  }
+  relexed = relex_buffer(old_buffer,old_length,buffer,length,&counts,&list);
+
+  if (Perf_Flag)
+    perf_phase(PERF_OUTPUT);
+  display_name = (char *) mem_alloc(MEM_PATHS,strlen(new_file) + 1);
+  if (display_name == NULL)
+  {
+    printf("relex_files: malloc failed.\n");
+    exit(1);
+  }
+  strcpy(display_name,new_file);
+  if (WKS_Flag)
+  {
+    print_functions_wks(display_name,counts.loc_count,WKS_Header_Flag);
+    WKS_Header_Flag = FALSE;
+  }
+  else
+  {
+    print_functions(display_name,counts.loc_count,counts.physical_loc,
+      counts.comment_loc);
+    printf("%-12s %lu of %lu characters lexed again\n","Relexed",
+      (unsigned long) relexed,(unsigned long) length);
+  }
+
+  if (Perf_Flag)
+    perf_phase(PERF_OTHER);
+  mem_free(display_name);
+  delete_elements();
+  delete_checkpoints(&list);
+  mem_free(old_buffer);
+  mem_free(buffer);
+
+  return (0);
+}
+
+/**************************************************************************
+*
+* Function:    perf_open
+*
+* Description: Starts the hardware counters for --perf-counters.  Each
+*              event is opened on its own, so an event the processor or
+*              the virtual machine does not have only leaves a gap in the
+*              report.  If no event can be opened, as in many containers,
+*              only the processor time of each phase is reported.  The
+*              kernel is counted too where that is allowed, since reading
+*              the files is mostly done by the kernel; otherwise only the
+*              work done by this program itself is counted, and the
+*              report says so.
+*
+* Parameters:  none
+*
+* Globals:     Perf
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void perf_open(void)
+{
+#if defined(HAVE_PERF_EVENTS)
+  static unsigned long events[PERF_EVENTS] =
+  {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_MISSES
+  };
+  struct perf_event_attr attr;
+  int opened = 0;
+#endif
+  int event;
+  int phase;
+
+  for (event = 0; event < PERF_EVENTS; event++)
+  {
+    Perf.fd[event] = -1;
+    Perf.counted[event] = FALSE;
+    Perf.last[event] = 0.0;
+    for (phase = 0; phase < PERF_PHASES; phase++)
+      Perf.totals[phase][event] = 0.0;
+  }
+  for (phase = 0; phase < PERF_PHASES; phase++)
+    Perf.seconds[phase] = 0.0;
+  Perf.phase = PERF_OTHER;
+  Perf.bytes = 0;
+  Perf.error = NULL;
+  Perf.user_only = FALSE;
+
+#if defined(HAVE_PERF_EVENTS)
+  for (event = 0; event < PERF_EVENTS; event++)
+  {
+    memset(&attr,0,sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = events[event];
+    attr.exclude_hv = 1;
+    Perf.fd[event] = (int) syscall(__NR_perf_event_open,&attr,0,-1,-1,0);
+    if (Perf.fd[event] < 0)
+    {
+      /* only this program - allowed without privileges */
+      attr.exclude_kernel = 1;
+      Perf.fd[event] = (int) syscall(__NR_perf_event_open,&attr,0,-1,-1,0);
+      if (Perf.fd[event] >= 0)
+        Perf.user_only = TRUE;
+    }
+    if (Perf.fd[event] >= 0)
+    {
+      opened++;
+      Perf.counted[event] = TRUE;
+      Perf.last[event] = perf_read(event);
+    }
+  }
+  if (opened == 0)
+    Perf.error = "the hardware counters can not be opened here";
+#else
+  Perf.error = "there are no hardware counters on this platform";
+#endif
+  Perf.last_clock = clock();
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    perf_read
+*
+* Description: Reads one hardware counter.
+*
+* Parameters:  event - one of the PERF_ events.
+*
+* Globals:     Perf
+*
+* Locals:      none
+*
+* Return:      value of the counter, or 0 if it is not open.
+*
+**************************************************************************/
+double perf_read(int event)
+{
+#if defined(HAVE_PERF_EVENTS)
+  unsigned long long value = 0;
+
+  if ((Perf.fd[event] >= 0) &&
+      (read(Perf.fd[event],&value,sizeof(value)) == (ssize_t) sizeof(value)))
+    return (double) value;
+#else
+  (void) event;
+#endif
+
+  return 0.0;
+}
+
+/**************************************************************************
+*
+* Function:    perf_phase
+*
+* Description: Ends the phase being measured, adding what was counted
+*              since it started to its totals, and starts another one.
+*
+* Parameters:  phase - one of the PERF_ phases.
+*
+* Globals:     Perf
+*
+* Locals:      perf_read function.
+*
+* Return:      none
+*
+**************************************************************************/
+void perf_phase(int phase)
+{
+  clock_t now;
+  double value;
+  int event;
+
+  if (phase == Perf.phase)
+    return;
+  for (event = 0; event < PERF_EVENTS; event++)
+  {
+    if (Perf.fd[event] < 0)
+      continue;
+    value = perf_read(event);
+    Perf.totals[Perf.phase][event] += value - Perf.last[event];
+    Perf.last[event] = value;
+  }
+  now = clock();
+  Perf.seconds[Perf.phase] += (double) (now - Perf.last_clock) /
+    (double) CLOCKS_PER_SEC;
+  Perf.last_clock = now;
+  Perf.phase = phase;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    perf_close
+*
+* Description: Ends the last phase and stops the hardware counters.
+*
+* Parameters:  none
+*
+* Globals:     Perf
+*
+* Locals:      perf_phase function.
+*
+* Return:      none
+*
+**************************************************************************/
+void perf_close(void)
+{
+  int event;
+
+  /* a phase that is never used, so the last one is always added */
+  perf_phase(PERF_PHASES);
+  for (event = 0; event < PERF_EVENTS; event++)
+  {
+#if defined(HAVE_PERF_EVENTS)
+    if (Perf.fd[event] >= 0)
+      close(Perf.fd[event]);
+#endif
+    Perf.fd[event] = -1;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_perf_counters
+*
+* Description: Prints the processor time, instructions per cycle, and the
+*              branch and cache misses per kilobyte of input, of each
+*              phase.
+*
+* Parameters:  none
+*
+* Globals:     Perf, WKS_Flag, WKS_Summary_Header_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_perf_counters(void)
+{
+  static char *names[PERF_PHASES + 1] =
+  {
+    "other", "read", "lex", "collect", "output", "total"
+  };
+  double totals[PERF_PHASES + 1][PERF_EVENTS];
+  double seconds[PERF_PHASES + 1];
+  double kilobytes;
+  double *values;
+  char cycles[24];
+  char instructions[24];
+  char ipc[16];
+  char branch[16];
+  char cache[16];
+  int phase;
+  int event;
+
+  for (event = 0; event < PERF_EVENTS; event++)
+    totals[PERF_PHASES][event] = 0.0;
+  seconds[PERF_PHASES] = 0.0;
+  for (phase = 0; phase < PERF_PHASES; phase++)
+  {
+    for (event = 0; event < PERF_EVENTS; event++)
+    {
+      totals[phase][event] = Perf.totals[phase][event];
+      totals[PERF_PHASES][event] += Perf.totals[phase][event];
+    }
+    seconds[phase] = Perf.seconds[phase];
+    seconds[PERF_PHASES] += Perf.seconds[phase];
+  }
+  kilobytes = (double) Perf.bytes / 1024.0;
+
+  if (WKS_Flag)
+  {
+    if (WKS_Summary_Header_Flag)
+      printf("Phase,Seconds,Cycles,Instructions,IPC,Branch Misses/KB,"
+             "Cache Misses/KB\n");
+  }
+  else
+  {
+    if (Perf.error != NULL)
+      printf("Only processor time - %s.\n",Perf.error);
+    else if (Perf.user_only)
+      printf("User mode only - the kernel, which does most of the read"
+        " phase, is not counted here.\n");
+    printf("Phase    Seconds        Cycles  Instructions   IPC"
+           " Branch Misses/KB Cache Misses/KB\n");
+    printf("======= ======== ============= ============= ====="
+           " ================ ===============\n");
+  }
+  for (phase = 0; phase <= PERF_PHASES; phase++)
+  {
+    values = totals[phase];
+    /* events that could not be opened are left blank */
+    strcpy(cycles,"-");
+    strcpy(instructions,"-");
+    strcpy(ipc,"-");
+    strcpy(branch,"-");
+    strcpy(cache,"-");
+    if (Perf.counted[PERF_CYCLES])
+      sprintf(cycles,"%.0f",values[PERF_CYCLES]);
+    if (Perf.counted[PERF_INSTRUCTIONS])
+      sprintf(instructions,"%.0f",values[PERF_INSTRUCTIONS]);
+    if (Perf.counted[PERF_CYCLES] && Perf.counted[PERF_INSTRUCTIONS] &&
+        (values[PERF_CYCLES] > 0.0))
+      sprintf(ipc,"%.2f",values[PERF_INSTRUCTIONS] / values[PERF_CYCLES]);
+    if (Perf.counted[PERF_BRANCH_MISSES] && (kilobytes > 0.0))
+      sprintf(branch,"%.1f",values[PERF_BRANCH_MISSES] / kilobytes);
+    if (Perf.counted[PERF_CACHE_MISSES] && (kilobytes > 0.0))
+      sprintf(cache,"%.1f",values[PERF_CACHE_MISSES] / kilobytes);
+    if (WKS_Flag)
+      printf("%s,%.3f,%s,%s,%s,%s,%s\n",names[phase],seconds[phase],
+        cycles,instructions,ipc,branch,cache);
+    else
+    {
+      if (phase == PERF_PHASES)
+        printf("======= ======== ============= ============= ====="
+               " ================ ===============\n");
+      printf("%-7s %8.3f %13s %13s %5s %16s %15s\n",names[phase],
+        seconds[phase],cycles,instructions,ipc,branch,cache);
+    }
+  }
+  if (!WKS_Flag)
+    printf("Input   %lu bytes\n",Perf.bytes);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    elapsed_seconds
+*
+* Description: Reads a clock of the time that has passed, for --max-time,
+*              so that a file that keeps the lexer waiting - on a slow
+*              disk or a busy machine - is limited as well as one that
+*              keeps it busy.  A monotonic clock is used where there is
+*              one, so that the clock being set does not matter; other
+*              systems have the calendar time, to the second.
+*
+* Parameters:  none
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      seconds since some fixed time.
+*
+**************************************************************************/
+double elapsed_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec now;
+
+  if (clock_gettime(CLOCK_MONOTONIC,&now) == 0)
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1.0e9);
+#endif
+
+  return (double) time(NULL);
+}
+
+/**************************************************************************
+*
+* Function:    limit_name
+*
+* Description: Names a per-file limit by its command line option.
+*
+* Parameters:  limit - one of the LIMIT_ values.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      name of the option.
+*
+**************************************************************************/
+char *limit_name(int limit)
+{
+  switch (limit)
+  {
+    case LIMIT_BYTES:
+      return "--max-bytes";
+    case LIMIT_TIME:
+      return "--max-time";
+    case LIMIT_DEPTH:
+      return "--max-depth";
+    case LIMIT_TOKEN:
+      return "--max-token";
+    default:
+      break;
+  }
+
+  return "no limit";
+}
+
+/**************************************************************************
+*
+* Function:    init_line_stops
+*
+* Description: Fills in the characters that the --lines-only scanner has
+*              to look at in each of its states.  Every other character
+*              is skipped without looking at it any further.
+*
+* Parameters:  none
+*
+* Globals:     Line_Stops, Line_Stops_Ready
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void init_line_stops(void)
+{
+  int state;
+  int c;
+
+  for (state = 0; state < LINES_STATES; state++)
+  {
+    for (c = 0; c < 256; c++)
+      Line_Stops[state][c] = FALSE;
+    /* every state counts the physical lines */
+    Line_Stops[state]['\n'] = TRUE;
+  }
+  Line_Stops[LINES_CODE]['/'] = TRUE;
+  Line_Stops[LINES_CODE]['*'] = TRUE;
+  Line_Stops[LINES_CODE]['"'] = TRUE;
+  Line_Stops[LINES_CODE]['\''] = TRUE;
+  Line_Stops[LINES_CODE]['#'] = TRUE;
+  Line_Stops[LINES_COMMENT]['/'] = TRUE;
+  Line_Stops[LINES_QUOTE]['\\'] = TRUE;
+  Line_Stops[LINES_QUOTE]['"'] = TRUE;
+  Line_Stops[LINES_SINGLE_QUOTE]['\\'] = TRUE;
+  Line_Stops[LINES_SINGLE_QUOTE]['\''] = TRUE;
+  Line_Stops[LINES_PRECOMPILER_ELSE]['#'] = TRUE;
+  /* words are built one character at a time */
+  for (c = 0; c < 256; c++)
+  {
+    Line_Stops[LINES_PRECOMPILER_IF][c] = TRUE;
+    Line_Stops[LINES_PRECOMPILER_END][c] = TRUE;
+  }
+  Line_Stops_Ready = TRUE;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    count_lines_only
+*
+* Description: Counts only the physical lines of code and comment lines
+*              of code of C program text held in memory, for --lines-only.
+*              It follows the comments, quotes and pre-compiler lines
+*              - including the skipped else to endif - the same way that
+*              count_buffer does, so the counts are the same, but it has
+*              no tokens, keywords or functions, and in each state it
+*              skips over every character that can not change the state.
+*
+* Parameters:  buffer - C program text to be counted.
+*              length - number of characters in buffer.
+*              counts - reference to the totals for the buffer.
+*
+* Globals:     Line_Stops, Dialect_Class, Dialect
+*
+* Locals:      init_line_stops function.
+*
+* Return:      none
+*
+**************************************************************************/
+void count_lines_only(char *buffer,size_t length,FILE_COUNTS *counts)
+{
+  unsigned char *text = (unsigned char *) buffer;
+  unsigned char *stops;     /* characters that matter in this state */
+  unsigned char new_char;   /* the current char */
+  unsigned char last_char;  /* the previous char */
+  unsigned char c_plus_plus_comment = FALSE;
+  unsigned char *classes = Dialect_Class[Dialect];
+  char word[8];             /* pre-compiler word, if it is short */
+  size_t word_len = 0;
+  size_t index = 0;
+  int state = LINES_CODE;
+
+  if (!Line_Stops_Ready)
+    init_line_stops();
+  counts->loc_count = 0;
+  counts->physical_loc = 0;
+  counts->comment_loc = 0;
+  word[0] = 0;
+
+  while (index < length)
+  {
+    /* skip the characters that can not change the state */
+    stops = Line_Stops[state];
+    while ((index < length) && !stops[text[index]])
+      index++;
+    if (index >= length)
+      break;
+
+    new_char = text[index];
+    last_char = (index > 0) ? text[index - 1] : 0;
+    if (new_char == '\n')
+      counts->physical_loc++;
+
+    switch (state)
+    {
+      case LINES_CODE:
+        if (((new_char == '*') || (classes[new_char] & CHAR_LINE_COMMENT)) &&
+            (last_char == '/'))
+        {
+          if (new_char == '/')
+            c_plus_plus_comment = TRUE;
+          counts->comment_loc++;
+          state = LINES_COMMENT;
+        }
+        else if (new_char == '"')
+          state = LINES_QUOTE;
+        else if (new_char == '\'')
+          state = LINES_SINGLE_QUOTE;
+        else if (new_char == '#')
+        {
+          word_len = 0;
+          word[0] = 0;
+          state = LINES_PRECOMPILER_IF;
+        }
+        break;
+      case LINES_COMMENT:
+        if ((last_char == '*') && (new_char == '/'))
+          state = LINES_CODE;
+        else if (new_char == '\n')
+        {
+          if (c_plus_plus_comment)
+          {
+            c_plus_plus_comment = FALSE;
+            state = LINES_CODE;
+          }
+          else
+            counts->comment_loc++;
+        }
+        break;
+      case LINES_QUOTE:
+      case LINES_SINGLE_QUOTE:
+        if (new_char == '\\')
+        {
+          /* the next character is taken as it is */
+          index++;
+          if ((index < length) && (text[index] == '\n'))
+            counts->physical_loc++;
+        }
+        else if (new_char != '\n')
+          state = LINES_CODE;
+        break;
+      case LINES_PRECOMPILER_IF:
+      case LINES_PRECOMPILER_END:
+        if ((new_char != ' ') && (new_char != '\\') && (new_char != '\n'))
+        {
+          /* longer words can not be else, elif or endif */
+          if (word_len < (sizeof(word) - 1))
+          {
+            word[word_len++] = (char) new_char;
+            word[word_len] = 0;
+          }
+          else
+            word_len = sizeof(word);
+        }
+        else if (state == LINES_PRECOMPILER_END)
+        {
+          if ((word_len < sizeof(word)) && (stricmp(word,"endif") == 0))
+            state = LINES_CODE;
+          else
+            state = LINES_PRECOMPILER_ELSE;
+        }
+        else if ((word_len < sizeof(word)) &&
+                 ((stricmp(word,"else") == 0) || (stricmp(word,"elif") == 0)))
+          state = LINES_PRECOMPILER_ELSE;
+        else if (new_char == '\n')
+          state = LINES_CODE;
+        else
+          state = LINES_PRECOMPILER;
+        break;
+      case LINES_PRECOMPILER_ELSE:
+        if (new_char == '#')
+        {
+          word_len = 0;
+          word[0] = 0;
+          state = LINES_PRECOMPILER_END;
+        }
+        break;
+      case LINES_PRECOMPILER:
+        if (last_char != '\\')
+          state = LINES_CODE;
+        break;
+      default:
+        break;
+    }
+    index++;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_lines
+*
+* Description: Prints the physical and comment lines of code of one file
+*              for --lines-only, and adds them to the totals.
+*
+* Parameters:  filename - name of the file.
+*              counts - reference to the totals for the file.
+*              header - TRUE to print the column headings first.
+*
+* Globals:     WKS_Flag, Lines_Total, Lines_Files
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_lines(char *filename,FILE_COUNTS *counts,unsigned char header)
+{
+  static unsigned char header_done = FALSE;
+
+  if (WKS_Flag)
+  {
+    if (header)
+      printf("Program Name,Physical LOC,Comment LOC\n");
+    printf("%s,%lu,%lu\n",filename,counts->physical_loc,counts->comment_loc);
+  }
+  else
+  {
+    /* one table for all of the files */
+    if (header && !header_done)
+    {
+      printf("Program Name                                  Physical  Comment\n");
+      printf("                                              LOC       LOC\n");
+      printf("============================================= ======== ========\n");
+      header_done = TRUE;
+    }
+    printf("%-45s %8lu %8lu\n",filename,counts->physical_loc,
+      counts->comment_loc);
+  }
+  Lines_Total.physical_loc += counts->physical_loc;
+  Lines_Total.comment_loc += counts->comment_loc;
+  Lines_Files++;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_lines_total
+*
+* Description: Prints the totals of all of the files for --lines-only.
+*
+* Parameters:  none
+*
+* Globals:     WKS_Flag, Lines_Total, Lines_Files
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_lines_total(void)
+{
+  if (WKS_Flag || (Lines_Files < 2))
+    return;
+
+  printf("============================================= ======== ========\n");
+  printf("TOTAL        %-32lu %8lu %8lu\n",(unsigned long) Lines_Files,
+    Lines_Total.physical_loc,Lines_Total.comment_loc);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    mem_alloc
+*
+* Description: Allocates memory like malloc, and accounts for it to one
+*              part of the program.  Memory from mem_alloc, mem_calloc
+*              and mem_realloc is freed with mem_free.
+*
+* Parameters:  subsystem - one of the MEM_ values.
+*              size - number of bytes.
+*
+* Globals:     none
+*
+* Locals:      mem_account function.
+*
+* Return:      the memory, or NULL if there is not enough.
+*
+**************************************************************************/
+void *mem_alloc(int subsystem,size_t size)
+{
+  MEM_HEADER *header;
+
+  header = (MEM_HEADER *) malloc(sizeof(MEM_HEADER) + size);
+  if (header == NULL)
+    return NULL;
+  header->info.size = size;
+  header->info.subsystem = subsystem;
+  mem_account(subsystem,0,size);
+
+  return (void *) (header + 1);
+}
+
+/**************************************************************************
+*
+* Function:    mem_calloc
+*
+* Description: Allocates memory that is set to zero, like calloc, and
+*              accounts for it to one part of the program.
+*
+* Parameters:  subsystem - one of the MEM_ values.
+*              count - number of items.
+*              size - number of bytes in each item.
+*
+* Globals:     none
+*
+* Locals:      mem_alloc function.
+*
+* Return:      the memory, or NULL if there is not enough.
+*
+**************************************************************************/
+void *mem_calloc(int subsystem,size_t count,size_t size)
+{
+  void *memory;
+
+  if ((size != 0) && (count > (((size_t) -1) - sizeof(MEM_HEADER)) / size))
+    return NULL;
+  memory = mem_alloc(subsystem,count * size);
+  if (memory != NULL)
+    memset(memory,0,count * size);
+
+  return memory;
+}
+
+/**************************************************************************
+*
+* Function:    mem_realloc
+*
+* Description: Changes the size of memory like realloc, and accounts for
+*              the change.  A NULL memory is allocated.
+*
+* Parameters:  subsystem - one of the MEM_ values, for NULL memory.
+*              memory - memory from mem_alloc, or NULL.
+*              size - new number of bytes.
+*
+* Globals:     none
+*
+* Locals:      mem_alloc, mem_account functions.
+*
+* Return:      the memory, or NULL if there is not enough, in which case
+*              the memory that was passed in is left as it was.
+*
+**************************************************************************/
+void *mem_realloc(int subsystem,void *memory,size_t size)
+{
+  MEM_HEADER *header;
+  MEM_HEADER *larger;
+  size_t old_size;
+
+  if (memory == NULL)
+    return mem_alloc(subsystem,size);
+  header = ((MEM_HEADER *) memory) - 1;
+  old_size = header->info.size;
+  larger = (MEM_HEADER *) realloc(header,sizeof(MEM_HEADER) + size);
+  if (larger == NULL)
+    return NULL;
+  larger->info.size = size;
+  mem_account(larger->info.subsystem,old_size,size);
+
+  return (void *) (larger + 1);
+}
+
+/**************************************************************************
+*
+* Function:    mem_free
+*
+* Description: Frees memory from mem_alloc, mem_calloc or mem_realloc, and
+*              accounts for it.  NULL is ignored, like free.
+*
+* Parameters:  memory - memory to free, or NULL.
+*
+* Globals:     none
+*
+* Locals:      mem_account function.
+*
+* Return:      none
+*
+**************************************************************************/
+void mem_free(void *memory)
+{
+  MEM_HEADER *header;
+
+  if (memory == NULL)
+    return;
+  header = ((MEM_HEADER *) memory) - 1;
+  mem_account(header->info.subsystem,header->info.size,0);
+  free(header);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    mem_account
+*
+* Description: Adds a change in the size of an allocation to the memory
+*              accounting of its subsystem and of the whole program.  A
+*              new allocation has an old size of 0.
+*
+* Parameters:  subsystem - one of the MEM_ values.
+*              old_size - bytes before the change.
+*              new_size - bytes after the change.
+*
+* Globals:     Mem_Stats
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void mem_account(int subsystem,size_t old_size,size_t new_size)
+{
+  MEM_STATS *stats;
+  int pass;
+
+  for (pass = 0; pass < 2; pass++)
+  {
+    stats = &Mem_Stats[(pass == 0) ? subsystem : MEM_SUBSYSTEMS];
+    if (new_size > old_size)
+    {
+      if (old_size == 0)
+        stats->allocations++;
+      stats->allocated += (double) (new_size - old_size);
+    }
+    stats->in_use = stats->in_use - old_size + new_size;
+    if (stats->in_use > stats->peak)
+      stats->peak = stats->in_use;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    bench_kernel
+*
+* Description: Runs one of the inner routines of the counter once over
+*              its fixed input, for --microbench.
+*
+* Parameters:  kernel - one of the BENCH_ kernels.
+*              text - copies of Bench_Source, for the lexer.
+*              length - number of characters in text.
+*              bytes - reference to where the characters looked at are
+*                      returned.
+*
+* Globals:     Bench_Tokens, Bench_Function, Bench_Source
+*
+* Locals:      keyword_compare, function_name_compare, build_token,
+*              check_for_function, count_buffer functions.
+*
+* Return:      number of operations: tokens, or characters.
+*
+**************************************************************************/
+size_t bench_kernel(int kernel,char *text,size_t length,size_t *bytes)
+{
+  LEXER_STATE lexer;
+  FILE_COUNTS counts;
+  char prev_token[MAX_LINE_SIZE];
+  size_t ops = 0;
+  size_t index;
+  int found = 0;            /* so the calls are not thrown away */
+
+  *bytes = 0;
+  switch (kernel)
+  {
+    case BENCH_KEYWORDS:
+    case BENCH_NAMES:
+      for (index = 0; Bench_Tokens[index] != NULL; index++)
+      {
+        if (kernel == BENCH_KEYWORDS)
+          found += keyword_compare(Bench_Tokens[index]);
+        else
+          found += function_name_compare(Bench_Tokens[index]);
+        *bytes += strlen(Bench_Tokens[index]);
+        ops++;
+      }
+      break;
+    case BENCH_TOKENS:
+      init_lexer(&lexer);
+      for (index = 0; Bench_Source[index] != 0; index++)
+      {
+        if (char_class(Bench_Source[index]) & (CHAR_SPACE|CHAR_DELIMITER))
+          lexer.token[0] = 0;
+        else
+          found += build_token(&lexer,Bench_Source[index],index);
+      }
+      ops = index;
+      *bytes = index;
+      break;
+    case BENCH_FUNCTIONS:
+      reset_function_state();
+      prev_token[0] = 0;
+      for (index = 0; Bench_Function[index] != NULL; index++)
+      {
+        check_for_function(Bench_Function[index],prev_token);
+        strcpy(prev_token,Bench_Function[index]);
+        *bytes += strlen(Bench_Function[index]);
+        ops++;
+      }
+      delete_elements();
+      reset_function_state();
+      break;
+    case BENCH_LEXER:
+      found += count_buffer(text,length,&counts);
+      delete_elements();
+      reset_function_state();
+      ops = length;
+      *bytes = length;
+      break;
+    default:
+      break;
+  }
+  Bench_Found += found;
+
+  return ops;
+}
+
+/**************************************************************************
+*
+* Function:    run_microbench
+*
+* Description: Times each of the inner routines of the counter on its
+*              own, for --microbench, so that a change that slows one of
+*              them down is not hidden in the time of a whole run.  Each
+*              kernel is warmed up and run until it takes long enough to
+*              time, then timed a few more times and the fastest is kept.
+*              The times are compared with a baseline file, which is
+*              written if there is none.
+*
+* Parameters:  filename - name of the baseline file.
+*
+* Globals:     Bench_Names, Bench_Source
+*
+* Locals:      bench_kernel function.
+*
+* Return:      0 if the kernels were timed, 1 if not.
+*
+**************************************************************************/
+int run_microbench(char *filename)
+{
+  double baseline[BENCH_KERNELS];
+  double ns_per_op[BENCH_KERNELS];
+  double seconds;
+  double best;
+  char name[MAX_LINE_SIZE];
+  char *text;
+  size_t source_length = strlen(Bench_Source);
+  size_t length;
+  size_t ops = 0;
+  size_t bytes = 0;
+  unsigned long runs;
+  unsigned long run;
+  clock_t start;
+  int kernel;
+  int repeat;
+  int have_baseline = FALSE;
+  FILE *fp;
+
+  /* the lexer gets a text large enough to be past the start up costs */
+  length = source_length * BENCH_SOURCE_COPIES;
+  text = (char *) mem_alloc(MEM_BUFFERS,length + 1);
+  if (text == NULL)
+  {
+    printf("run_microbench: malloc failed.\n");
+    return (1);
+  }
+  for (repeat = 0; repeat < BENCH_SOURCE_COPIES; repeat++)
+    memcpy(text + (repeat * source_length),Bench_Source,source_length);
+  text[length] = 0;
+
+  for (kernel = 0; kernel < BENCH_KERNELS; kernel++)
+    baseline[kernel] = 0.0;
+  fp = fopen(filename,"r");
+  if (fp != NULL)
+  {
+    while (fscanf(fp,"%254s %lf",name,&best) == 2)
+    {
+      for (kernel = 0; kernel < BENCH_KERNELS; kernel++)
+      {
+        if (strcmp(name,Bench_Names[kernel]) == 0)
+          baseline[kernel] = best;
+      }
+    }
+    fclose(fp);
+    have_baseline = TRUE;
+  }
+
+  printf("Kernel                   ns/op      MB/s  Baseline  Change\n");
+  printf("===================== ======== ========= ========= =======\n");
+  for (kernel = 0; kernel < BENCH_KERNELS; kernel++)
+  {
+    /* warm up, and find how many runs take long enough to time */
+    for (runs = 1; ; runs *= 2)
+    {
+      start = clock();
+      for (run = 0; run < runs; run++)
+        ops = bench_kernel(kernel,text,length,&bytes);
+      seconds = (double) (clock() - start) / (double) CLOCKS_PER_SEC;
+      if (seconds >= BENCH_SECONDS)
+        break;
+    }
+    best = seconds;
+    for (repeat = 0; repeat < BENCH_REPEATS; repeat++)
+    {
+      start = clock();
+      for (run = 0; run < runs; run++)
+        ops = bench_kernel(kernel,text,length,&bytes);
+      seconds = (double) (clock() - start) / (double) CLOCKS_PER_SEC;
+      if (seconds < best)
+        best = seconds;
+    }
+    best /= (double) runs;
+    ns_per_op[kernel] = (best * 1.0e9) / (double) ops;
+    printf("%-21s %8.2f %9.2f",Bench_Names[kernel],ns_per_op[kernel],
+      ((double) bytes / best) / 1.0e6);
+    if (baseline[kernel] > 0.0)
+      printf(" %9.2f %+6.1f%%\n",baseline[kernel],
+        ((ns_per_op[kernel] - baseline[kernel]) * 100.0) / baseline[kernel]);
+    else
+      printf(" %9s %7s\n","-","-");
+  }
+  mem_free(text);
+
+  if (!have_baseline)
+  {
+    fp = fopen(filename,"w");
+    if (fp == NULL)
+    {
+      printf("run_microbench: error writing %s.\n",filename);
+      return (1);
+    }
+    for (kernel = 0; kernel < BENCH_KERNELS; kernel++)
+      fprintf(fp,"%s %.3f\n",Bench_Names[kernel],ns_per_op[kernel]);
+    fclose(fp);
+    printf("Saved as the baseline in %s\n",filename);
+  }
+
+  return (0);
+}
+
+/**************************************************************************
+*
+* Function:    print_mem_stats
+*
+* Description: Prints the allocations of each part of the program, the
+*              most memory each had in use at once, what is still in use,
+*              and the peak resident set size of the process.
+*
+* Parameters:  none
+*
+* Globals:     Mem_Stats, WKS_Flag, WKS_Summary_Header_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_mem_stats(void)
+{
+  static char *names[MEM_SUBSYSTEMS + 1] =
+  {
+    "function records", "function names", "I/O buffers", "caches",
+    "file names", "total"
+  };
+  long peak_rss = -1;       /* kilobytes, -1 if not known */
+#if defined(HAVE_POSIX)
+  struct rusage usage;
+#endif
+  int subsystem;
+
+#if defined(HAVE_POSIX)
+  if (getrusage(RUSAGE_SELF,&usage) == 0)
+  {
+    peak_rss = (long) usage.ru_maxrss;
+#if defined(__APPLE__)
+    /* bytes on macOS, kilobytes everywhere else */
+    peak_rss /= 1024;
+#endif
+  }
+#endif
+
+  if (WKS_Flag)
+  {
+    if (WKS_Summary_Header_Flag)
+      printf("Memory,Allocations,Bytes,Peak Bytes,In Use\n");
+  }
+  else
+  {
+    printf("Memory           Allocations            Bytes      Peak Bytes"
+           "      In Use\n");
+    printf("================ =========== ================ ==============="
+           " ===========\n");
+  }
+  for (subsystem = 0; subsystem <= MEM_SUBSYSTEMS; subsystem++)
+  {
+    if (WKS_Flag)
+      printf("%s,%lu,%.0f,%lu,%lu\n",names[subsystem],
+        Mem_Stats[subsystem].allocations,Mem_Stats[subsystem].allocated,
+        (unsigned long) Mem_Stats[subsystem].peak,
+        (unsigned long) Mem_Stats[subsystem].in_use);
+    else
+    {
+      if (subsystem == MEM_SUBSYSTEMS)
+        printf("================ =========== ================"
+               " =============== ===========\n");
+      printf("%-16s %11lu %16.0f %15lu %11lu\n",names[subsystem],
+        Mem_Stats[subsystem].allocations,Mem_Stats[subsystem].allocated,
+        (unsigned long) Mem_Stats[subsystem].peak,
+        (unsigned long) Mem_Stats[subsystem].in_use);
+    }
+  }
+  if (WKS_Flag)
+    printf("peak RSS KB,%ld,,,\n",peak_rss);
+  else if (peak_rss >= 0)
+    printf("Peak RSS %ld KB\n",peak_rss);
+  else
+    printf("Peak RSS is not known on this platform\n");
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    create_list_element
+*
+* Description: Allocates memory for a linked list element and returns
+*              a pointer to that memory.
+*
+* Parameters:  none
+*
+* Globals:     none
+*
+* Locals:      typedef of ELEMENT.
+*
+* Return:      p - pointer to the memory allocated for that element.
+*
+**************************************************************************/
+ELEMENT *create_list_element(void)
+{
+  ELEMENT *p;
+
+  p = (ELEMENT *) mem_alloc(MEM_FUNCTIONS,sizeof(ELEMENT));
+  if (p==NULL)
+  {
+    printf("create_list_element: malloc failed.\n");
+    exit(1);
+  }
+  p->name = NULL;
+  p->loc_count = 0;
+  p->next = NULL;
+
+  return p;
+} /* end of function */
+
+/**************************************************************************
+*
+* Function:    hash_bytes
+*
+* Description: Continues an FNV-1a hash over some characters.
+*
+* Parameters:  hash - hash so far, or 2166136261 to start a new hash.
+*              data - reference to the characters.
+*              length - number of characters.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      the new hash.
+*
+**************************************************************************/
+unsigned long hash_bytes(unsigned long hash,char *data,size_t length)
+{
+  size_t index;
+
+  for (index = 0; index < length; index++)
+    hash = ((hash ^ (unsigned char) data[index]) * 16777619UL) & 0xFFFFFFFFUL;
+
+  return hash;
+}
+
+/**************************************************************************
+*
+* Function:    intern_string
+*
+* Description: Finds a string in a string pool, adding it if it is not
+*              there yet.  The strings are packed end to end in large
+*              blocks, and found again with an open addressing hash set,
+*              so every copy of the same string is the same pointer.
+*
+* Parameters:  pool - reference to the string pool.
+*              string - reference to the string to be found.
+*
+* Globals:     none
+*
+* Locals:      hash_bytes function.
+*
+* Return:      the pooled copy of the string, which lasts until
+*              delete_string_pool.
+*
+**************************************************************************/
+char *intern_string(STRING_POOL *pool,char *string)
+{
+  POOL_BLOCK *block;
+  char **slots;
+  unsigned long *hashes;
+  unsigned long hash;
+  size_t length;
+  size_t slot_count;
+  size_t block_size;
+  size_t slot;
+  size_t index;
+  char *copy;
+
+  length = strlen(string);
+  hash = hash_bytes(2166136261UL,string,length);
+
+  if (pool->slot_count > 0)
+  {
+    slot = hash & (pool->slot_count - 1);
+    while (pool->slots[slot] != NULL)
+    {
+      if ((pool->hashes[slot] == hash) &&
+          (strcmp(pool->slots[slot],string) == 0))
+        return pool->slots[slot];
+      slot = (slot + 1) & (pool->slot_count - 1);
+    }
+  }
+
+  /* keep the hash set no more than half full */
+  if (((pool->count + 1) * 2) > pool->slot_count)
+  {
+    slot_count = (pool->slot_count == 0) ? 1024 : (pool->slot_count * 2);
+    slots = (char **) mem_calloc(MEM_NAMES,slot_count,sizeof(char *));
+    hashes = (unsigned long *) mem_calloc(MEM_NAMES,slot_count,
+      sizeof(unsigned long));
+    if ((slots == NULL) || (hashes == NULL))
+    {
+      printf("intern_string: malloc failed.\n");
+      exit(1);
+    }
+    for (index = 0; index < pool->slot_count; index++)
+    {
+      if (pool->slots[index] == NULL)
+        continue;
+      slot = pool->hashes[index] & (slot_count - 1);
+      while (slots[slot] != NULL)
+        slot = (slot + 1) & (slot_count - 1);
+      slots[slot] = pool->slots[index];
+      hashes[slot] = pool->hashes[index];
+    }
+    mem_free(pool->slots);
+    mem_free(pool->hashes);
+    pool->slots = slots;
+    pool->hashes = hashes;
+    pool->slot_count = slot_count;
+  }
+
+  block = pool->blocks;
+  if ((block == NULL) || ((block->size - block->used) < (length + 1)))
+  {
+    block_size = ((length + 1) > POOL_BLOCK_SIZE) ? (length + 1) :
+      POOL_BLOCK_SIZE;
+    block = (POOL_BLOCK *) mem_alloc(MEM_NAMES,
+      sizeof(POOL_BLOCK) + block_size);
+    if (block == NULL)
+    {
+      printf("intern_string: malloc failed.\n");
+      exit(1);
+    }
+    block->used = 0;
+    block->size = block_size;
+    block->next = pool->blocks;
+    pool->blocks = block;
+  }
+  /* the characters follow the block header */
+  copy = (char *) (block + 1) + block->used;
+  memcpy(copy,string,length + 1);
+  block->used += length + 1;
+
+  slot = hash & (pool->slot_count - 1);
+  while (pool->slots[slot] != NULL)
+    slot = (slot + 1) & (pool->slot_count - 1);
+  pool->slots[slot] = copy;
+  pool->hashes[slot] = hash;
+  pool->count++;
+
+  return copy;
+}
+
+/**************************************************************************
+*
+* Function:    delete_string_pool
+*
+* Description: De-allocates memory for all of the strings in a pool.
+*
+* Parameters:  pool - reference to the string pool.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_string_pool(STRING_POOL *pool)
+{
+  POOL_BLOCK *current;
+  POOL_BLOCK *next;
+
+  for (current = pool->blocks; current != NULL; current = next)
+  {
+    next = current->next;
+    mem_free(current);
+  }
+  mem_free(pool->slots);
+  mem_free(pool->hashes);
+  pool->blocks = NULL;
+  pool->slots = NULL;
+  pool->hashes = NULL;
+  pool->slot_count = 0;
+  pool->count = 0;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    add_element
+*
+* Description: Attaches an ELEMENT to the tail end of the linked list
+*              by attaching it to the first ELEMENT that is NULL.
+*              
+* Parameters:  e - reference of ELEMENT e.
+*
+* Globals:     none
+*
+* Locals:      typedef of ELEMENT
+*              head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void add_element(ELEMENT *e)
+{
+  ELEMENT *p;
+
+  /* if the first element has not been created, create it now */
+  if (head == NULL)
+  {
+    head = e;
+    return;
+  }
+
+  /* otherwise, find the last element in the list */
+  for (p=head;p->next != NULL;p=p->next) {}
+
+  p->next = e;
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    delete_elements
+*
+* Description: De-allocates memory for all linked list elements starting with
+*              head.
+*
+* Parameters:  none
+*
+* Globals:     none
+*
+* Locals:      typedef of ELEMENT
+*              head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_elements(void)
+{
+  delete_list(head);
+  head = NULL;
+  Places.count = 0;
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    delete_list
+*
+* Description: De-allocates memory for all linked list elements starting with
+*              the given element.  Used for lists that were taken from head.
+*
+* Parameters:  list - first ELEMENT of the linked list
+*
+* Globals:     none
+*
+* Locals:      typedef of ELEMENT
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_list(ELEMENT *list)
+{
+  ELEMENT *current;
+  ELEMENT *next;
+
+  current = list;
+  while(current != NULL)
+  {
+    next = current->next;
+    mem_free(current);
+    current = next;
+  }
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    add_place
+*
+* Description: Adds the place of the function just added to head, when
+*              Places is kept.
+*
+* Parameters:  none
+*
+* Globals:     Places
+*
+* Locals:      larger - Places.items grown.
+*
+* Return:      index of the place in Places.
+*
+**************************************************************************/
+size_t add_place(void)
+{
+  FUNCTION_PLACE *larger;
+  FUNCTION_PLACE *place;
+
+  if (Places.count == Places.size)
+  {
+    Places.size = (Places.size == 0) ? 64 : (Places.size * 2);
+    larger = (FUNCTION_PLACE *) mem_realloc(MEM_FUNCTIONS,Places.items,
+      Places.size * sizeof(FUNCTION_PLACE));
+    if (larger == NULL)
+    {
+      printf("add_place: malloc failed.\n");
+      exit(1);
+    }
+    Places.items = larger;
+  }
+  place = &Places.items[Places.count];
+  place->start = 0;
+  place->end = 0;
+  place->first_line = 0;
+  place->last_line = 0;
+  place->clone_a = 2166136261UL;  /* FNV-1a offset basis */
+  place->clone_b = 5381UL;
+  place->tokens = 0;
+
+  return Places.count++;
+}
+
+/**************************************************************************
+*
+* Function:    delete_places
+*
+* Description: De-allocates the places of the functions.
+*
+* Parameters:  none
+*
+* Globals:     Places
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_places(void)
+{
+  mem_free(Places.items);
+  Places.items = NULL;
+  Places.count = 0;
+  Places.size = 0;
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_functions_wks
+*
+* Description: Prints all linked list elements starting with head.
+*
+* Parameters:  filename (IN) name of file
+*              loc (IN) total logicial lines of code in file.
+*
+* Globals:     none
+*
+* Locals:      typedef of ELEMENT
+*              head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void print_functions_wks(char *filename,COUNTER loc,unsigned char header)
+{
+  ELEMENT *current = NULL;
+  char *str = NULL;
+  char *name = NULL;
+
+  /* Find the last token - that is the actual filename */
+  str = strtok(filename,":\\");
+  while (str != NULL)
+  {
+    name = str;
+    str = strtok(NULL,":\\");
+  }
+
+  if (header)
+    printf("Program Name,Function Name,Function LOC,Total LOC\n");
+  if (name != NULL)
+    printf("%s,,,%lu\n",name,loc);
+  else
+    printf("\n");
+
+  current = head;
+
+  while(current != NULL)
+  {
+    if (current->loc_count > 0)
+    {
+      printf(",%s,%lu\n",current->name,current->loc_count);
+    }
+    current = current->next;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_functions
+*
+* Description: Prints all linked list elements starting with head.
+*
+* Parameters:  none
+*
+* Globals:     none
+*
+* Locals:      typedef of ELEMENT
+*              head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void print_functions(char *filename,COUNTER loc,COUNTER ploc,COUNTER cloc)
+{
+  ELEMENT *current = NULL;
+  COUNTER floc = 0; /* function line of code */
+  char *str = NULL;
+  char *name = NULL;
+  COUNTER methods = 0;
+
+  /* Find the last token - that is the actual filename */
+  str = strtok(filename,":\\");
+  while (str != NULL)
+  {
+    name = str;
+    str = strtok(NULL,":\\");
+  }
+
+  printf("Program      Function                         Function Total\n");
+  printf("Name         Name                             LOC      LOC\n");
+  printf("============ ================================ ======== ========\n");
+  if (name != NULL)
+    printf("%s\n",name);
+  else
+    printf("\n");
+
+  current = head;
+  floc = 0;
+
+  while(current != NULL)
+  {
+    if (current->loc_count > 0)
+    {
+      printf("%-12s %-32s %8lu\n"," ",current->name,current->loc_count);
+      floc += current->loc_count;
+      methods++;
+    }
+    current = current->next;
+  }
+
+  printf("                                              --------         \n");
+  printf("TOTAL        %-8lu                         %8lu %8lu",
+    methods,floc,loc);
+  printf("\n");
+  printf("============ ================================ ======== ========\n");
+  printf("%-12s %-32s %-8s %8lu\n","Physical LOC"," "," ",ploc);
+  printf("%-12s %-32s %-8s %8lu\n","Comment LOC"," "," ",cloc);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_diff_header
+*
+* Description: Prints the column headings for a change in function size.
+*
+* Parameters:  none
+*
+* Globals:     WKS_Flag, WKS_Header_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_diff_header(void)
+{
+  if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Program Name,Function Name,Old LOC,New LOC,Delta LOC\n");
+  }
+  else
+  {
+    printf("Program      Function                         Old      New"
+           "      Delta\n");
+    printf("Name         Name                             LOC      LOC"
+           "      LOC\n");
+    printf("============ ================================ ======== ========"
+           " ========\n");
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_diff_line
+*
+* Description: Prints the change in size of one function, or the change
+*              in the total of one file when function is NULL.
+*
+* Parameters:  filename (IN) name of the file
+*              function (IN) name of the function, or NULL for the file
+*              old_loc (IN) logical lines of code before the change
+*              new_loc (IN) logical lines of code after the change
+*
+* Globals:     WKS_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_diff_line(char *filename,char *function,COUNTER old_loc,
+  COUNTER new_loc)
+{
+  long delta = (long) new_loc - (long) old_loc;
+
+  if (WKS_Flag)
+  {
+    if (function == NULL)
+      printf("%s,,%lu,%lu,%ld\n",filename,old_loc,new_loc,delta);
+    else
+      printf(",%s,%lu,%lu,%ld\n",function,old_loc,new_loc,delta);
+  }
+  else
+  {
+    if (function == NULL)
+    {
+      printf("                                              --------"
+             " -------- --------\n");
+      printf("TOTAL        %-32s %8lu %8lu %+8ld\n"," ",old_loc,new_loc,delta);
+    }
+    else
+      printf("%-12s %-32s %8lu %8lu %+8ld\n"," ",function,old_loc,new_loc,
+        delta);
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_function_diff
+*
+* Description: Matches the functions of two versions of a file by name and
+*              prints each function that was added, removed or changed
+*              size, largest growth first, followed by the change in the
+*              file total.
+*
+* Parameters:  filename (IN) name of the file
+*              old_list (IN) functions before the change
+*              new_list (IN) functions after the change
+*              old_loc (IN) file logical lines of code before the change
+*              new_loc (IN) file logical lines of code after the change
+*
+* Globals:     WKS_Flag
+*
+* Locals:      match_build, match_probe, sort_matches functions.
+*
+* Return:      none
+*
+**************************************************************************/
+void print_function_diff(char *filename,ELEMENT *old_list,ELEMENT *new_list,
+  COUNTER old_loc,COUNTER new_loc)
+{
+  MATCH_TABLE table;          /* functions of both versions */
+  FUNCTION_MATCH **changes;   /* functions that changed, sorted */
+  size_t count = 0;
+  size_t index;
+
+  table.buckets = NULL;
+  table.bucket_count = 0;
+  table.count = 0;
+  match_build(&table,filename,old_list);
+  match_probe(&table,filename,new_list);
+  changes = sort_matches(&table,&count);
+
+  if (!WKS_Flag)
+    printf("%s\n",filename);
+  else
+    print_diff_line(filename,NULL,old_loc,new_loc);
+
+  for (index = 0; index < count; index++)
+    print_diff_line(filename,changes[index]->name,changes[index]->old_loc,
+      changes[index]->new_loc);
+
+  if (!WKS_Flag)
+    print_diff_line(filename,NULL,old_loc,new_loc);
+
+  mem_free(changes);
+  delete_matches(&table);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_compare_line
+*
+* Description: Prints one function that was added, removed or resized
+*              between two source trees.
+*
+* Parameters:  change (IN) "added", "removed" or "resized"
+*              function (IN) name of the function
+*              old_loc (IN) logical lines of code in the old tree
+*              new_loc (IN) logical lines of code in the new tree
+*              filename (IN) file relative to the tree
+*
+* Globals:     WKS_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_compare_line(char *change,char *function,COUNTER old_loc,
+  COUNTER new_loc,char *filename)
+{
+  long delta = (long) new_loc - (long) old_loc;
+
+  if (WKS_Flag)
+    printf("%s,%s,%lu,%lu,%ld,%s\n",change,function,old_loc,new_loc,delta,
+      filename);
+  else
+    printf("%-8s %-32s %8lu %8lu %+8ld %s\n",change,function,old_loc,
+      new_loc,delta,filename);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    rank_less
+*
+* Description: Orders two functions for the min-heap of --top.  The
+*              smaller function is less, and of two functions of the same
+*              size the one found later is less, so it is dropped first.
+*
+* Parameters:  a, b - references to the functions.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      TRUE if a ranks below b, FALSE if not.
+*
+**************************************************************************/
+int rank_less(RANKED_FUNCTION *a,RANKED_FUNCTION *b)
+{
+  if (a->loc_count != b->loc_count)
+    return (a->loc_count < b->loc_count);
+
+  return (a->order > b->order);
+}
+
+/**************************************************************************
+*
+* Function:    rank_sift_down
+*
+* Description: Moves a function down the min-heap until both children
+*              rank above it.
+*
+* Parameters:  list - reference to the heap.
+*              index - position of the function to move.
+*
+* Globals:     none
+*
+* Locals:      rank_less function.
+*
+* Return:      none
+*
+**************************************************************************/
+void rank_sift_down(RANK_LIST *list,size_t index)
+{
+  RANKED_FUNCTION temp;
+  size_t child;
+
+  for (;;)
+  {
+    child = (index * 2) + 1;
+    if (child >= list->count)
+      break;
+    if (((child + 1) < list->count) &&
+        rank_less(&list->items[child + 1],&list->items[child]))
+      child++;
+    if (!rank_less(&list->items[child],&list->items[index]))
+      break;
+    temp = list->items[index];
+    list->items[index] = list->items[child];
+    list->items[child] = temp;
+    index = child;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    rank_sift_up
+*
+* Description: Moves a function up the min-heap until its parent ranks
+*              below it.
+*
+* Parameters:  list - reference to the heap.
+*              index - position of the function to move.
+*
+* Globals:     none
+*
+* Locals:      rank_less function.
+*
+* Return:      none
+*
+**************************************************************************/
+void rank_sift_up(RANK_LIST *list,size_t index)
+{
+  RANKED_FUNCTION temp;
+  size_t parent;
+
+  while (index > 0)
+  {
+    parent = (index - 1) / 2;
+    if (!rank_less(&list->items[index],&list->items[parent]))
+      break;
+    temp = list->items[index];
+    list->items[index] = list->items[parent];
+    list->items[parent] = temp;
+    index = parent;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    rank_functions
+*
+* Description: Offers each function of the file just counted to the
+*              ranked report.  With --top N only the N largest functions
+*              are kept, in a min-heap whose root is the smallest of them,
+*              so each function costs one compare unless it displaces the
+*              root.  Otherwise every function is kept for sorting.
+*
+* Parameters:  filename - name of the file that was counted.
+*
+* Globals:     Rank_List, Rank_Files, Top_Count
+*
+* Locals:      head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void rank_functions(char *filename)
+{
+  ELEMENT *current;
+  RANKED_FUNCTION candidate;
+  RANKED_FUNCTION *larger;
+  size_t file_index;
+
+  /* the filename is saved once, when the first function is kept */
+  file_index = Rank_Files.count;
+
+  for (current = head; current != NULL; current = current->next)
+  {
+    if (current->loc_count == 0)
+      continue;
+
+    candidate.loc_count = current->loc_count;
+    candidate.order = Rank_List.found++;
+    if ((Top_Count > 0) && (Rank_List.count >= Top_Count))
+    {
+      /* full - only a function larger than the smallest kept gets in */
+      if (!rank_less(&Rank_List.items[0],&candidate))
+        continue;
+    }
+
+    if (file_index == Rank_Files.count)
+      add_file_name(&Rank_Files,filename);
+    candidate.filename = Rank_Files.names[file_index];
+    candidate.name = current->name;
+
+    if ((Top_Count > 0) && (Rank_List.count >= Top_Count))
+    {
+      Rank_List.items[0] = candidate;
+      rank_sift_down(&Rank_List,0);
+      continue;
+    }
+
+    if (Rank_List.count == Rank_List.size)
+    {
+      Rank_List.size = (Rank_List.size == 0) ? 256 : (Rank_List.size * 2);
+      if ((Top_Count > 0) && (Rank_List.size > Top_Count))
+        Rank_List.size = Top_Count;
+      larger = (RANKED_FUNCTION *) mem_realloc(MEM_FUNCTIONS,Rank_List.items,
+        Rank_List.size * sizeof(RANKED_FUNCTION));
+      if (larger == NULL)
+      {
+        printf("rank_functions: malloc failed.\n");
+        exit(1);
+      }
+      Rank_List.items = larger;
+    }
+    Rank_List.items[Rank_List.count] = candidate;
+    Rank_List.count++;
+    if (Top_Count > 0)
+      rank_sift_up(&Rank_List,Rank_List.count - 1);
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    compare_ranked_loc
+*
+* Description: qsort comparison putting the largest functions first, and
+*              functions of the same size in the order they were found.
+*
+* Parameters:  a, b - references to RANKED_FUNCTION.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      less than, equal to, or greater than zero.
+*
+**************************************************************************/
+int compare_ranked_loc(const void *a,const void *b)
+{
+  const RANKED_FUNCTION *rank_a = (const RANKED_FUNCTION *) a;
+  const RANKED_FUNCTION *rank_b = (const RANKED_FUNCTION *) b;
+
+  if (rank_a->loc_count != rank_b->loc_count)
+    return (rank_a->loc_count > rank_b->loc_count) ? -1 : 1;
+  if (rank_a->order != rank_b->order)
+    return (rank_a->order < rank_b->order) ? -1 : 1;
+
+  return 0;
+}
+
+/**************************************************************************
+*
+* Function:    compare_ranked_name
+*
+* Description: qsort comparison by function name, then by size.
+*
+* Parameters:  a, b - references to RANKED_FUNCTION.
+*
+* Globals:     none
+*
+* Locals:      compare_ranked_loc function.
+*
+* Return:      less than, equal to, or greater than zero.
+*
+**************************************************************************/
+int compare_ranked_name(const void *a,const void *b)
+{
+  int status;
+
+  status = strcmp(((const RANKED_FUNCTION *) a)->name,
+    ((const RANKED_FUNCTION *) b)->name);
+  if (status == 0)
+    status = compare_ranked_loc(a,b);
+
+  return status;
+}
+
+/**************************************************************************
+*
+* Function:    compare_ranked_file
+*
+* Description: qsort comparison by filename, then in the order the
+*              functions appear in the file.
+*
+* Parameters:  a, b - references to RANKED_FUNCTION.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      less than, equal to, or greater than zero.
+*
+**************************************************************************/
+int compare_ranked_file(const void *a,const void *b)
+{
+  const RANKED_FUNCTION *rank_a = (const RANKED_FUNCTION *) a;
+  const RANKED_FUNCTION *rank_b = (const RANKED_FUNCTION *) b;
+  int status;
+
+  status = strcmp(rank_a->filename,rank_b->filename);
+  if ((status == 0) && (rank_a->order != rank_b->order))
+    status = (rank_a->order < rank_b->order) ? -1 : 1;
+
+  return status;
+}
+
+/**************************************************************************
+*
+* Function:    print_ranked_functions
+*
+* Description: Sorts and prints the functions kept for the ranked report,
+*              then frees them.
+*
+* Parameters:  none
+*
+* Globals:     Rank_List, Rank_Files, Sort_Key, WKS_Flag, WKS_Header_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_ranked_functions(void)
+{
+  size_t index;
+
+  switch (Sort_Key)
+  {
+    case SORT_NAME:
+      qsort(Rank_List.items,Rank_List.count,sizeof(RANKED_FUNCTION),
+        compare_ranked_name);
+      break;
+    case SORT_FILE:
+      qsort(Rank_List.items,Rank_List.count,sizeof(RANKED_FUNCTION),
+        compare_ranked_file);
+      break;
+    default:
+      qsort(Rank_List.items,Rank_List.count,sizeof(RANKED_FUNCTION),
+        compare_ranked_loc);
+      break;
+  }
+
+  if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Rank,Function Name,Function LOC,Program Name\n");
+  }
+  else
+  {
+    printf("Rank     Function                         Function Program\n");
+    printf("         Name                             LOC      Name\n");
+    printf("======== ================================ ======== ============\n");
+  }
+
+  for (index = 0; index < Rank_List.count; index++)
+  {
+    if (WKS_Flag)
+      printf("%lu,%s,%lu,%s\n",(unsigned long) index + 1,
+        Rank_List.items[index].name,Rank_List.items[index].loc_count,
+        Rank_List.items[index].filename);
+    else
+      printf("%8lu %-32s %8lu %s\n",(unsigned long) index + 1,
+        Rank_List.items[index].name,Rank_List.items[index].loc_count,
+        Rank_List.items[index].filename);
+  }
+
+  if (!WKS_Flag)
+    printf("%-8s %lu\n","TOTAL",Rank_List.found);
+
+  mem_free(Rank_List.items);
+  Rank_List.items = NULL;
+  Rank_List.count = 0;
+  Rank_List.size = 0;
+  delete_file_list(&Rank_Files);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    clone_token
+*
+* Description: Adds a token of a function to its fingerprint for the
+*              --clones report.  Names are all hashed the same, so a copy
+*              that renamed its variables and calls still matches.  The
+*              lexer leaves out white space and comments, but a comment
+*              is only seen to start after its / was handed on, so a /
+*              is held back until the next token.  The fingerprint is
+*              the two hashes of hash_step, as for whole files, but the
+*              tokens are not kept, so functions with the same
+*              fingerprint are taken to be copies without comparing them.
+*
+* Parameters:  state - the function detector, counting a function.
+*              token - the token.
+*
+* Globals:     Places - the fingerprint is kept in the place of the
+*                  function.
+*
+* Locals:      function_name_compare, hash_step functions.
+*
+* Return:      none
+*
+**************************************************************************/
+void clone_token(FUNCTION_STATE *state,char *token)
+{
+  FUNCTION_PLACE *function = &Places.items[state->place];
+  char *text;
+  int pass;
+
+  if (((char_class(token[0]) & (CHAR_DIGIT | CHAR_DELIMITER)) == 0) &&
+      function_name_compare(token))
+    token = "$";
+  for (pass = 0; pass < 2; pass++)
+  {
+    if (pass == 0)
+    {
+      /* a / held back was not a comment after all */
+      if (!state->slash)
+        continue;
+      text = "/";
+    }
+    else if ((token[0] == '/') && (token[1] == 0))
+    {
+      state->slash = TRUE;
+      break;
+    }
+    else
+      text = token;
+    state->slash = FALSE;
+    /* the 0 at the end keeps the tokens apart */
+    hash_step(&function->clone_a,&function->clone_b,text,strlen(text) + 1);
+    function->tokens++;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    collect_clones
+*
+* Description: Keeps the fingerprint of each function of the file just
+*              counted for the --clones report.  Functions of fewer than
+*              CLONE_MIN_TOKENS tokens are left out, as small functions
+*              look alike without being copies.
+*
+* Parameters:  filename - name of the file that was counted.
+*
+* Globals:     Clone_List, Clone_Files, Places
+*
+* Locals:      head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void collect_clones(char *filename)
+{
+  ELEMENT *current;
+  FUNCTION_PLACE *place;
+  CLONE_FUNCTION *larger;
+  CLONE_FUNCTION *item;
+  size_t file_index;
+
+  /* the filename is saved once, when the first function is kept */
+  file_index = Clone_Files.count;
+
+  for (current = head, place = Places.items; current != NULL;
+       current = current->next, place++)
+  {
+    if ((current->loc_count == 0) || (place->tokens < CLONE_MIN_TOKENS))
+      continue;
+
+    if (file_index == Clone_Files.count)
+      add_file_name(&Clone_Files,filename);
+    if (Clone_List.count == Clone_List.size)
+    {
+      Clone_List.size = (Clone_List.size == 0) ? 256 : (Clone_List.size * 2);
+      larger = (CLONE_FUNCTION *) mem_realloc(MEM_FUNCTIONS,Clone_List.items,
+        Clone_List.size * sizeof(CLONE_FUNCTION));
+      if (larger == NULL)
+      {
+        printf("collect_clones: malloc failed.\n");
+        exit(1);
+      }
+      Clone_List.items = larger;
+    }
+    item = &Clone_List.items[Clone_List.count];
+    item->filename = Clone_Files.names[file_index];
+    item->name = current->name;
+    item->loc_count = current->loc_count;
+    item->hash_a = place->clone_a;
+    item->hash_b = place->clone_b;
+    item->tokens = place->tokens;
+    item->order = (unsigned long) Clone_List.count;
+    Clone_List.count++;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    compare_clone_functions
+*
+* Description: qsort comparison of the functions of the --clones report
+*              by fingerprint, so that the copies of a function are next
+*              to each other, then in the order they were found.
+*
+* Parameters:  a, b - references to CLONE_FUNCTION.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      less than, equal to, or greater than zero.
+*
+**************************************************************************/
+int compare_clone_functions(const void *a,const void *b)
+{
+  const CLONE_FUNCTION *clone_a = (const CLONE_FUNCTION *) a;
+  const CLONE_FUNCTION *clone_b = (const CLONE_FUNCTION *) b;
+
+  if (clone_a->hash_a != clone_b->hash_a)
+    return (clone_a->hash_a < clone_b->hash_a) ? -1 : 1;
+  if (clone_a->hash_b != clone_b->hash_b)
+    return (clone_a->hash_b < clone_b->hash_b) ? -1 : 1;
+  if (clone_a->tokens != clone_b->tokens)
+    return (clone_a->tokens < clone_b->tokens) ? -1 : 1;
+  if (clone_a->order != clone_b->order)
+    return (clone_a->order < clone_b->order) ? -1 : 1;
+
+  return 0;
+}
+
+/**************************************************************************
+*
+* Function:    compare_clone_groups
+*
+* Description: qsort comparison of clone groups, largest combined LOC
+*              first, then in the order they were found.
+*
+* Parameters:  a, b - references to CLONE_GROUP.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      less than, equal to, or greater than zero.
+*
+**************************************************************************/
+int compare_clone_groups(const void *a,const void *b)
+{
+  const CLONE_GROUP *group_a = (const CLONE_GROUP *) a;
+  const CLONE_GROUP *group_b = (const CLONE_GROUP *) b;
+
+  if (group_a->loc_count != group_b->loc_count)
+    return (group_a->loc_count > group_b->loc_count) ? -1 : 1;
+  if (group_a->order != group_b->order)
+    return (group_a->order < group_b->order) ? -1 : 1;
+
+  return 0;
+}
+
+/**************************************************************************
+*
+* Function:    print_clones
+*
+* Description: Groups the functions kept for the --clones report by
+*              fingerprint and prints each group of two or more, largest
+*              combined LOC first, then frees them.  Functions with the
+*              same fingerprint are grouped without comparing their
+*              tokens, which were not kept, and the report says so.
+*
+* Parameters:  none
+*
+* Globals:     Clone_List, Clone_Files, WKS_Flag, WKS_Header_Flag
+*
+* Locals:      compare_clone_functions, compare_clone_groups functions.
+*
+* Return:      none
+*
+**************************************************************************/
+void print_clones(void)
+{
+  CLONE_FUNCTION *items;
+  CLONE_GROUP *groups;
+  CLONE_GROUP *group;
+  size_t group_count = 0;
+  size_t index;
+  size_t end;
+  size_t member;
+  unsigned long functions = 0;
+  COUNTER total_loc = 0;
+
+  items = Clone_List.items;
+  qsort(items,Clone_List.count,sizeof(CLONE_FUNCTION),
+    compare_clone_functions);
+  groups = (CLONE_GROUP *) mem_calloc(MEM_FUNCTIONS,(Clone_List.count / 2) + 1,
+    sizeof(CLONE_GROUP));
+  if (groups == NULL)
+  {
+    printf("print_clones: malloc failed.\n");
+    exit(1);
+  }
+  for (index = 0; index < Clone_List.count; index = end)
+  {
+    group = &groups[group_count];
+    group->first = index;
+    group->order = items[index].order;
+    group->loc_count = 0;
+    for (end = index; (end < Clone_List.count) &&
+         (items[end].hash_a == items[index].hash_a) &&
+         (items[end].hash_b == items[index].hash_b) &&
+         (items[end].tokens == items[index].tokens); end++)
+      group->loc_count += items[end].loc_count;
+    group->count = end - index;
+    if (group->count > 1)
+    {
+      group_count++;
+      functions += (unsigned long) group->count;
+      total_loc += group->loc_count;
+    }
+  }
+  qsort(groups,group_count,sizeof(CLONE_GROUP),compare_clone_groups);
+
+  if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Clone Group,Copies,Combined LOC,Function Name,Function LOC,"
+        "Program Name\n");
+  }
+  else
+  {
+    printf("Grouped by the fingerprint of the tokens, which are not "
+      "compared.\n");
+    printf("Clone    Function                         Function Program\n");
+    printf("Group    Name                             LOC      Name\n");
+    printf("======== ================================ ======== ============\n");
+  }
+
+  for (index = 0; index < group_count; index++)
+  {
+    group = &groups[index];
+    if (!WKS_Flag)
+      printf("%8lu %-32s %8lu %s\n",(unsigned long) index + 1,"",
+        group->loc_count,"combined");
+    for (member = group->first; member < (group->first + group->count);
+         member++)
+    {
+      if (WKS_Flag)
+        printf("%lu,%lu,%lu,%s,%lu,%s\n",(unsigned long) index + 1,
+          (unsigned long) group->count,group->loc_count,items[member].name,
+          items[member].loc_count,items[member].filename);
+      else
+        printf("%8s %-32s %8lu %s\n"," ",items[member].name,
+          items[member].loc_count,items[member].filename);
+    }
+  }
+
+  if (!WKS_Flag)
+    printf("%-8s %-32lu %8lu %lu groups\n","TOTAL",functions,total_loc,
+      (unsigned long) group_count);
+
+  mem_free(groups);
+  mem_free(Clone_List.items);
+  Clone_List.items = NULL;
+  Clone_List.count = 0;
+  Clone_List.size = 0;
+  delete_file_list(&Clone_Files);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    histogram_bucket
+*
+* Description: Finds the histogram bucket of a function size.  Small sizes
+*              have a bucket each.  Larger sizes share buckets that are
+*              1/8th of a power of 2 wide, so a bucket is never off by more
+*              than about 6% from its middle.
+*
+* Parameters:  loc - logical lines of code of the function.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      bucket index, 0 to HISTOGRAM_BUCKETS-1.
+*
+**************************************************************************/
+unsigned int histogram_bucket(COUNTER loc)
+{
+  unsigned int exponent = 0;
+  unsigned int bucket;
+  COUNTER value;
+
+  if (loc < HISTOGRAM_LINEAR)
+    return (unsigned int) loc;
+
+  /* exponent is the position of the highest bit that is set */
+  for (value = loc; value > 1; value >>= 1)
+    exponent++;
+  /* the 3 bits below the highest bit pick one of 8 buckets */
+  bucket = HISTOGRAM_LINEAR + ((exponent - 4) * 8) +
+    (unsigned int) ((loc >> (exponent - 3)) & 7);
+  if (bucket >= HISTOGRAM_BUCKETS)
+    bucket = HISTOGRAM_BUCKETS - 1;
+
+  return bucket;
+}
+
+/**************************************************************************
+*
+* Function:    histogram_bucket_value
+*
+* Description: Finds the size in the middle of a histogram bucket.
+*
+* Parameters:  bucket - bucket index from histogram_bucket.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      logical lines of code in the middle of the bucket.
+*
+**************************************************************************/
+COUNTER histogram_bucket_value(unsigned int bucket)
+{
+  unsigned int exponent;
+  COUNTER width;
+
+  if (bucket < HISTOGRAM_LINEAR)
+    return (COUNTER) bucket;
+
+  exponent = 4 + ((bucket - HISTOGRAM_LINEAR) / 8);
+  width = (COUNTER) 1 << (exponent - 3);
+
+  return ((8 + ((bucket - HISTOGRAM_LINEAR) % 8)) * width) + (width / 2);
+}
+
+/**************************************************************************
+*
+* Function:    add_histogram
+*
+* Description: Adds the size of one function to a histogram.
+*
+* Parameters:  histogram - reference to the histogram.
+*              loc - logical lines of code of the function.
+*
+* Globals:     none
+*
+* Locals:      histogram_bucket function.
+*
+* Return:      none
+*
+**************************************************************************/
+void add_histogram(HISTOGRAM *histogram,COUNTER loc)
+{
+  histogram->buckets[histogram_bucket(loc)]++;
+  if ((histogram->count == 0) || (loc < histogram->min))
+    histogram->min = loc;
+  if (loc > histogram->max)
+    histogram->max = loc;
+  histogram->count++;
+  histogram->sum += loc;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    merge_histogram
+*
+* Description: Adds all of the functions of one histogram to another.  The
+*              result is the same as if every function had been added to
+*              the total histogram on its own.
+*
+* Parameters:  total - reference to the histogram that is added to.
+*              histogram - reference to the histogram to add.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void merge_histogram(HISTOGRAM *total,HISTOGRAM *histogram)
+{
+  unsigned int bucket;
+
+  if (histogram->count == 0)
+    return;
+
+  for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    total->buckets[bucket] += histogram->buckets[bucket];
+  if ((total->count == 0) || (histogram->min < total->min))
+    total->min = histogram->min;
+  if (histogram->max > total->max)
+    total->max = histogram->max;
+  total->count += histogram->count;
+  total->sum += histogram->sum;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    histogram_percentile
+*
+* Description: Estimates the function size that a percentage of the
+*              functions are no larger than.
+*
+* Parameters:  histogram - reference to the histogram.
+*              percent - percentile wanted, 0 to 100.
+*
+* Globals:     none
+*
+* Locals:      histogram_bucket_value function.
+*
+* Return:      logical lines of code at the percentile.
+*
+**************************************************************************/
+COUNTER histogram_percentile(HISTOGRAM *histogram,unsigned int percent)
+{
+  COUNTER rank;
+  COUNTER seen = 0;
+  COUNTER value;
+  unsigned int bucket;
+
+  if (histogram->count == 0)
+    return 0;
+
+  /* rank of the function at the percentile, counting from 1 */
+  rank = ((histogram->count * percent) + 99) / 100;
+  if (rank == 0)
+    rank = 1;
+
+  for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+  {
+    seen += histogram->buckets[bucket];
+    if (seen >= rank)
+      break;
+  }
+
+  /* the exact smallest and largest sizes are better than a bucket */
+  value = histogram_bucket_value(bucket);
+  if (value < histogram->min)
+    value = histogram->min;
+  if (value > histogram->max)
+    value = histogram->max;
+
+  return value;
+}
+
+/**************************************************************************
+*
+* Function:    directory_name
+*
+* Description: Finds the directory part of a filename.
+*
+* Parameters:  filename - reference to the filename.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      memory holding the directory, or "." if the filename has
+*              no directory, which the caller frees.
+*
+**************************************************************************/
+char *directory_name(char *filename)
+{
+  char *directory;
+  size_t length;
+
+  for (length = strlen(filename); length > 0; length--)
+  {
+    if ((filename[length-1] == '/') || (filename[length-1] == '\\') ||
+        (filename[length-1] == ':'))
+      break;
+  }
+  /* keep the separator only when it is the root directory */
+  if (length > 1)
+    length--;
+
+  directory = (char *) mem_alloc(MEM_PATHS,length + 2);
+  if (directory == NULL)
+  {
+    printf("directory_name: malloc failed.\n");
+    exit(1);
+  }
+  if (length == 0)
+    strcpy(directory,".");
+  else
+  {
+    memcpy(directory,filename,length);
+    directory[length] = 0;
+  }
+
+  return directory;
+}
+
+/**************************************************************************
+*
+* Function:    find_directory_histogram
+*
+* Description: Finds the histogram of a directory, adding an empty one if
+*              the directory has not been seen before.
+*
+* Parameters:  directory - reference to the directory name.
+*
+* Globals:     Directory_Table, Directory_Count
+*
+* Locals:      hash_bytes function.
+*
+* Return:      the histogram of the directory.
+*
+**************************************************************************/
+DIRECTORY_HISTOGRAM *find_directory_histogram(char *directory)
+{
+  DIRECTORY_HISTOGRAM *p;
+  unsigned int bucket;
+
+  bucket = (unsigned int) (hash_bytes(2166136261UL,directory,
+    strlen(directory)) & (MAX_DIRECTORY_BUCKETS - 1));
+  for (p = Directory_Table[bucket]; p != NULL; p = p->next)
+  {
+    if (strcmp(p->directory,directory) == 0)
+      return p;
+  }
+
+  p = (DIRECTORY_HISTOGRAM *) mem_calloc(MEM_CACHES,1,
+    sizeof(DIRECTORY_HISTOGRAM));
+  if (p != NULL)
+    p->directory = (char *) mem_alloc(MEM_CACHES,strlen(directory) + 1);
+  if ((p == NULL) || (p->directory == NULL))
+  {
+    printf("find_directory_histogram: malloc failed.\n");
+    exit(1);
+  }
+  strcpy(p->directory,directory);
+  p->next = Directory_Table[bucket];
+  Directory_Table[bucket] = p;
+  Directory_Count++;
+
+  return p;
+}
+
+/**************************************************************************
+*
+* Function:    histogram_functions
+*
+* Description: Adds the size of each function of the file just counted to
+*              the histogram of its directory.  Only the histogram is
+*              kept, not the functions.
+*
+* Parameters:  filename - name of the file that was counted.
+*
+* Globals:     none
+*
+* Locals:      head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void histogram_functions(char *filename)
+{
+  DIRECTORY_HISTOGRAM *p;
+  ELEMENT *current;
+  char *directory;
+
+  directory = directory_name(filename);
+  p = find_directory_histogram(directory);
+  mem_free(directory);
+
+  for (current = head; current != NULL; current = current->next)
+  {
+    if (current->loc_count > 0)
+      add_histogram(&p->histogram,current->loc_count);
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_histogram_line
+*
+* Description: Prints the percentiles of one histogram.
+*
+* Parameters:  histogram - reference to the histogram.
+*              name - directory name, or TOTAL.
+*
+* Globals:     WKS_Flag
+*
+* Locals:      histogram_percentile function.
+*
+* Return:      none
+*
+**************************************************************************/
+void print_histogram_line(HISTOGRAM *histogram,char *name)
+{
+  double mean = 0.0;
+
+  if (histogram->count > 0)
+    mean = (double) histogram->sum / (double) histogram->count;
+
+  if (WKS_Flag)
+    printf("%s,%lu,%lu,%lu,%lu,%lu,%lu,%.1f\n",name,histogram->count,
+      histogram->min,histogram_percentile(histogram,50),
+      histogram_percentile(histogram,90),histogram_percentile(histogram,99),
+      histogram->max,mean);
+  else
+    printf("%9lu %8lu %8lu %8lu %8lu %8lu %8.1f %s\n",histogram->count,
+      histogram->min,histogram_percentile(histogram,50),
+      histogram_percentile(histogram,90),histogram_percentile(histogram,99),
+      histogram->max,mean,name);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    compare_directory_histograms
+*
+* Description: qsort comparison of directory histograms by directory name.
+*
+* Parameters:  a, b - references to DIRECTORY_HISTOGRAM pointers.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      less than, equal to, or greater than zero as strcmp.
+*
+**************************************************************************/
+int compare_directory_histograms(const void *a,const void *b)
+{
+  return strcmp((*(DIRECTORY_HISTOGRAM * const *) a)->directory,
+    (*(DIRECTORY_HISTOGRAM * const *) b)->directory);
+}
+
+/**************************************************************************
+*
+* Function:    print_histograms
+*
+* Description: Prints the function size percentiles of each directory,
+*              then merges the directory histograms into one for all of
+*              the files and prints it with the spread of the sizes.
+*              The histograms are freed.
+*
+* Parameters:  none
+*
+* Globals:     Directory_Table, Directory_Count, WKS_Flag, WKS_Header_Flag
+*
+* Locals:      merge_histogram, print_histogram_line functions.
+*
+* Return:      none
+*
+**************************************************************************/
+void print_histograms(void)
+{
+  DIRECTORY_HISTOGRAM **directories;
+  DIRECTORY_HISTOGRAM *p;
+  DIRECTORY_HISTOGRAM *next;
+  HISTOGRAM total;
+  COUNTER ranges[40];       /* functions in each power of 2 */
+  COUNTER low;
+  COUNTER high;
+  size_t count = 0;
+  unsigned int bucket;
+  unsigned int index;
+
+  memset(&total,0,sizeof(total));
+  directories = (DIRECTORY_HISTOGRAM **) mem_alloc(MEM_CACHES,
+    (Directory_Count + 1) * sizeof(DIRECTORY_HISTOGRAM *));
+  if (directories == NULL)
+  {
+    printf("print_histograms: malloc failed.\n");
+    exit(1);
+  }
+  for (index = 0; index < MAX_DIRECTORY_BUCKETS; index++)
+  {
+    for (p = Directory_Table[index]; p != NULL; p = p->next)
+      directories[count++] = p;
+  }
+  qsort(directories,count,sizeof(DIRECTORY_HISTOGRAM *),
+    compare_directory_histograms);
+
+  if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Directory,Functions,Min LOC,P50 LOC,P90 LOC,P99 LOC,"
+             "Max LOC,Mean LOC\n");
+  }
+  else
+  {
+    printf("Functions Min      p50      p90      p99      Max      Mean"
+           "     Directory\n");
+    printf("========= ======== ======== ======== ======== ======== ========"
+           " ============\n");
+  }
+  for (index = 0; index < count; index++)
+  {
+    print_histogram_line(&directories[index]->histogram,
+      directories[index]->directory);
+    merge_histogram(&total,&directories[index]->histogram);
+  }
+  if (!WKS_Flag)
+    printf("========= ======== ======== ======== ======== ======== ========"
+           " ============\n");
+  print_histogram_line(&total,"TOTAL");
+
+  /* spread of the sizes over powers of 2 - every bucket falls inside
+     one power of 2, found from the number of bits in its sizes */
+  if (!WKS_Flag && (total.count > 0))
+  {
+    memset(ranges,0,sizeof(ranges));
+    for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+      index = 0;
+      for (low = histogram_bucket_value(bucket); low > 0; low >>= 1)
+        index++;
+      ranges[index] += total.buckets[bucket];
+    }
+    printf("\n");
+    printf("Function LOC      Functions Percent\n");
+    printf("================= ========= =======\n");
+    for (index = 0; index < (sizeof(ranges) / sizeof(ranges[0])); index++)
+    {
+      if (ranges[index] == 0)
+        continue;
+      low = (index == 0) ? 0 : ((COUNTER) 1 << (index - 1));
+      high = (index == 0) ? 0 : ((low * 2) - 1);
+      printf("%8lu-%-8lu %9lu %6.1f%%\n",low,high,ranges[index],
+        (100.0 * (double) ranges[index]) / (double) total.count);
+    }
+  }
+
+  /* House Keeping */
+  for (index = 0; index < MAX_DIRECTORY_BUCKETS; index++)
+  {
+    for (p = Directory_Table[index]; p != NULL; p = next)
+    {
+      next = p->next;
+      mem_free(p->directory);
+      mem_free(p);
+    }
+    Directory_Table[index] = NULL;
+  }
+  Directory_Count = 0;
+  mem_free(directories);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    rollup_child
+*
+* Description: Finds the child of a rollup node that is named by the first
+*              characters of a path, adding it if it has not been seen.
+*
+* Parameters:  node - reference to the parent node.
+*              path - reference to the path naming the child.
+*              length - number of characters of the path in the name.
+*              add_pending - TRUE if a new child should be waited for by
+*                            the parent.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      the child node.
+*
+**************************************************************************/
+ROLLUP_NODE *rollup_child(ROLLUP_NODE *node,char *path,size_t length,
+  unsigned char add_pending)
+{
+  ROLLUP_NODE *child;
+
+  for (child = node->child; child != NULL; child = child->sibling)
+  {
+    if ((strncmp(child->path,path,length) == 0) &&
+        (child->path[length] == 0))
+      break;
+  }
+  if (child == NULL)
+  {
+    child = (ROLLUP_NODE *) mem_calloc(MEM_CACHES,1,sizeof(ROLLUP_NODE));
+    if (child != NULL)
+      child->path = (char *) mem_alloc(MEM_CACHES,length + 1);
+    if ((child == NULL) || (child->path == NULL))
+    {
+      printf("rollup_child: malloc failed.\n");
+      exit(1);
+    }
+    memcpy(child->path,path,length);
+    child->path[length] = 0;
+    child->parent = node;
+    if (node->last_child == NULL)
+      node->child = child;
+    else
+      node->last_child->sibling = child;
+    node->last_child = child;
+    if (add_pending)
+      node->pending++;
+  }
+
+  return child;
+}
+
+/**************************************************************************
+*
+* Function:    find_rollup_node
+*
+* Description: Finds the rollup node of the directory of a file, adding the
+*              nodes of any directories along the path that have not been
+*              seen yet.  The separators of the filename are kept, so each
+*              node is named the way the filenames name it.
+*
+* Parameters:  filename - reference to the filename.
+*              add_pending - TRUE if each new directory should be waited
+*                            for by the directory above it.
+*
+* Globals:     Rollup_Root
+*
+* Locals:      directory_name, rollup_child functions.
+*
+* Return:      the node of the directory holding the file.
+*
+**************************************************************************/
+ROLLUP_NODE *find_rollup_node(char *filename,unsigned char add_pending)
+{
+  static ROLLUP_NODE *last_node = NULL;   /* node found last time */
+  ROLLUP_NODE *node;
+  char *directory;
+  size_t start = 0;
+  size_t end;
+
+  if (Rollup_Root == NULL)
+  {
+    Rollup_Root = (ROLLUP_NODE *) mem_calloc(MEM_CACHES,1,sizeof(ROLLUP_NODE));
+    if (Rollup_Root == NULL)
+    {
+      printf("find_rollup_node: malloc failed.\n");
+      exit(1);
+    }
+    last_node = NULL;
+  }
+
+  directory = directory_name(filename);
+  /* files of the same directory usually come one after the other */
+  if ((last_node != NULL) && (strcmp(last_node->path,directory) == 0))
+  {
+    mem_free(directory);
+    return last_node;
+  }
+
+  node = Rollup_Root;
+  /* an archive in the current directory is named without a directory,
+     so its members are hung under "." like the archive itself */
+  for (end = 0; directory[end] != 0; end++)
+  {
+    if ((directory[end] == '/') || (directory[end] == '\\') ||
+        (directory[end] == ':'))
+      break;
+  }
+  if ((end > 1) && (filename[end] == ':'))
+    node = rollup_child(node,".",1,add_pending);
+  do
+  {
+    /* each component ends at a separator or at the end */
+    for (end = start; directory[end] != 0; end++)
+    {
+      if ((directory[end] == '/') || (directory[end] == '\\') ||
+          (directory[end] == ':'))
+        break;
+    }
+    /* a path from the root directory keeps its leading separator */
+    if ((end == 0) && (directory[end] != 0))
+      end = 1;
+
+    node = rollup_child(node,directory,end,add_pending);
+
+    start = end;
+    if ((directory[start] == '/') || (directory[start] == '\\') ||
+        (directory[start] == ':'))
+      start++;
+  } while (directory[end] != 0);
+
+  mem_free(directory);
+  last_node = node;
+
+  return node;
+}
+
+/**************************************************************************
+*
+* Function:    register_rollup
+*
+* Description: Tells the directory of an input that it must wait for the
+*              input before its totals are complete.
+*
+* Parameters:  filename - reference to the input filename.
+*
+* Globals:     none
+*
+* Locals:      find_rollup_node function.
+*
+* Return:      none
+*
+**************************************************************************/
+void register_rollup(char *filename)
+{
+  find_rollup_node(filename,TRUE)->pending++;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    rollup_file
+*
+* Description: Adds the totals of the file just counted to its directory.
+*
+* Parameters:  filename - reference to the filename.
+*              counts - reference to the totals for the file.
+*
+* Globals:     none
+*
+* Locals:      head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void rollup_file(char *filename,FILE_COUNTS *counts)
+{
+  ROLLUP_NODE *node;
+  ELEMENT *current;
+
+  /* the members of an archive were not known in advance */
+  node = find_rollup_node(filename,FALSE);
+  node->files++;
+  node->loc_count += counts->loc_count;
+  node->physical_loc += counts->physical_loc;
+  node->comment_loc += counts->comment_loc;
+  for (current = head; current != NULL; current = current->next)
+  {
+    if (current->loc_count > 0)
+    {
+      node->functions++;
+      node->function_loc += current->loc_count;
+    }
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    rollup_done
+*
+* Description: Marks an input as finished.  A directory that is no longer
+*              waiting for anything is printed straight away, which may in
+*              turn finish the directory above it.
+*
+* Parameters:  filename - reference to the input filename.
+*
+* Globals:     none
+*
+* Locals:      find_rollup_node, emit_rollup functions.
+*
+* Return:      none
+*
+**************************************************************************/
+void rollup_done(char *filename)
+{
+  ROLLUP_NODE *node;
+
+  node = find_rollup_node(filename,FALSE);
+  if (node->pending > 0)
+    node->pending--;
+  if (node->pending == 0)
+    emit_rollup(node,TRUE);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    emit_rollup
+*
+* Description: Prints the totals of a finished directory and adds them to
+*              the directory above it.  Any subdirectories not printed yet
+*              (those found inside archives) are printed first.  The top
+*              of the tree is printed as the TOTAL.
+*
+* Parameters:  node - reference to the finished directory.
+*              cascade - TRUE if the directory above should be told that
+*                        this directory is finished.
+*
+* Globals:     WKS_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void emit_rollup(ROLLUP_NODE *node,unsigned char cascade)
+{
+  ROLLUP_NODE *child;
+  ROLLUP_NODE *parent;
+
+  if (node->emitted)
+    return;
+  for (child = node->child; child != NULL; child = child->sibling)
+    emit_rollup(child,FALSE);
+  node->emitted = TRUE;
+
+  if (WKS_Flag)
+    printf("%s,%lu,%lu,%lu,%lu,%lu,%lu\n",
+      (node->parent == NULL) ? "TOTAL" : node->path,node->files,
+      node->functions,node->function_loc,node->loc_count,node->physical_loc,
+      node->comment_loc);
+  else
+  {
+    if (node->parent == NULL)
+      printf("======== ======== ======== ======== ======== ========"
+             " ============\n");
+    printf("%8lu %8lu %8lu %8lu %8lu %8lu %s\n",node->files,node->functions,
+      node->function_loc,node->loc_count,node->physical_loc,node->comment_loc,
+      (node->parent == NULL) ? "TOTAL" : node->path);
+  }
+  fflush(stdout);
+
+  parent = node->parent;
+  if (parent == NULL)
+    return;
+  parent->files += node->files;
+  parent->functions += node->functions;
+  parent->function_loc += node->function_loc;
+  parent->loc_count += node->loc_count;
+  parent->physical_loc += node->physical_loc;
+  parent->comment_loc += node->comment_loc;
+
+  if (cascade)
+  {
+    if (parent->pending > 0)
+      parent->pending--;
+    if (parent->pending == 0)
+      emit_rollup(parent,TRUE);
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_rollup_header
+*
+* Description: Prints the column headings of the directory totals.
+*
+* Parameters:  none
+*
+* Globals:     WKS_Flag, WKS_Header_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_rollup_header(void)
+{
+  if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Directory,Files,Functions,Function LOC,Total LOC,"
+             "Physical LOC,Comment LOC\n");
+  }
+  else
+  {
+    printf("Files    Function Function Total    Physical Comment  Directory\n");
+    printf("         Count    LOC      LOC      LOC      LOC\n");
+    printf("======== ======== ======== ======== ======== ======== "
+           "============\n");
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    delete_rollup
+*
+* Description: De-allocates memory for a directory and all of the
+*              directories below it.
+*
+* Parameters:  node - reference to the top directory, or NULL.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_rollup(ROLLUP_NODE *node)
+{
+  ROLLUP_NODE *child;
+  ROLLUP_NODE *next;
+
+  if (node == NULL)
+    return;
+  for (child = node->child; child != NULL; child = next)
+  {
+    next = child->sibling;
+    delete_rollup(child);
+  }
+  mem_free(node->path);
+  mem_free(node);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    sample_random
+*
+* Description: Pseudo random numbers for --sample (xorshift), so that the
+*              same seed picks the same files on every platform.
+*
+* Parameters:  none
+*
+* Globals:     Sample_Seed - state of the generator.
+*
+* Locals:      none
+*
+* Return:      a random number from 1 to 2^32-1.
+*
+**************************************************************************/
+unsigned long sample_random(void)
+{
+  unsigned long x = Sample_Seed;
+
+  x ^= (x << 13) & 0xFFFFFFFFUL;
+  x ^= x >> 17;
+  x ^= (x << 5) & 0xFFFFFFFFUL;
+  Sample_Seed = x;
+
+  return x;
+}
+
+/**************************************************************************
+*
+* Function:    select_sample
+*
+* Description: Picks the files to count for --sample.  The files are put
+*              into strata by size, each stratum a factor of 4 in size,
+*              and the sample is shared out by the bytes in each stratum,
+*              with at least 2 files from each stratum so that its spread
+*              can be measured.  Within a stratum the files are taken at
+*              even steps from a random start, in name order, which also
+*              spreads the sample over the directories.
+*
+* Parameters:  none
+*
+* Globals:     Input_List, Sample_Units, Sample_Size, Sample_Fraction,
+*              Sample_Seed, Sample_Seed_Used
+*
+* Locals:      sample_random, file_bytes functions.
+*
+* Return:      number of files picked.
+*
+**************************************************************************/
+size_t select_sample(void)
+{
+  double stratum_bytes[SAMPLE_STRATA];  /* bytes in each stratum */
+  size_t stratum_files[SAMPLE_STRATA];  /* files in each stratum */
+  size_t stratum_picks[SAMPLE_STRATA];  /* files to pick from each */
+  size_t stratum_seen[SAMPLE_STRATA];   /* files passed in each */
+  double next_pick[SAMPLE_STRATA];      /* position of the next pick */
+  double step;
+  double total_bytes = 0.0;
+  double share_bytes;                   /* bytes of strata not yet full */
+  double picks;
+  size_t share_files;                   /* files of strata not yet full */
+  size_t wanted;                        /* files wanted in the sample */
+  int full;                             /* TRUE if a stratum filled up */
+  size_t selected = 0;
+  size_t index;
+  unsigned int stratum;
+  unsigned long bytes;
+
+  Sample_Units = (SAMPLE_UNIT *) mem_calloc(MEM_CACHES,Input_List.count,
+    sizeof(SAMPLE_UNIT));
+  if ((Sample_Units == NULL) && (Input_List.count > 0))
+  {
+    printf("select_sample: malloc failed.\n");
+    exit(1);
+  }
+  if (Sample_Seed == 0)
+    Sample_Seed = (unsigned long) time(NULL) & 0xFFFFFFFFUL;
+  if (Sample_Seed == 0)
+    Sample_Seed = 1;
+  /* the generator changes Sample_Seed - keep the seed for the report */
+  Sample_Seed_Used = Sample_Seed;
+
+  for (stratum = 0; stratum < SAMPLE_STRATA; stratum++)
+  {
+    stratum_bytes[stratum] = 0.0;
+    stratum_files[stratum] = 0;
+    stratum_seen[stratum] = 0;
+  }
+  for (index = 0; index < Input_List.count; index++)
+  {
+    bytes = file_bytes(Input_List.names[index]);
+    stratum = 0;
+    while ((bytes >> (stratum * 2)) > 1)
+      stratum++;
+    if (stratum >= SAMPLE_STRATA)
+      stratum = SAMPLE_STRATA - 1;
+    Sample_Units[index].bytes = bytes;
+    Sample_Units[index].stratum = stratum;
+    stratum_bytes[stratum] += (double) bytes;
+    stratum_files[stratum]++;
+    total_bytes += (double) bytes;
+  }
+
+  /* a fraction of the files, or a number of files */
+  if (Sample_Fraction)
+    wanted = (size_t) ((Sample_Size * (double) Input_List.count) + 0.5);
+  else
+    wanted = (size_t) Sample_Size;
+  if (wanted < 1)
+    wanted = 1;
+
+  /* a stratum that gets all of its files hands the rest back */
+  for (stratum = 0; stratum < SAMPLE_STRATA; stratum++)
+    stratum_picks[stratum] = (wanted >= Input_List.count) ?
+      stratum_files[stratum] : 0;
+  do
+  {
+    share_bytes = 0.0;
+    share_files = 0;
+    for (stratum = 0; stratum < SAMPLE_STRATA; stratum++)
+    {
+      if (stratum_picks[stratum] < stratum_files[stratum])
+      {
+        share_bytes += stratum_bytes[stratum];
+        share_files += stratum_files[stratum];
+      }
+    }
+    full = FALSE;
+    for (stratum = 0; stratum < SAMPLE_STRATA; stratum++)
+    {
+      if ((stratum_picks[stratum] >= stratum_files[stratum]) ||
+          (share_files == 0))
+        continue;
+      if (share_bytes > 0.0)
+        picks = (double) wanted * stratum_bytes[stratum] / share_bytes;
+      else
+        picks = (double) wanted * (double) stratum_files[stratum] /
+          (double) share_files;
+      if (picks >= (double) stratum_files[stratum])
+      {
+        stratum_picks[stratum] = stratum_files[stratum];
+        wanted = (wanted > stratum_files[stratum]) ?
+          (wanted - stratum_files[stratum]) : 0;
+        full = TRUE;
+        break;
+      }
+    }
+  } while (full);
+  for (stratum = 0; stratum < SAMPLE_STRATA; stratum++)
+  {
+    if (stratum_picks[stratum] < stratum_files[stratum])
+    {
+      if (share_bytes > 0.0)
+        stratum_picks[stratum] = (size_t) (((double) wanted *
+          stratum_bytes[stratum] / share_bytes) + 0.5);
+      else if (share_files > 0)
+        stratum_picks[stratum] = (size_t) (((double) wanted *
+          (double) stratum_files[stratum] / (double) share_files) + 0.5);
+      if (stratum_picks[stratum] < 2)
+        stratum_picks[stratum] = 2;
+      if (stratum_picks[stratum] > stratum_files[stratum])
+        stratum_picks[stratum] = stratum_files[stratum];
+    }
+    next_pick[stratum] = 0.0;
+    if (stratum_picks[stratum] > 0)
+    {
+      step = (double) stratum_files[stratum] /
+        (double) stratum_picks[stratum];
+      next_pick[stratum] = step * (double) (sample_random() % 10000) /
+        10000.0;
+    }
+  }
+
+  for (index = 0; index < Input_List.count; index++)
+  {
+    stratum = Sample_Units[index].stratum;
+    if ((stratum_picks[stratum] > 0) &&
+        (((double) stratum_seen[stratum] + 1.0) > next_pick[stratum]))
+    {
+      Sample_Units[index].selected = TRUE;
+      selected++;
+      next_pick[stratum] += (double) stratum_files[stratum] /
+        (double) stratum_picks[stratum];
+    }
+    stratum_seen[stratum]++;
+  }
+
+  return selected;
+}
+
+/**************************************************************************
+*
+* Function:    sample_file
+*
+* Description: Adds the totals of the file just counted to the sample.
+*              All of the members of an archive add up to one file.
+*
+* Parameters:  counts - reference to the totals for the file.
+*
+* Globals:     Sample_Units, Current_Input
+*
+* Locals:      head - first ELEMENT of the linked list
+*
+* Return:      none
+*
+**************************************************************************/
+void sample_file(FILE_COUNTS *counts)
+{
+  SAMPLE_UNIT *unit = &Sample_Units[Current_Input];
+  ELEMENT *current;
+
+  unit->values[SAMPLE_LOC] += counts->loc_count;
+  unit->values[SAMPLE_PHYSICAL] += counts->physical_loc;
+  unit->values[SAMPLE_COMMENT] += counts->comment_loc;
+  for (current = head; current != NULL; current = current->next)
+  {
+    if (current->loc_count > 0)
+      unit->values[SAMPLE_FUNCTIONS]++;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    sample_estimate
+*
+* Description: Estimates the total of a value over all of the files from
+*              the files in the sample.  Each stratum uses a ratio
+*              estimate - the value per byte of its sampled files times
+*              the bytes of all of its files - and the variance of the
+*              estimate comes from how far each sampled file is from
+*              that ratio, scaled for the files that were not counted.
+*
+* Parameters:  values - value of each input; only sampled ones are used.
+*              estimate - reference to the estimated total.
+*              variance - reference to the variance of the estimate.
+*
+* Globals:     Input_List, Sample_Units
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void sample_estimate(double *values,double *estimate,double *variance)
+{
+  double all_bytes;        /* bytes of all the files in the stratum */
+  double sample_bytes;     /* bytes of the sampled files */
+  double sample_values;    /* sum of the values of the sampled files */
+  double ratio;            /* value per byte, or per file */
+  double residual;
+  double squares;
+  double files;            /* files in the stratum */
+  double picked;           /* sampled files in the stratum */
+  size_t index;
+  unsigned int stratum;
+
+  *estimate = 0.0;
+  *variance = 0.0;
+  for (stratum = 0; stratum < SAMPLE_STRATA; stratum++)
+  {
+    all_bytes = 0.0;
+    sample_bytes = 0.0;
+    sample_values = 0.0;
+    files = 0.0;
+    picked = 0.0;
+    for (index = 0; index < Input_List.count; index++)
+    {
+      if (Sample_Units[index].stratum != stratum)
+        continue;
+      files += 1.0;
+      all_bytes += (double) Sample_Units[index].bytes;
+      if (Sample_Units[index].selected)
+      {
+        picked += 1.0;
+        sample_bytes += (double) Sample_Units[index].bytes;
+        sample_values += values[index];
+      }
+    }
+    if (picked == 0.0)
+      continue;
+
+    /* empty files have no bytes to scale by - use the mean per file */
+    if (sample_bytes > 0.0)
+    {
+      ratio = sample_values / sample_bytes;
+      *estimate += ratio * all_bytes;
+    }
+    else
+    {
+      ratio = 0.0;
+      *estimate += sample_values * files / picked;
+    }
+
+    if ((picked < 2.0) || (picked >= files))
+      continue;
+    squares = 0.0;
+    for (index = 0; index < Input_List.count; index++)
+    {
+      if ((Sample_Units[index].stratum != stratum) ||
+          !Sample_Units[index].selected)
+        continue;
+      if (sample_bytes > 0.0)
+        residual = values[index] -
+          (ratio * (double) Sample_Units[index].bytes);
+      else
+        residual = values[index] - (sample_values / picked);
+      squares += residual * residual;
+    }
+    *variance += files * files * (1.0 - (picked / files)) *
+      (squares / (picked - 1.0)) / picked;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_sample_line
+*
+* Description: Prints one estimate with its 95% confidence interval.
+*
+* Parameters:  name - what was estimated.
+*              counted - total of the sampled files.
+*              estimate - estimated total of all the files.
+*              variance - variance of the estimate.
+*
+* Globals:     WKS_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_sample_line(char *name,double counted,double estimate,
+  double variance)
+{
+  double margin;
+  double low;
+
+  margin = 1.96 * sqrt(variance);
+  low = estimate - margin;
+  if (low < counted)
+    low = counted;
+
+  if (WKS_Flag)
+    printf("%s,%.0f,%.0f,%.0f,%.0f\n",name,counted,estimate,low,
+      estimate + margin);
+  else
+    printf("%-16s %12.0f %12.0f %12.0f %12.0f\n",name,counted,estimate,low,
+      estimate + margin);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_sample_estimates
+*
+* Description: Prints the totals estimated from the sampled files, with
+*              95% confidence intervals.  The comment density is the
+*              ratio of two estimates, so its interval comes from how far
+*              each sampled file is from that ratio.
+*
+* Parameters:  selected - number of files in the sample.
+*
+* Globals:     Input_List, Sample_Units, Sample_Seed_Used, WKS_Flag,
+*              WKS_Header_Flag
+*
+* Locals:      sample_estimate, print_sample_line functions.
+*
+* Return:      none
+*
+**************************************************************************/
+void print_sample_estimates(size_t selected)
+{
+  static char *names[SAMPLE_VALUES] =
+  {
+    "Logical LOC", "Physical LOC", "Comment LOC", "Functions"
+  };
+  double *values;
+  double counted[SAMPLE_VALUES];
+  double estimate[SAMPLE_VALUES];
+  double variance[SAMPLE_VALUES];
+  double density;
+  double density_variance;
+  double margin;
+  double total_bytes = 0.0;
+  size_t index;
+  int value;
+
+  values = (double *) mem_alloc(MEM_CACHES,
+    (Input_List.count + 1) * sizeof(double));
+  if (values == NULL)
+  {
+    printf("print_sample_estimates: malloc failed.\n");
+    exit(1);
+  }
+
+  for (value = 0; value < SAMPLE_VALUES; value++)
+  {
+    counted[value] = 0.0;
+    for (index = 0; index < Input_List.count; index++)
+    {
+      values[index] = (double) Sample_Units[index].values[value];
+      if (Sample_Units[index].selected)
+        counted[value] += values[index];
+    }
+    sample_estimate(values,&estimate[value],&variance[value]);
+  }
+  for (index = 0; index < Input_List.count; index++)
+    total_bytes += (double) Sample_Units[index].bytes;
+
+  /* comment density - linearized around the estimated ratio */
+  density = 0.0;
+  density_variance = 0.0;
+  if (estimate[SAMPLE_PHYSICAL] > 0.0)
+  {
+    density = estimate[SAMPLE_COMMENT] / estimate[SAMPLE_PHYSICAL];
+    for (index = 0; index < Input_List.count; index++)
+      values[index] = (double) Sample_Units[index].values[SAMPLE_COMMENT] -
+        (density * (double) Sample_Units[index].values[SAMPLE_PHYSICAL]);
+    sample_estimate(values,&margin,&density_variance);
+    density_variance /= estimate[SAMPLE_PHYSICAL] *
+      estimate[SAMPLE_PHYSICAL];
+  }
+  margin = 1.96 * sqrt(density_variance);
+
+  if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Estimate,Counted,Estimate,95%% Low,95%% High\n");
+    printf("Files,%lu,%lu,%lu,%lu\n",(unsigned long) selected,
+      (unsigned long) Input_List.count,(unsigned long) Input_List.count,
+      (unsigned long) Input_List.count);
+  }
+  else
+  {
+    printf("Sample of %lu of %lu files (%.1f%% of %.0f bytes), seed %lu\n",
+      (unsigned long) selected,(unsigned long) Input_List.count,
+      (Input_List.count > 0) ? (100.0 * (double) selected /
+      (double) Input_List.count) : 0.0,total_bytes,
+      Sample_Seed_Used);
+    printf("\n");
+    printf("Estimate              Counted     Estimate  95%% CI Low"
+           " 95%% CI High\n");
+    printf("================ ============ ============ ============"
+           " ============\n");
+  }
+  for (value = 0; value < SAMPLE_VALUES; value++)
+    print_sample_line(names[value],counted[value],estimate[value],
+      variance[value]);
+  if (WKS_Flag)
+    printf("Comment density,,%.2f%%,%.2f%%,%.2f%%\n",100.0 * density,
+      100.0 * (density - margin),100.0 * (density + margin));
+  else
+    printf("%-16s %12s %11.2f%% %11.2f%% %11.2f%%\n","Comment density"," ",
+      100.0 * density,100.0 * (density - margin),100.0 * (density + margin));
+
+  mem_free(values);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    print_duplicate
+*
+* Description: Prints a file whose contents are identical to a file that
+*              was already counted as a reference to that file instead
+*              of counting and listing its functions again.
+*
+* Parameters:  filename (IN) name of the duplicate file
+*              original (IN) name of the file that was counted
+*
+* Globals:     WKS_Flag, WKS_Header_Flag
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void print_duplicate(char *filename,char *original)
+{
+  char *str = NULL;
+  char *name = NULL;
+
+  /* Find the last token - that is the actual filename */
+  str = strtok(filename,":\\");
+  while (str != NULL)
+  {
+    name = str;
+    str = strtok(NULL,":\\");
+  }
+  if (name == NULL)
+    name = "";
+
+  if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Program Name,Function Name,Function LOC,Total LOC\n");
+    WKS_Header_Flag = FALSE;
+    printf("%s,duplicate of %s,,\n",name,original);
+  }
+  else
+  {
+    printf("Program      Function                         Function Total\n");
+    printf("Name         Name                             LOC      LOC\n");
+    printf("============ ================================ ======== ========\n");
+    printf("%s\n",name);
+    printf("%-12s duplicate of %s\n"," ",original);
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    hash_step
+*
+* Description: Continues the two hashes of a fingerprint, FNV-1a and a
+*              shift-add-xor hash, over some characters.  Used for the
+*              fingerprints of whole files and of the tokens of functions.
+*
+* Parameters:  hash_a (IN/OUT) FNV-1a hash, 2166136261 to start
+*              hash_b (IN/OUT) shift-add-xor hash, 5381 to start
+*              data (IN) characters to hash
+*              length (IN) number of characters in data
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void hash_step(unsigned long *hash_a,unsigned long *hash_b,char *data,
+  size_t length)
+{
+  unsigned long a = *hash_a;
+  unsigned long b = *hash_b;
+  unsigned char c;
+  size_t index;
+
+  for (index = 0; index < length; index++)
+  {
+    c = (unsigned char) data[index];
+    a = ((a ^ c) * 16777619UL) & 0xFFFFFFFFUL;
+    b = (b ^ ((b << 5) + (b >> 2) + c)) & 0xFFFFFFFFUL;
+  }
+
+  *hash_a = a;
+  *hash_b = b;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    fingerprint_contents
+*
+* Description: Hashes the contents of a file with hash_step.  Together
+*              with the length the two hashes find the files that may be
+*              identical, which find_fingerprint then compares byte for
+*              byte.
+*
+* Parameters:  buffer (IN) contents of the file
+*              length (IN) number of characters in buffer
+*              hash_a (OUT) FNV-1a hash of the contents
+*              hash_b (OUT) shift-add-xor hash of the contents
+*
+* Globals:     none
+*
+* Locals:      hash_step function.
+*
+* Return:      none
+*
+**************************************************************************/
+void fingerprint_contents(char *buffer,size_t length,
+  unsigned long *hash_a,unsigned long *hash_b)
+{
+  *hash_a = 2166136261UL;  /* FNV-1a offset basis */
+  *hash_b = 5381UL;
+  hash_step(hash_a,hash_b,buffer,length);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    find_fingerprint
+*
+* Description: Looks up the fingerprint of some file contents.  A file
+*              with the same fingerprint is only taken to have the same
+*              contents if they are the same byte for byte.  If the
+*              contents have not been seen before, the fingerprint is
+*              remembered along with the filename, and with a copy of the
+*              contents if they can not be read again.  The buckets are
+*              doubled whenever there are more fingerprints than buckets,
+*              so the chains stay short however many files there are.
+*
+* Parameters:  hash_a (IN) FNV-1a hash of the contents
+*              hash_b (IN) shift-add-xor hash of the contents
+*              length (IN) number of characters in the contents
+*              filename (IN) name of the file
+*              buffer (IN) the contents, or NULL to read them from filename
+*              member (IN) TRUE if the contents can not be read again from
+*                  filename, as for an archive member
+*
+* Globals:     Fingerprint_Table - hash buckets of fingerprints
+*              Fingerprint_Buckets, Fingerprint_Count
+*
+* Locals:      contents_differ function.
+*
+* Return:      the fingerprint of the first file with the same contents,
+*              or NULL if these are new contents.
+*
+**************************************************************************/
+FINGERPRINT *find_fingerprint(unsigned long hash_a,unsigned long hash_b,
+  size_t length,char *filename,char *buffer,int member)
+{
+  FINGERPRINT **buckets;
+  FINGERPRINT *p;
+  FINGERPRINT *next;
+  size_t bucket_count;
+  size_t bucket;
+  size_t index;
+
+  if (Fingerprint_Buckets > 0)
+  {
+    bucket = (size_t) (hash_a & (Fingerprint_Buckets - 1));
+    for (p = Fingerprint_Table[bucket]; p != NULL; p = p->next)
+    {
+      if ((p->hash_a == hash_a) &&
+          (p->hash_b == hash_b) &&
+          (p->length == length) &&
+          !contents_differ(p,filename,buffer,length))
+        return p;
+    }
+  }
+
+  if ((Fingerprint_Count + 1) > Fingerprint_Buckets)
+  {
+    bucket_count = (Fingerprint_Buckets == 0) ? 1024 :
+      (Fingerprint_Buckets * 2);
+    buckets = (FINGERPRINT **) mem_calloc(MEM_CACHES,bucket_count,
+      sizeof(FINGERPRINT *));
+    if (buckets == NULL)
+    {
+      printf("find_fingerprint: malloc failed.\n");
+      exit(1);
+    }
+    for (index = 0; index < Fingerprint_Buckets; index++)
+    {
+      for (p = Fingerprint_Table[index]; p != NULL; p = next)
+      {
+        next = p->next;
+        bucket = (size_t) (p->hash_a & (bucket_count - 1));
+        p->next = buckets[bucket];
+        buckets[bucket] = p;
+      }
+    }
+    mem_free(Fingerprint_Table);
+    Fingerprint_Table = buckets;
+    Fingerprint_Buckets = bucket_count;
+  }
+
+  p = (FINGERPRINT *) mem_alloc(MEM_CACHES,sizeof(FINGERPRINT));
+  if (p != NULL)
+    p->filename = (char *) mem_alloc(MEM_CACHES,strlen(filename) + 1);
+  if ((p == NULL) || (p->filename == NULL))
+  {
+    printf("find_fingerprint: malloc failed.\n");
+    exit(1);
+  }
+  strcpy(p->filename,filename);
+  p->contents = NULL;
+  p->logged = (buffer == NULL);
+  if (member && (buffer != NULL))
+  {
+    p->contents = (char *) mem_alloc(MEM_CACHES,length + 1);
+    if (p->contents == NULL)
+    {
+      printf("find_fingerprint: malloc failed.\n");
+      exit(1);
+    }
+    memcpy(p->contents,buffer,length);
+  }
+  p->hash_a = hash_a;
+  p->hash_b = hash_b;
+  p->length = length;
+  bucket = (size_t) (hash_a & (Fingerprint_Buckets - 1));
+  p->next = Fingerprint_Table[bucket];
+  Fingerprint_Table[bucket] = p;
+  Fingerprint_Count++;
+
+  return NULL;
+}
+
+/**************************************************************************
+*
+* Function:    contents_differ
+*
+* Description: Compares some contents with those a fingerprint was
+*              first found with - the copy kept of an archive member, or
+*              else the file read again - so that two files whose
+*              fingerprints match by chance are not taken for copies.
+*              The files are read the same way as they are for counting,
+*              and nothing is printed if one can not be.  When a run is
+*              resumed or shards are merged the contents of the inputs
+*              in the logs were not kept, so if either of the two is
+*              from a log and can not be read the fingerprint is trusted.
+*
+* Parameters:  original - fingerprint the contents were first found with.
+*              filename - name of the file with the same fingerprint.
+*              buffer - the contents of filename, or NULL if they are
+*                  from a log, to read them.
+*              length - number of characters in the contents.
+*
+* Globals:     none
+*
+* Locals:      read_stream function.
+*
+* Return:      TRUE if the contents differ or the original can not be
+*              read, FALSE if they are the same.
+*
+**************************************************************************/
+int contents_differ(FINGERPRINT *original,char *filename,char *buffer,
+  size_t length)
+{
+  FILE *fp;
+  char *first = original->contents;   /* contents of the original */
+  char *second = buffer;              /* contents of filename */
+  size_t first_length = original->length;
+  size_t second_length = length;
+  int differ = TRUE;
+
+  if (first == NULL)
+  {
+    fp = fopen(original->filename,"r");
+    if (fp != NULL)
+    {
+      first = read_stream(fp,&first_length);
+      fclose(fp);
+    }
+  }
+  if (second == NULL)
+  {
+    fp = fopen(filename,"r");
+    if (fp != NULL)
+    {
+      second = read_stream(fp,&second_length);
+      fclose(fp);
+    }
+  }
+  if ((first != NULL) && (second != NULL))
+    differ = (first_length != second_length) ||
+      (memcmp(first,second,first_length) != 0);
+  else if ((buffer == NULL) || original->logged)
+    differ = FALSE;
+
+  if (first != original->contents)
+    mem_free(first);
+  if (second != buffer)
+    mem_free(second);
+
+  return differ;
+}
+
+/**************************************************************************
+*
+* Function:    delete_fingerprints
+*
+* Description: De-allocates memory for all of the fingerprints.
+*
+* Parameters:  none
+*
+* Globals:     Fingerprint_Table - hash buckets of fingerprints
+*              Fingerprint_Buckets, Fingerprint_Count
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_fingerprints(void)
+{
+  FINGERPRINT *current;
+  FINGERPRINT *next;
+  size_t bucket;
+
+  for (bucket = 0; bucket < Fingerprint_Buckets; bucket++)
+  {
+    current = Fingerprint_Table[bucket];
+    while (current != NULL)
+    {
+      next = current->next;
+      mem_free(current->filename);
+      mem_free(current->contents);
+      mem_free(current);
+      current = next;
+    }
+  }
+  mem_free(Fingerprint_Table);
+  Fingerprint_Table = NULL;
+  Fingerprint_Buckets = 0;
+  Fingerprint_Count = 0;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    last_element
+*
+* Description: Returns a pointer to the last element of the list. If the
+*              list is empty, it returns the NULL pointer.
+*
+* Parameters:  none
+*
+* Globals:     none
+*
+* Locals:      typedef of ELEMENT.
+*              head - first ELEMENT of the linked list
+*
+* Return:      p - pointer to the last element.
+*
+**************************************************************************/
+ELEMENT *last_element(void)
+{
+  ELEMENT *p;
+
+  /* if the first element has not been created, return NULL */
+  if (head == NULL)
+  {
+    p = head;
+  }
+
+  /* otherwise, find the last element in the list */
+  else
+  {
+    for (p=head;p->next != NULL;p=p->next) {}
+  }
+
+  return p;
+} /* end of function */
+
+/**************************************************************************
+*
+* Function:    open_input_file
+*
+* Description: Opens a file stream for input (read only) and returns a 
+*              file pointer to that stream.
+*
+* Parameters:  filename - string containing the name of the file to be
+*                         opened.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      fp - pointer to the stream of the file opened.
+*
+**************************************************************************/
+FILE *open_input_file(char *filename)
+{
+  FILE *fp;
+
+  fp = fopen(filename,"r");
+  if (fp == NULL)
+    printf("open_input_file: error opening %s.\n",filename);
+
+  return fp;
+}
+
+/**************************************************************************
+*
+* Function:    read_input_file
+*
+* Description: Reads the whole of a file into memory so that it can be
+*              fingerprinted and counted without going back to the disk.
+*
+* Parameters:  filename - string containing the name of the file to be
+*                         read.
+*              length - reference to the number of characters read.
+*
+* Globals:     none
+*
+* Locals:      open_input_file, read_stream functions.
+*
+* Return:      buffer - pointer to the memory holding the file contents
+*                       which the caller frees, or NULL on error.
+*
+**************************************************************************/
+char *read_input_file(char *filename,size_t *length)
+{
+  FILE *fp;               /* C program file stream */
+  char *buffer = NULL;    /* contents of the file */
+
+  *length = 0;
+  fp = open_input_file(filename);
+  if (fp == NULL)
+    return NULL;
+
+  buffer = read_stream(fp,length);
+  if (buffer == NULL)
+    printf("read_input_file: error reading %s.\n",filename);
+  fclose(fp);
+
+  return buffer;
+}
+
+/**************************************************************************
+*
+* Function:    read_stream
+*
+* Description: Reads a stream into memory until the end of the stream.
+*              The size of a file on disk may not match the size read in
+*              text mode, and a pipe has no size, so the buffer grows
+*              until the end of the stream is found.
+*
+* Parameters:  fp - stream to be read.
+*              length - reference to the number of characters read.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      buffer - pointer to the memory holding the contents of the
+*                       stream which the caller frees, or NULL on error.
+*
+**************************************************************************/
+char *read_stream(FILE *fp,size_t *length)
+{
+  char *buffer = NULL;    /* contents of the stream */
+  char *larger = NULL;    /* reallocated buffer */
+  size_t size = 0;        /* memory allocated for buffer */
+  size_t count = 0;       /* characters read so far */
+  size_t bytes = 0;       /* characters read on this pass */
+
+  do
+  {
+    /* always leave room for a NUL after the contents */
+    if ((count + 1) >= size)
+    {
+      size = (size == 0) ? 4096 : (size * 2);
+      larger = (char *) mem_realloc(MEM_BUFFERS,buffer,size);
+      if (larger == NULL)
+      {
+        printf("read_stream: malloc failed.\n");
+        exit(1);
+      }
+      buffer = larger;
+    }
+    bytes = fread(buffer + count,1,size - count - 1,fp);
+    count += bytes;
+  } while (bytes > 0);
+
+  if (ferror(fp))
+  {
+    mem_free(buffer);
+    *length = 0;
+    return NULL;
+  }
+  buffer[count] = 0;
+  *length = count;
+
+  return buffer;
+}
+
+/**************************************************************************
+*
+* Function:    has_suffix
+*
+* Description: Checks the end of a string for a suffix, ignoring case.
+*
+* Parameters:  string - reference to the string to be checked.
+*              suffix - reference to the ending to look for.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      TRUE if string ends with suffix, FALSE if not.
+*
+**************************************************************************/
+int has_suffix(char *string,char *suffix)
+{
+  size_t string_len = strlen(string);
+  size_t suffix_len = strlen(suffix);
+
+  if (suffix_len > string_len)
+    return FALSE;
+
+  return (stricmp(string + string_len - suffix_len,suffix) == 0);
+}
+
+/**************************************************************************
+*
+* Function:    is_source_file
+*
+* Description: Checks the extension of a filename to see if it is a
+*              C or C++ source or header file.
+*
+* Parameters:  filename - reference to the name of the file.
+*
+* Globals:     none
+*
+* Locals:      has_suffix function.
+*
+* Return:      TRUE if the file is C or C++ source, FALSE if not.
+*
+**************************************************************************/
+int is_source_file(char *filename)
+{
+  static char *extensions[] =
+  {
+    ".c", ".h", ".cc", ".cp", ".cpp", ".cxx", ".c++",
+    ".hh", ".hpp", ".hxx", ".h++", ".inl"
+  };
+  size_t index;
+
+  for (index = 0; index < sizeof(extensions)/sizeof(extensions[0]); index++)
+  {
+    if (has_suffix(filename,extensions[index]))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**************************************************************************
+*
+* Function:    archive_type
+*
+* Description: Uses the extension of a filename to tell if it is a tar
+*              archive, and which decompressor it needs.
+*
+* Parameters:  filename - reference to the name of the file.
+*
+* Globals:     none
+*
+* Locals:      has_suffix function.
+*
+* Return:      ARCHIVE_TAR, ARCHIVE_TAR_GZIP, ARCHIVE_TAR_ZSTD, or
+*              ARCHIVE_NONE if the file is not an archive.
+*
+**************************************************************************/
+int archive_type(char *filename)
+{
+  if (has_suffix(filename,".tar"))
+    return ARCHIVE_TAR;
+  if (has_suffix(filename,".tar.gz") || has_suffix(filename,".tgz"))
+    return ARCHIVE_TAR_GZIP;
+  if (has_suffix(filename,".tar.zst") || has_suffix(filename,".tzst"))
+    return ARCHIVE_TAR_ZSTD;
+
+  return ARCHIVE_NONE;
+}
+
+/**************************************************************************
+*
+* Function:    shell_command
+*
+* Description: Builds a command line from a program and a single argument,
+*              quoting the argument so that the shell passes it unchanged.
+*
+* Parameters:  program - reference to the program and any options.
+*              argument - reference to the argument to be quoted.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      command - memory holding the command, which the caller frees.
+*
+**************************************************************************/
+char *shell_command(char *program,char *argument)
+{
+  char *command;
+  char *p;
+
+  /* worst case every character of the argument needs escaping */
+  command = (char *) mem_alloc(MEM_BUFFERS,
+    strlen(program) + (strlen(argument) * 4) + 4);
+  if (command == NULL)
+  {
+    printf("shell_command: malloc failed.\n");
+    exit(1);
+  }
+
+  p = command + sprintf(command,"%s ",program);
+#if defined(_WIN32)
+  *p++ = '"';
+  while (*argument)
+    *p++ = *argument++;
+  *p++ = '"';
+#else
+  *p++ = '\'';
+  while (*argument)
+  {
+    if (*argument == '\'')
+    {
+      /* close the quote, add an escaped quote, and open it again */
+      strcpy(p,"'\\''");
+      p += 4;
+    }
+    else
+      *p++ = *argument;
+    argument++;
+  }
+  *p++ = '\'';
+#endif
+  *p = 0;
+
+  return command;
+}
+
+/**************************************************************************
+*
+* Function:    open_archive
+*
+* Description: Opens a tar archive for reading.  A compressed archive is
+*              read from the output of its decompressor, which runs as a
+*              separate process so that decompressing overlaps counting.
+*              Without HAVE_POPEN only a plain tar archive can be read.
+*
+* Parameters:  filename - reference to the name of the archive.
+*              type - kind of archive from archive_type.
+*
+* Globals:     none
+*
+* Locals:      shell_command function.
+*
+* Return:      fp - stream holding the tar data, or NULL on error.
+*
+**************************************************************************/
+FILE *open_archive(char *filename,int type)
+{
+  FILE *fp = NULL;
+  char *command = NULL;
+
+  switch (type)
+  {
+    case ARCHIVE_TAR:
+      fp = fopen(filename,"rb");
+      break;
+    case ARCHIVE_TAR_GZIP:
+      command = shell_command("gzip -dc",filename);
+      break;
+    case ARCHIVE_TAR_ZSTD:
+      command = shell_command("zstd -dc",filename);
+      break;
+    default:
+      break;
+  }
+
+  if (command != NULL)
+  {
+#if defined(HAVE_POPEN)
+    fflush(stdout);
+    fp = popen(command,POPEN_READ);
+#else
+    printf("open_archive: compressed archives are not supported on this "
+      "platform.\n");
+#endif
+    mem_free(command);
+  }
+
+  return fp;
+}
+
+/**************************************************************************
+*
+* Function:    close_archive
+*
+* Description: Closes a stream opened with open_archive.
+*
+* Parameters:  fp - stream holding the tar data.
+*              type - kind of archive from archive_type.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      0 on success, or non-zero if the decompressor failed.
+*
+**************************************************************************/
+int close_archive(FILE *fp,int type)
+{
+  if (type == ARCHIVE_TAR)
+    return fclose(fp);
+
+  return pclose(fp);
+}
+
+/**************************************************************************
+*
+* Function:    tar_number
+*
+* Description: Converts a numeric field of a tar header, which is either
+*              octal text or (for large values) GNU base-256 binary.
+*
+* Parameters:  field - reference to the header field.
+*              size - number of characters in the field.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      value of the field, or TAR_NUMBER_BAD if it does not fit
+*              in an unsigned long.
+*
+**************************************************************************/
+unsigned long tar_number(char *field,size_t size)
+{
+  unsigned long value = 0;
+  size_t index = 0;
+
+  /* base-256 - the first byte has its high bit set */
+  if ((unsigned char) field[0] & 0x80)
+  {
+    value = (unsigned char) field[0] & 0x7F;
+    for (index = 1; index < size; index++)
+    {
+      if (value > (ULONG_MAX >> 8))
+        return TAR_NUMBER_BAD;
+      value = (value << 8) | (unsigned char) field[index];
+    }
+    return value;
+  }
+
+  while ((index < size) && (field[index] == ' '))
+    index++;
+  while ((index < size) && (field[index] >= '0') && (field[index] <= '7'))
+  {
+    if (value > (ULONG_MAX >> 3))
+      return TAR_NUMBER_BAD;
+    value = (value * 8) + (field[index] - '0');
+    index++;
+  }
+
+  return value;
+}
+
+/**************************************************************************
+*
+* Function:    skip_archive_bytes
+*
+* Description: Reads past data in an archive stream.  The stream may be a
+*              pipe, so the data is read rather than seeked over.
+*
+* Parameters:  fp - stream holding the tar data.
+*              count - number of characters to skip.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      TRUE if all of the characters were skipped, FALSE at EOF.
+*
+**************************************************************************/
+int skip_archive_bytes(FILE *fp,unsigned long count)
+{
+  char block[TAR_BLOCK_SIZE];
+  size_t bytes;
+
+  while (count > 0)
+  {
+    bytes = (count > TAR_BLOCK_SIZE) ? TAR_BLOCK_SIZE : (size_t) count;
+    if (fread(block,1,bytes,fp) != bytes)
+      return FALSE;
+    count -= bytes;
+  }
+
+  return TRUE;
+}
+
+/**************************************************************************
+*
+* Function:    read_archive_member
+*
+* Description: Reads the data of a tar member into memory and skips the
+*              padding up to the next header.  A member larger than the
+*              limit is not read, as its size may be damaged.
+*
+* Parameters:  fp - stream holding the tar data.
+*              size - number of characters in the member.
+*              limit - most characters that may be read, at most
+*                  TAR_MEMBER_MAX.
+*
+* Globals:     none
+*
+* Locals:      skip_archive_bytes function.
+*
+* Return:      buffer - memory holding the member data with a NUL after
+*                       it, which the caller frees, or NULL at EOF or if
+*                       the member is over the limit.
+*
+**************************************************************************/
+char *read_archive_member(FILE *fp,unsigned long size,unsigned long limit)
+{
+  char *buffer;
+  unsigned long padding;
+
+  /* the limit also keeps size + 1 from wrapping */
+  if ((size > limit) || (size > TAR_MEMBER_MAX))
+    return NULL;
+
+  buffer = (char *) mem_alloc(MEM_BUFFERS,(size_t) size + 1);
+  if (buffer == NULL)
+  {
+    printf("read_archive_member: malloc failed.\n");
+    exit(1);
+  }
+
+  padding = (TAR_BLOCK_SIZE - (size % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE;
+  if ((fread(buffer,1,(size_t) size,fp) != (size_t) size) ||
+      !skip_archive_bytes(fp,padding))
+  {
+    mem_free(buffer);
+    return NULL;
+  }
+  buffer[size] = 0;
+
+  return buffer;
+}
+
+/**************************************************************************
+*
+* Function:    pax_path
+*
+* Description: Finds the path record in the data of a pax extended header.
+*              Each record has the form "length keyword=value\n".
+*
+* Parameters:  data - reference to the extended header data.
+*              size - number of characters in data.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      path - memory holding the path, which the caller frees,
+*                     or NULL if there is no path record.
+*
+**************************************************************************/
+char *pax_path(char *data,unsigned long size)
+{
+  char *path = NULL;
+  unsigned long offset = 0;
+  unsigned long length;
+  unsigned long value;
+  unsigned long index;
+
+  while (offset < size)
+  {
+    length = 0;
+    for (index = offset; (index < size) &&
+         (char_class(data[index]) & CHAR_DIGIT); index++)
+      length = (length * 10) + (data[index] - '0');
+    if ((length == 0) || ((offset + length) > size))
+      break;
+    /* skip the space after the length - a record that has no room for
+       its value and newline is skipped */
+    index++;
+    if (((index + 5) < (offset + length)) &&
+        (data[offset + length - 1] == '\n') &&
+        (strncmp(data + index,"path=",5) == 0))
+    {
+      value = index + 5;
+      path = (char *) mem_realloc(MEM_BUFFERS,path,
+        (size_t) (offset + length - value));
+      if (path == NULL)
+      {
+        printf("pax_path: malloc failed.\n");
+        exit(1);
+      }
+      /* the value ends just before the newline */
+      memcpy(path,data + value,(size_t) (offset + length - value - 1));
+      path[offset + length - value - 1] = 0;
+    }
+    offset += length;
+  }
+
+  return path;
+}
+
+/**************************************************************************
+*
+* Function:    count_archive
+*
+* Description: Counts the C and C++ source files inside a tar archive,
+*              which may be compressed with gzip or zstd.  Each member is
+*              read straight from the archive stream into memory and
+*              counted as if it were a file named archive:member.
+*
+* Parameters:  filename - reference to the name of the archive.
+*
+* Globals:     none
+*
+* Locals:      count_contents function.
+*
+* Return:      0 if the archive was counted, 1 on error.
+*
+**************************************************************************/
+int count_archive(char *filename)
+{
+  FILE *fp;                       /* tar data stream */
+  char header[TAR_BLOCK_SIZE];    /* header of the current member */
+  char name[256];                 /* prefix and name from the header */
+  char *long_name = NULL;         /* name from a GNU or pax header */
+  char *member_name;              /* name of the current member */
+  char *display_name;             /* archive:member */
+  char *buffer;                   /* member data */
+  unsigned long size;             /* size of the member data */
+  unsigned long checksum;         /* header checksum */
+  unsigned long sum;              /* calculated header checksum */
+  int type;                       /* kind of archive */
+  int index;
+  int status = 0;
+
+  type = archive_type(filename);
+  fp = open_archive(filename,type);
+  if (fp == NULL)
+  {
+    printf("count_archive: error opening %s.\n",filename);
+    return (1);
+  }
+
+  while (fread(header,1,TAR_BLOCK_SIZE,fp) == TAR_BLOCK_SIZE)
+  {
+    /* an empty block marks the end of the archive */
+    if (header[0] == 0)
+      break;
+
+    /* the checksum treats its own field as spaces */
+    checksum = tar_number(header + 148,8);
+    sum = 0;
+    for (index = 0; index < TAR_BLOCK_SIZE; index++)
+    {
+      if ((index >= 148) && (index < 156))
+        sum += ' ';
+      else
+        sum += (unsigned char) header[index];
+    }
+    if (sum != checksum)
+    {
+      printf("count_archive: %s is not a tar archive.\n",filename);
+      status = 1;
+      break;
+    }
+
+    size = tar_number(header + 124,12);
+    /* the size and its padding must fit in an unsigned long, and a
+       long name or pax header is never near the size of a file */
+    if ((size > (TAR_NUMBER_BAD - TAR_BLOCK_SIZE)) ||
+        (((header[156] == 'L') || (header[156] == 'x')) &&
+         (size > TAR_HEADER_MAX)))
+    {
+      printf("count_archive: %s has a damaged header.\n",filename);
+      status = 1;
+      break;
+    }
+    switch (header[156])
+    {
+      /* GNU long name or pax extended header for the next member */
+      case 'L':
+      case 'x':
+        buffer = read_archive_member(fp,size,TAR_HEADER_MAX);
+        if (buffer == NULL)
+          break;
+        mem_free(long_name);
+        if (header[156] == 'L')
+          long_name = buffer;
+        else
+        {
+          long_name = pax_path(buffer,size);
+          mem_free(buffer);
+        }
+        continue;
+
+      /* regular file */
+      case '0':
+      case '\0':
+      case '7':
+        if (long_name != NULL)
+          member_name = long_name;
+        else
+        {
+          name[0] = 0;
+          /* ustar splits long names into a prefix and a name */
+          if ((strncmp(header + 257,"ustar",5) == 0) && (header[345] != 0))
+            sprintf(name,"%.155s/",header + 345);
+          sprintf(name + strlen(name),"%.100s",header);
+          member_name = name;
+        }
+        if (is_source_file(member_name) && (size > TAR_MEMBER_MAX))
+        {
+          /* too large to read into memory - it is passed over */
+          printf("count_archive: %s:%s is too large to count.\n",filename,
+            member_name);
+          status = 1;
+          if (!skip_archive_bytes(fp,size +
+            ((TAR_BLOCK_SIZE - (size % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE)))
+            break;
+        }
+        else if (is_source_file(member_name))
+        {
+          if (Perf_Flag)
+            perf_phase(PERF_READ);
+          buffer = read_archive_member(fp,size,TAR_MEMBER_MAX);
+          if (buffer == NULL)
+            break;
+          display_name = (char *) mem_alloc(MEM_PATHS,strlen(filename) +
+            strlen(member_name) + 2);
+          if (display_name == NULL)
+          {
+            printf("count_archive: malloc failed.\n");
+            exit(1);
+          }
+          sprintf(display_name,"%s:%s",filename,member_name);
+          count_contents(display_name,buffer,(size_t) size,TRUE);
+          mem_free(display_name);
+          mem_free(buffer);
+        }
+        else if (!skip_archive_bytes(fp,size +
+          ((TAR_BLOCK_SIZE - (size % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE)))
+          break;
+        mem_free(long_name);
+        long_name = NULL;
+        continue;
+
+      /* directories, links, devices and anything else */
+      default:
+        if (skip_archive_bytes(fp,size +
+          ((TAR_BLOCK_SIZE - (size % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE)))
+        {
+          mem_free(long_name);
+          long_name = NULL;
+          continue;
+        }
+        break;
+    }
+
+    /* only a truncated member gets here */
+    printf("count_archive: %s is truncated.\n",filename);
+    status = 1;
+    break;
+  }
+  mem_free(long_name);
+
+  /* drain the stream so the decompressor is not cut off part way */
+  if (type != ARCHIVE_TAR)
+  {
+    while (fread(header,1,TAR_BLOCK_SIZE,fp) > 0)
+    {
+    }
+  }
+  if ((close_archive(fp,type) != 0) && (status == 0))
+  {
+    printf("count_archive: error reading %s.\n",filename);
+    status = 1;
+  }
+
+  return (status);
+}
+
+/**************************************************************************
+*
+* Function:    read_command
+*
+* Description: Runs a command and reads all of its output into memory.
+*
+* Parameters:  command - reference to the command line to run.
+*              length - reference to the number of characters read.
+*
+* Globals:     none
+*
+* Locals:      read_stream function.
+*
+* Return:      buffer - memory holding the output, which the caller frees,
+*                       or NULL if the command could not be run or failed.
+*
+**************************************************************************/
+char *read_command(char *command,size_t *length)
+{
+  FILE *fp;
+  char *buffer;
+
+  *length = 0;
+  fflush(stdout);
+  fp = popen(command,POPEN_READ);
+  if (fp == NULL)
+    return NULL;
+
+  buffer = read_stream(fp,length);
+  if ((pclose(fp) != 0) && (buffer != NULL))
+  {
+    mem_free(buffer);
+    buffer = NULL;
+    *length = 0;
+  }
+
+  return buffer;
+}
+
+/**************************************************************************
+*
+* Function:    open_git_blob
+*
+* Description: Starts reading a file at a revision from the object store
+*              of the local git repository.
+*
+* Parameters:  revision - reference to the commit to read from.
+*              path - reference to the path of the file in the commit.
+*
+* Globals:     none
+*
+* Locals:      shell_command function.
+*
+* Return:      fp - stream holding the file contents, or NULL on error.
+*
+**************************************************************************/
+FILE *open_git_blob(char *revision,char *path)
+{
+  FILE *fp;
+  char *object;
+  char *command;
+
+  /* the object name is revision:path */
+  object = (char *) mem_alloc(MEM_BUFFERS,strlen(revision) + strlen(path) + 2);
+  if (object == NULL)
+  {
+    printf("open_git_blob: malloc failed.\n");
+    exit(1);
+  }
+  sprintf(object,"%s:%s",revision,path);
+  command = shell_command("git cat-file blob",object);
+  mem_free(object);
+
+  fflush(stdout);
+  fp = popen(command,POPEN_READ);
+  mem_free(command);
+
+  return fp;
+}
+
+/**************************************************************************
+*
+* Function:    read_git_blob
+*
+* Description: Reads the contents of a file started with open_git_blob.
+*
+* Parameters:  fp - stream from open_git_blob, or NULL.
+*              revision - reference to the commit, for error messages.
+*              path - reference to the path, for error messages.
+*              length - reference to the number of characters read.
+*
+* Globals:     none
+*
+* Locals:      read_stream function.
+*
+* Return:      buffer - memory holding the file contents, which the caller
+*                       frees, or NULL on error.
+*
+**************************************************************************/
+char *read_git_blob(FILE *fp,char *revision,char *path,size_t *length)
+{
+  char *buffer = NULL;
+
+  *length = 0;
+  if (fp != NULL)
+  {
+    buffer = read_stream(fp,length);
+    if ((pclose(fp) != 0) && (buffer != NULL))
+    {
+      mem_free(buffer);
+      buffer = NULL;
+      *length = 0;
+    }
+  }
+  if (buffer == NULL)
+    printf("read_git_blob: error reading %s:%s.\n",revision,path);
+
+  return buffer;
+}
+
+/**************************************************************************
+*
+* Function:    count_version
+*
+* Description: Counts one version of a file and takes its list of
+*              functions away from head so that two versions can be
+*              compared.
+*
+* Parameters:  buffer - C program text to be counted, or NULL if the file
+*                       does not exist in this version.
+*              length - number of characters in buffer.
+*              counts - reference to the totals for the buffer.
+*
+* Globals:     none
+*
+* Locals:      head - first ELEMENT of the linked list
+*
+* Return:      list - first ELEMENT of the functions in this version,
+*                     which the caller deletes with delete_list.
+*
+**************************************************************************/
+ELEMENT *count_version(char *buffer,size_t length,FILE_COUNTS *counts)
+{
+  ELEMENT *list;
+
+  if (buffer == NULL)
+  {
+    counts->loc_count = 0;
+    counts->physical_loc = 0;
+    counts->comment_loc = 0;
+    return NULL;
+  }
+
+  if (Perf_Flag)
+  {
+    perf_phase(PERF_LEX);
+    Perf.bytes += (unsigned long) length;
+  }
+  count_buffer(buffer,length,counts);
+  list = head;
+  head = NULL;
+
+  return list;
+}
+
+/**************************************************************************
+*
+* Function:    git_diff
+*
+* Description: Counts only the C and C++ files that changed between two
+*              commits of the local git repository, and prints the change
+*              in logical lines of code of each function.  Both versions
+*              are read straight from the git object store, so the working
+*              tree and unchanged files are never read.
+*
+* Parameters:  range - reference to the commits as "old..new".  An empty
+*                      side of the range means HEAD.
+*
+* Globals:     none
+*
+* Locals:      read_command, open_git_blob, count_version functions.
+*
+* Return:      0 if every changed file was counted, 1 on error.
+*
+**************************************************************************/
+int git_diff(char *range)
+{
+  char *old_rev;            /* commit before the change */
+  char *new_rev;            /* commit after the change */
+  char *separator;          /* the .. in the range */
+  char *command;
+  char *changes;            /* NUL separated status and path pairs */
+  size_t changes_len = 0;
+  size_t offset = 0;
+  char *change;             /* status letter of a changed file */
+  char *path;               /* path of a changed file */
+  FILE *old_fp;
+  FILE *new_fp;
+  char *old_buffer;
+  char *new_buffer;
+  size_t old_len;
+  size_t new_len;
+  ELEMENT *old_list;
+  ELEMENT *new_list;
+  FILE_COUNTS old_counts;
+  FILE_COUNTS new_counts;
+  int status = 0;
+
+#if !defined(HAVE_POPEN)
+  printf("git_diff: --git-diff is not supported on this platform.\n");
+  return (1);
+#endif
+  separator = strstr(range,"..");
+  if ((separator == NULL) || (separator[2] == '.'))
+  {
+    printf("git_diff: expected a range of the form old..new.\n");
+    return (1);
+  }
+  old_rev = (char *) mem_alloc(MEM_PATHS,strlen(range) + 6);
+  new_rev = (char *) mem_alloc(MEM_PATHS,strlen(range) + 6);
+  if ((old_rev == NULL) || (new_rev == NULL))
+  {
+    printf("git_diff: malloc failed.\n");
+    exit(1);
+  }
+  sprintf(old_rev,"%.*s",(int) (separator - range),range);
+  strcpy(new_rev,separator + 2);
+  if (old_rev[0] == 0)
+    strcpy(old_rev,"HEAD");
+  if (new_rev[0] == 0)
+    strcpy(new_rev,"HEAD");
+
+  /* ask git which files changed - renames are a delete and an add */
+  if (Perf_Flag)
+    perf_phase(PERF_READ);
+  command = shell_command("git diff --name-status --no-renames -z",range);
+  changes = read_command(command,&changes_len);
+  mem_free(command);
+  if (changes == NULL)
+  {
+    printf("git_diff: error running git diff %s.\n",range);
+    mem_free(old_rev);
+    mem_free(new_rev);
+    return (1);
+  }
+
+  print_diff_header();
+  while (offset < changes_len)
+  {
+    change = changes + offset;
+    offset += strlen(change) + 1;
+    if (offset >= changes_len)
+      break;
+    path = changes + offset;
+    offset += strlen(path) + 1;
+    if (!is_source_file(path))
+      continue;
+    set_dialect(path);
+
+    /* start git on both versions before reading either of them */
+    if (Perf_Flag)
+      perf_phase(PERF_READ);
+    old_fp = (change[0] != 'A') ? open_git_blob(old_rev,path) : NULL;
+    new_fp = (change[0] != 'D') ? open_git_blob(new_rev,path) : NULL;
+    old_buffer = NULL;
+    new_buffer = NULL;
+    old_len = 0;
+    new_len = 0;
+    if (change[0] != 'A')
+    {
+      old_buffer = read_git_blob(old_fp,old_rev,path,&old_len);
+      if (old_buffer == NULL)
+        status = 1;
+    }
+    if (change[0] != 'D')
+    {
+      new_buffer = read_git_blob(new_fp,new_rev,path,&new_len);
+      if (new_buffer == NULL)
+        status = 1;
+    }
+
+    old_list = count_version(old_buffer,old_len,&old_counts);
+    new_list = count_version(new_buffer,new_len,&new_counts);
+    if (Perf_Flag)
+      perf_phase(PERF_OUTPUT);
+    print_function_diff(path,old_list,new_list,
+      old_counts.loc_count,new_counts.loc_count);
+
+    if (Perf_Flag)
+      perf_phase(PERF_OTHER);
+    delete_list(old_list);
+    delete_list(new_list);
+    mem_free(old_buffer);
+    mem_free(new_buffer);
+  }
+
+  mem_free(changes);
+  mem_free(old_rev);
+  mem_free(new_rev);
+
+  return (status);
+}
+
+/**************************************************************************
+*
+* Function:    add_file_name
+*
+* Description: Adds a copy of a filename to the end of a list of files.
+*
+* Parameters:  list - reference to the list of files.
+*              name - reference to the filename.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void add_file_name(FILE_LIST *list,char *name)
+{
+  char **larger;
+
+  if (list->count == list->size)
+  {
+    list->size = (list->size == 0) ? 64 : (list->size * 2);
+    larger = (char **) mem_realloc(MEM_PATHS,list->names,
+      list->size * sizeof(char *));
+    if (larger == NULL)
+    {
+      printf("add_file_name: malloc failed.\n");
+      exit(1);
+    }
+    list->names = larger;
+  }
+
+  list->names[list->count] = (char *) mem_alloc(MEM_PATHS,strlen(name) + 1);
+  if (list->names[list->count] == NULL)
+  {
+    printf("add_file_name: malloc failed.\n");
+    exit(1);
+  }
+  strcpy(list->names[list->count],name);
+  list->count++;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    add_input_name
+*
+* Description: Adds a name from the command line to a list of files.  A
+*              directory adds all of the C and C++ files below it, sorted
+*              by name so that every run counts them in the same order.
+*
+* Parameters:  list - reference to the list of files.
+*              name - reference to the file or directory name.
+*
+* Globals:     none
+*
+* Locals:      walk_directory function.
+*
+* Return:      none
+*
+**************************************************************************/
+void add_input_name(FILE_LIST *list,char *name)
+{
+  size_t first;
+
+  if (is_directory(name))
+  {
+    first = list->count;
+    walk_directory(list,name);
+    qsort(list->names + first,list->count - first,sizeof(char *),
+      compare_file_names);
+  }
+  else
+    add_file_name(list,name);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    delete_file_list
+*
+* Description: De-allocates memory for a list of files.
+*
+* Parameters:  list - reference to the list of files.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_file_list(FILE_LIST *list)
+{
+  size_t index;
+
+  for (index = 0; index < list->count; index++)
+    mem_free(list->names[index]);
+  mem_free(list->names);
+  list->names = NULL;
+  list->count = 0;
+  list->size = 0;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    compare_file_names
+*
+* Description: qsort comparison of two filenames in a FILE_LIST.
+*
+* Parameters:  a, b - references to the filename pointers.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      less than, equal to, or greater than zero as strcmp.
+*
+**************************************************************************/
+int compare_file_names(const void *a,const void *b)
+{
+  return strcmp(*(char * const *) a,*(char * const *) b);
+}
+
+/**************************************************************************
+*
+* Function:    is_directory
+*
+* Description: Checks if a path names a directory.
+*
+* Parameters:  path - reference to the path.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      TRUE if the path is a directory, FALSE if not.
+*
+**************************************************************************/
+int is_directory(char *path)
+{
+#if defined(HAVE_DIRECTORIES)
+  struct stat info;
+
+  if (stat(path,&info) != 0)
+    return FALSE;
+
+  return ((info.st_mode & S_IFMT) == S_IFDIR);
+#else
+  return FALSE;
+#endif
+}
+
+/**************************************************************************
+*
+* Function:    file_bytes
+*
+* Description: Finds the size of a file without reading it.  Where there
+*              is no stat the file is opened and sought to its end.
+*
+* Parameters:  filename - reference to the name of the file.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      the number of bytes in the file, or 0 if it can not be
+*              found.
+*
+**************************************************************************/
+unsigned long file_bytes(char *filename)
+{
+  unsigned long bytes = 0;
+#if defined(HAVE_DIRECTORIES)
+  struct stat info;
+
+  if (stat(filename,&info) == 0)
+    bytes = (unsigned long) info.st_size;
+#else
+  FILE *fp;
+  long end;
+
+  fp = fopen(filename,"rb");
+  if (fp != NULL)
+  {
+    if ((fseek(fp,0L,SEEK_END) == 0) && ((end = ftell(fp)) > 0))
+      bytes = (unsigned long) end;
+    fclose(fp);
+  }
+#endif
+
+  return bytes;
+}
+
+/**************************************************************************
+*
+* Function:    walk_directory
+*
+* Description: Adds the C and C++ files in a directory and all of its
+*              subdirectories to a list of files.  Symbolic links to
+*              directories are not followed so that a link loop cannot
+*              make the walk go on forever.
+*
+* Parameters:  list - reference to the list of files.
+*              path - reference to the directory name.
+*
+* Globals:     none
+*
+* Locals:      is_source_file function.
+*
+* Return:      none
+*
+**************************************************************************/
+void walk_directory(FILE_LIST *list,char *path)
+{
+#if defined(HAVE_DIRECTORIES)
+  char *child;          /* path of a directory entry */
+  char *entry;          /* name of a directory entry */
+  size_t path_len;
+  int subdirectory;
+#if defined(_WIN32)
+  struct _finddata_t found;
+  intptr_t handle;
+  char *pattern;
+#else
+  DIR *dir;
+  struct dirent *dirent_ptr;
+  struct stat info;
+#endif
+
+  path_len = strlen(path);
+  /* do not double up the separator of a path like "src/" */
+  if ((path_len > 0) &&
+      ((path[path_len-1] == '/') || (path[path_len-1] == PATH_SEPARATOR)))
+    path_len--;
+
+#if defined(_WIN32)
+  pattern = (char *) mem_alloc(MEM_PATHS,path_len + 3);
+  if (pattern == NULL)
+  {
+    printf("walk_directory: malloc failed.\n");
+    exit(1);
+  }
+  sprintf(pattern,"%.*s\\*",(int) path_len,path);
+  handle = _findfirst(pattern,&found);
+  mem_free(pattern);
+  if (handle == -1)
+    return;
+  do
+  {
+    entry = found.name;
+    subdirectory = ((found.attrib & _A_SUBDIR) != 0);
+#else
+  dir = opendir(path);
+  if (dir == NULL)
+  {
+    printf("walk_directory: error opening %s.\n",path);
+    return;
+  }
+  while ((dirent_ptr = readdir(dir)) != NULL)
+  {
+    entry = dirent_ptr->d_name;
+#endif
+    if ((strcmp(entry,".") == 0) || (strcmp(entry,"..") == 0))
+      continue;
+
+    child = (char *) mem_alloc(MEM_PATHS,path_len + strlen(entry) + 2);
+    if (child == NULL)
+    {
+      printf("walk_directory: malloc failed.\n");
+      exit(1);
+    }
+    sprintf(child,"%.*s%c%s",(int) path_len,path,PATH_SEPARATOR,entry);
+
+#if !defined(_WIN32)
+    if (lstat(child,&info) != 0)
+    {
+      mem_free(child);
+      continue;
+    }
+    subdirectory = S_ISDIR(info.st_mode);
+    /* a link is counted only if it is a link to a file */
+    if (S_ISLNK(info.st_mode) && is_directory(child))
+    {
+      mem_free(child);
+      continue;
+    }
+#endif
+
+    if (subdirectory)
+      walk_directory(list,child);
+    else if (is_source_file(child))
+      add_file_name(list,child);
+    mem_free(child);
+#if defined(_WIN32)
+  } while (_findnext(handle,&found) == 0);
+  _findclose(handle);
+#else
+  }
+  closedir(dir);
+#endif
+#else
+  printf("walk_directory: directories are not supported on this "
+    "platform, so %s is not counted.\n",path);
+  (void) list;
+#endif
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    hash_match_key
+*
+* Description: FNV-1a hash of a filename and function name, which together
+*              are the key used to match functions between two versions.
+*
+* Parameters:  filename - reference to the filename.
+*              name - reference to the function name.
+*
+* Globals:     none
+*
+* Locals:      hash_bytes function.
+*
+* Return:      hash of the key.
+*
+**************************************************************************/
+unsigned long hash_match_key(char *filename,char *name)
+{
+  unsigned long hash;
+
+  /* the NUL keeps "ab" + "c" apart from "a" + "bc" */
+  hash = hash_bytes(2166136261UL,filename,strlen(filename) + 1);
+
+  return hash_bytes(hash,name,strlen(name));
+}
+
+/**************************************************************************
+*
+* Function:    insert_match
+*
+* Description: Adds a function to the end of its bucket in a match table,
+*              doubling the number of buckets when the table gets full.
+*              Adding to the end keeps functions with the same name in
+*              the order they were found, so they match up in order.
+*
+* Parameters:  table - reference to the match table.
+*              filename - reference to the filename, which must stay in
+*                         memory as long as the table.
+*              name - reference to the function name in Name_Pool.
+*              hash - value from hash_match_key.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      the new match, with no version set.
+*
+**************************************************************************/
+FUNCTION_MATCH *insert_match(MATCH_TABLE *table,char *filename,char *name,
+  unsigned long hash)
+{
+  FUNCTION_MATCH **buckets;
+  FUNCTION_MATCH **tail;
+  FUNCTION_MATCH *current;
+  FUNCTION_MATCH *next;
+  FUNCTION_MATCH *match;
+  size_t bucket_count;
+  size_t index;
+
+  if (table->count >= table->bucket_count)
+  {
+    bucket_count = (table->bucket_count == 0) ? 256 :
+      (table->bucket_count * 2);
+    buckets = (FUNCTION_MATCH **) mem_calloc(MEM_FUNCTIONS,bucket_count,
+      sizeof(FUNCTION_MATCH *));
+    if (buckets == NULL)
+    {
+      printf("insert_match: malloc failed.\n");
+      exit(1);
+    }
+    /* move every match into the larger table, keeping bucket order */
+    for (index = 0; index < table->bucket_count; index++)
+    {
+      for (current = table->buckets[index]; current != NULL; current = next)
+      {
+        next = current->next;
+        current->next = NULL;
+        tail = &buckets[current->hash & (bucket_count - 1)];
+        while (*tail != NULL)
+          tail = &(*tail)->next;
+        *tail = current;
+      }
+    }
+    mem_free(table->buckets);
+    table->buckets = buckets;
+    table->bucket_count = bucket_count;
+  }
+
+  match = (FUNCTION_MATCH *) mem_alloc(MEM_FUNCTIONS,sizeof(FUNCTION_MATCH));
+  if (match == NULL)
+  {
+    printf("insert_match: malloc failed.\n");
+    exit(1);
+  }
+  match->filename = filename;
+  match->name = name;
+  match->old_loc = 0;
+  match->new_loc = 0;
+  match->in_old = FALSE;
+  match->in_new = FALSE;
+  match->hash = hash;
+  match->next = NULL;
+
+  tail = &table->buckets[hash & (table->bucket_count - 1)];
+  while (*tail != NULL)
+    tail = &(*tail)->next;
+  *tail = match;
+  table->count++;
+
+  return match;
+}
+
+/**************************************************************************
+*
+* Function:    match_build
+*
+* Description: Build side of the hash join - adds the functions of the old
+*              version of a file to a match table.
+*
+* Parameters:  table - reference to the match table.
+*              filename - reference to the filename.
+*              list - first ELEMENT of the functions in the old version.
+*
+* Globals:     none
+*
+* Locals:      insert_match function.
+*
+* Return:      none
+*
+**************************************************************************/
+void match_build(MATCH_TABLE *table,char *filename,ELEMENT *list)
+{
+  FUNCTION_MATCH *match;
+
+  for (; list != NULL; list = list->next)
+  {
+    if (list->loc_count == 0)
+      continue;
+    match = insert_match(table,filename,list->name,
+      hash_match_key(filename,list->name));
+    match->old_loc = list->loc_count;
+    match->in_old = TRUE;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    match_probe
+*
+* Description: Probe side of the hash join - looks up each function of the
+*              new version of a file in a match table.  A function that
+*              is not found is added as a new function.  Names come from
+*              Name_Pool, so equal names are the same pointer.
+*
+* Parameters:  table - reference to the match table.
+*              filename - reference to the filename.
+*              list - first ELEMENT of the functions in the new version.
+*
+* Globals:     none
+*
+* Locals:      insert_match function.
+*
+* Return:      none
+*
+**************************************************************************/
+void match_probe(MATCH_TABLE *table,char *filename,ELEMENT *list)
+{
+  FUNCTION_MATCH *match;
+  unsigned long hash;
+
+  for (; list != NULL; list = list->next)
+  {
+    if (list->loc_count == 0)
+      continue;
+    hash = hash_match_key(filename,list->name);
+    match = NULL;
+    if (table->bucket_count > 0)
+      match = table->buckets[hash & (table->bucket_count - 1)];
+    for (; match != NULL; match = match->next)
+    {
+      if ((match->hash == hash) && match->in_old && !match->in_new &&
+          (match->name == list->name) &&
+          (strcmp(match->filename,filename) == 0))
+        break;
+    }
+    if (match == NULL)
+      match = insert_match(table,filename,list->name,hash);
+    match->new_loc = list->loc_count;
+    match->in_new = TRUE;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    compare_match_delta
+*
+* Description: qsort comparison that puts the largest growth first, then
+*              orders by filename and function name.
+*
+* Parameters:  a, b - references to FUNCTION_MATCH pointers.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      less than, equal to, or greater than zero.
+*
+**************************************************************************/
+int compare_match_delta(const void *a,const void *b)
+{
+  FUNCTION_MATCH *match_a = *(FUNCTION_MATCH * const *) a;
+  FUNCTION_MATCH *match_b = *(FUNCTION_MATCH * const *) b;
+  long delta_a = (long) match_a->new_loc - (long) match_a->old_loc;
+  long delta_b = (long) match_b->new_loc - (long) match_b->old_loc;
+  int status;
+
+  if (delta_a != delta_b)
+    return (delta_a > delta_b) ? -1 : 1;
+  status = strcmp(match_a->filename,match_b->filename);
+  if (status == 0)
+    status = strcmp(match_a->name,match_b->name);
+
+  return status;
+}
+
+/**************************************************************************
+*
+* Function:    sort_matches
+*
+* Description: Collects the functions in a match table that were added,
+*              removed or changed size, sorted with the largest growth
+*              first.
+*
+* Parameters:  table - reference to the match table.
+*              count - reference to the number of changed functions.
+*
+* Globals:     none
+*
+* Locals:      compare_match_delta function.
+*
+* Return:      array of changed functions which the caller frees; the
+*              functions themselves still belong to the table.
+*
+**************************************************************************/
+FUNCTION_MATCH **sort_matches(MATCH_TABLE *table,size_t *count)
+{
+  FUNCTION_MATCH **changes;
+  FUNCTION_MATCH *match;
+  size_t index;
+
+  *count = 0;
+  changes = (FUNCTION_MATCH **) mem_alloc(MEM_FUNCTIONS,(table->count + 1) *
+    sizeof(FUNCTION_MATCH *));
+  if (changes == NULL)
+  {
+    printf("sort_matches: malloc failed.\n");
+    exit(1);
+  }
+
+  for (index = 0; index < table->bucket_count; index++)
+  {
+    for (match = table->buckets[index]; match != NULL; match = match->next)
+    {
+      if (!match->in_old || !match->in_new ||
+          (match->old_loc != match->new_loc))
+      {
+        changes[*count] = match;
+        (*count)++;
+      }
+    }
+  }
+  qsort(changes,*count,sizeof(FUNCTION_MATCH *),compare_match_delta);
+
+  return changes;
+}
+
+/**************************************************************************
+*
+* Function:    delete_matches
+*
+* Description: De-allocates memory for all of the functions in a match
+*              table and its buckets.
+*
+* Parameters:  table - reference to the match table.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_matches(MATCH_TABLE *table)
+{
+  FUNCTION_MATCH *current;
+  FUNCTION_MATCH *next;
+  size_t index;
+
+  for (index = 0; index < table->bucket_count; index++)
+  {
+    for (current = table->buckets[index]; current != NULL; current = next)
+    {
+      next = current->next;
+      mem_free(current);
+    }
+  }
+  mem_free(table->buckets);
+  table->buckets = NULL;
+  table->bucket_count = 0;
+  table->count = 0;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    count_tree_file
+*
+* Description: Reads and counts one file of a source tree being compared.
+*
+* Parameters:  filename - reference to the name of the file.
+*              counts - reference to the totals for the file.
+*
+* Globals:     none
+*
+* Locals:      read_input_file, count_version functions.
+*
+* Return:      list - first ELEMENT of the functions in the file, which the
+*                     caller deletes with delete_list.
+*
+**************************************************************************/
+ELEMENT *count_tree_file(char *filename,FILE_COUNTS *counts)
+{
+  ELEMENT *list;
+  char *buffer;
+  size_t length = 0;
+
+  if (Perf_Flag)
+    perf_phase(PERF_READ);
+  buffer = read_input_file(filename,&length);
+  set_dialect(filename);
+  list = count_version(buffer,length,counts);
+  mem_free(buffer);
+
+  return list;
+}
+
+/**************************************************************************
+*
+* Function:    compare_trees
+*
+* Description: Counts two source trees and prints every function that was
+*              added, removed or resized between them, largest growth
+*              first.  Functions are matched on their file, relative to
+*              the top of each tree, and name with a hash join: the old
+*              tree builds the table and the new tree probes it.
+*
+* Parameters:  old_tree - reference to the top directory of the old tree.
+*              new_tree - reference to the top directory of the new tree.
+*
+* Globals:     WKS_Flag, WKS_Header_Flag
+*
+* Locals:      walk_directory, match_build, match_probe functions.
+*
+* Return:      0 if both trees were counted, 1 on error.
+*
+**************************************************************************/
+int compare_trees(char *old_tree,char *new_tree)
+{
+  FILE_LIST files[2];       /* files of the old and new trees */
+  char *trees[2];           /* top directories of the trees */
+  COUNTER totals[2];        /* logical lines of code of each tree */
+  COUNTER changed[3];       /* added, removed and resized functions */
+  MATCH_TABLE table;        /* functions of both trees */
+  FUNCTION_MATCH **changes; /* functions that changed, sorted */
+  FILE_COUNTS counts;
+  ELEMENT *list;
+  size_t count = 0;
+  size_t index;
+  size_t offset;
+  char *change;
+  int tree;
+  int status = 0;
+
+#if !defined(HAVE_DIRECTORIES)
+  printf("compare_trees: --compare is not supported on this platform.\n");
+  return (1);
+#endif
+  trees[0] = old_tree;
+  trees[1] = new_tree;
+  table.buckets = NULL;
+  table.bucket_count = 0;
+  table.count = 0;
+  changed[0] = changed[1] = changed[2] = 0;
+
+  for (tree = 0; tree < 2; tree++)
+  {
+    files[tree].names = NULL;
+    files[tree].count = 0;
+    files[tree].size = 0;
+    totals[tree] = 0;
+    if (!is_directory(trees[tree]))
+    {
+      printf("compare_trees: %s is not a directory.\n",trees[tree]);
+      status = 1;
+      continue;
+    }
+    walk_directory(&files[tree],trees[tree]);
+    qsort(files[tree].names,files[tree].count,sizeof(char *),
+      compare_file_names);
+
+    for (index = 0; index < files[tree].count; index++)
+    {
+      list = count_tree_file(files[tree].names[index],&counts);
+      totals[tree] += counts.loc_count;
+      if (Perf_Flag)
+        perf_phase(PERF_COLLECT);
+      /* match on the path below the top of the tree */
+      offset = strlen(trees[tree]);
+      if ((files[tree].names[index][offset] == '/') ||
+          (files[tree].names[index][offset] == PATH_SEPARATOR))
+        offset++;
+      if (tree == 0)
+        match_build(&table,files[tree].names[index] + offset,list);
+      else
+        match_probe(&table,files[tree].names[index] + offset,list);
+      delete_list(list);
+    }
+  }
+
+  changes = sort_matches(&table,&count);
+  if (Perf_Flag)
+    perf_phase(PERF_OUTPUT);
+  if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Change,Function Name,Old LOC,New LOC,Delta LOC,"
+             "Program Name\n");
+  }
+  else
+  {
+    printf("Change   Function                         Old      New"
+           "      Delta\n");
+    printf("         Name                             LOC      LOC"
+           "      LOC      Program Name\n");
+    printf("======== ================================ ======== ========"
+           " ======== ============\n");
+  }
+  for (index = 0; index < count; index++)
+  {
+    if (!changes[index]->in_old)
+    {
+      change = "added";
+      changed[0]++;
+    }
+    else if (!changes[index]->in_new)
+    {
+      change = "removed";
+      changed[1]++;
+    }
+    else
+    {
+      change = "resized";
+      changed[2]++;
+    }
+    print_compare_line(change,changes[index]->name,changes[index]->old_loc,
+      changes[index]->new_loc,changes[index]->filename);
+  }
+
+  if (WKS_Flag)
+    printf("TOTAL,,%lu,%lu,%ld,\n",totals[0],totals[1],
+      (long) totals[1] - (long) totals[0]);
+  else
+  {
+    printf("                                          -------- --------"
+           " --------\n");
+    printf("TOTAL    %-32s %8lu %8lu %+8ld\n"," ",totals[0],totals[1],
+      (long) totals[1] - (long) totals[0]);
+    printf("======== ================================ ======== ========"
+           " ======== ============\n");
+    printf("%-8s %-32s %8lu\n","Added","functions",changed[0]);
+    printf("%-8s %-32s %8lu\n","Removed","functions",changed[1]);
+    printf("%-8s %-32s %8lu\n","Resized","functions",changed[2]);
+  }
+
+  if (Perf_Flag)
+    perf_phase(PERF_OTHER);
+  mem_free(changes);
+  delete_matches(&table);
+  delete_file_list(&files[0]);
+  delete_file_list(&files[1]);
+
+  return (status);
+}
+
+/**************************************************************************
+*
+* Function:    put_number
+*
+* Description: Stores a number in the results history, little endian.
+*
+* Parameters:  data - where to put the number.
+*              value - the number.
+*              size - number of bytes that it takes.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void put_number(unsigned char *data,unsigned long value,int size)
+{
+  int index;
+
+  for (index = 0; index < size; index++)
+  {
+    data[index] = (unsigned char) (value & 0xFF);
+    value >>= 8;
+  }
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    get_number
+*
+* Description: Reads a number stored by put_number.
+*
+* Parameters:  data - where the number is.
+*              size - number of bytes that it takes.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      the number.
+*
+**************************************************************************/
+unsigned long get_number(unsigned char *data,int size)
+{
+  unsigned long value = 0;
+  int index;
+
+  for (index = size - 1; index >= 0; index--)
+    value = (value << 8) | data[index];
+
+  return value;
+}
+
+/**************************************************************************
+*
+* Function:    map_file
+*
+* Description: Maps a file into memory to be read.  Where there is no
+*              mmap the file is read in instead.
+*
+* Parameters:  filename - name of the file.
+*              length - reference to the number of bytes in the file.
+*
+* Globals:     none
+*
+* Locals:      read_stream function.
+*
+* Return:      the contents of the file, or NULL if it does not exist or
+*              is empty.  unmap_file gives it back.
+*
+**************************************************************************/
+char *map_file(char *filename,size_t *length)
+{
+  char *data = NULL;
+#if !defined(HAVE_MMAP)
+  FILE *fp;
+
+  *length = 0;
+  fp = fopen(filename,"rb");
+  if (fp == NULL)
+    return NULL;
+  data = read_stream(fp,length);
+  fclose(fp);
+  if ((data != NULL) && (*length == 0))
+  {
+    mem_free(data);
+    data = NULL;
+  }
+#else
+  struct stat info;
+  int fd;
+
+  *length = 0;
+  fd = open(filename,O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  if ((fstat(fd,&info) == 0) && (info.st_size > 0))
+  {
+    data = (char *) mmap(NULL,(size_t) info.st_size,PROT_READ,MAP_SHARED,
+      fd,0);
+    if (data == (char *) MAP_FAILED)
+      data = NULL;
+    else
+      *length = (size_t) info.st_size;
+  }
+  close(fd);
+#endif
+
+  return data;
+}
+
+/**************************************************************************
+*
+* Function:    unmap_file
+*
+* Description: Gives back a file from map_file.
+*
+* Parameters:  data - the contents of the file, or NULL.
+*              length - number of bytes in the file.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void unmap_file(char *data,size_t length)
+{
+  if (data == NULL)
+    return;
+#if !defined(HAVE_MMAP)
+  mem_free(data);
+  (void) length;
+#else
+  munmap(data,length);
+#endif
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    base_name
+*
+* Description: Finds the name of a file without its directories.
+*
+* Parameters:  path - reference to the path of the file.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      the part of path after the last separator.
+*
+**************************************************************************/
+char *base_name(char *path)
+{
+  char *name = path;
+
+  for (; *path != 0; path++)
+  {
+    if ((*path == '/') || (*path == '\\'))
+      name = path + 1;
+  }
+
+  return name;
+}
+
+/**************************************************************************
+*
+* Function:    history_record
+*
+* Description: Finds a record of the results history, in the store as it
+*              was or in the records added by this run, and checks that
+*              it is whole.
+*
+* Parameters:  store - reference to the results history.
+*              offset - where the record starts in the store.
+*
+* Globals:     none
+*
+* Locals:      get_number function.
+*
+* Return:      the record, or NULL if there is no whole record there.
+*
+**************************************************************************/
+unsigned char *history_record(HISTORY_STORE *store,unsigned long offset)
+{
+  unsigned char *record;
+  size_t available;         /* bytes from the record to the end */
+  unsigned long size;
+
+  if (offset < HISTORY_HEADER_SIZE)
+    return NULL;
+  if (offset < store->length)
+  {
+    record = (unsigned char *) store->data + offset;
+    available = store->length - offset;
+  }
+  else if ((offset - store->length) < store->added_length)
+  {
+    record = store->added + (offset - store->length);
+    available = store->added_length - (offset - store->length);
+  }
+  else
+    return NULL;
+
+  if (available < HISTORY_RECORD_SIZE)
+    return NULL;
+  size = get_number(record,4);
+  if ((size > available) || (size < (HISTORY_RECORD_SIZE +
+      get_number(record + 28,2) + get_number(record + 30,2))))
+    return NULL;
+
+  return record;
+}
+
+/**************************************************************************
+*
+* Function:    history_slot
+*
+* Description: Finds the slot of the index for a file name and function,
+*              or the empty slot where it would go.  The key is the name
+*              of the file without its directories, so that the history
+*              can be asked for by either.
+*
+* Parameters:  store - reference to the results history.
+*              hash - hash_match_key of the file name and function.
+*              filename - the file name, without its directories.
+*              file_len - number of characters in filename.
+*              name - the function.
+*              name_len - number of characters in name.
+*
+* Globals:     none
+*
+* Locals:      history_record, get_number functions.
+*
+* Return:      the slot, or slot_count if the index is empty.
+*
+**************************************************************************/
+unsigned long history_slot(HISTORY_STORE *store,unsigned long hash,
+  char *filename,size_t file_len,char *name,size_t name_len)
+{
+  unsigned char *slot_data;
+  unsigned char *record;
+  unsigned long slot;
+  unsigned long offset;
+  char *path;               /* file name in the record */
+  size_t path_len;
+  size_t base_len;          /* length of the file name, without directories */
+
+  if (store->slot_count == 0)
+    return store->slot_count;
+
+  for (slot = hash & (store->slot_count - 1); ;
+       slot = (slot + 1) & (store->slot_count - 1))
+  {
+    slot_data = store->slots + (slot * HISTORY_SLOT_SIZE);
+    offset = get_number(slot_data + 8,8);
+    if (offset == 0)
+      break;
+    if (get_number(slot_data,4) != hash)
+      continue;
+    record = history_record(store,offset);
+    if (record == NULL)
+      continue;
+    path = (char *) record + HISTORY_RECORD_SIZE;
+    path_len = (size_t) get_number(record + 28,2);
+    for (base_len = 0; base_len < path_len; base_len++)
+    {
+      if ((path[path_len - base_len - 1] == '/') ||
+          (path[path_len - base_len - 1] == '\\'))
+        break;
+    }
+    if ((base_len == file_len) &&
+        (memcmp(path + path_len - base_len,filename,base_len) == 0) &&
+        (get_number(record + 30,2) == name_len) &&
+        (memcmp(path + path_len,name,name_len) == 0))
+      break;
+  }
+
+  return slot;
+}
+
+/**************************************************************************
+*
+* Function:    history_grow
+*
+* Description: Doubles the slots of the index when it is half full, or
+*              makes the first ones.  The slots are owned afterwards, so
+*              a mapped index is copied to be changed.
+*
+* Parameters:  store - reference to the results history.
+*
+* Globals:     none
+*
+* Locals:      get_number function.
+*
+* Return:      0 if the index grew, 1 if there is no memory.
+*
+**************************************************************************/
+int history_grow(HISTORY_STORE *store)
+{
+  unsigned char *slots;
+  unsigned char *slot_data;
+  unsigned long slot_count;
+  unsigned long index;
+  unsigned long slot;
+
+  slot_count = store->slot_count;
+  if (slot_count == 0)
+    slot_count = 1024;
+  else if ((store->used + 1) * 2 > slot_count)
+    slot_count *= 2;
+  slots = (unsigned char *) mem_calloc(MEM_CACHES,(size_t) slot_count,
+    HISTORY_SLOT_SIZE);
+  if (slots == NULL)
+    return (1);
+  for (index = 0; index < store->slot_count; index++)
+  {
+    slot_data = store->slots + (index * HISTORY_SLOT_SIZE);
+    if (get_number(slot_data + 8,8) == 0)
+      continue;
+    /* the keys are all different, so only an empty slot is looked for */
+    slot = get_number(slot_data,4) & (slot_count - 1);
+    while (get_number(slots + (slot * HISTORY_SLOT_SIZE) + 8,8) != 0)
+      slot = (slot + 1) & (slot_count - 1);
+    memcpy(slots + (slot * HISTORY_SLOT_SIZE),slot_data,HISTORY_SLOT_SIZE);
+  }
+  if (store->slots_owned)
+    mem_free(store->slots);
+  store->slots = slots;
+  store->slots_owned = TRUE;
+  store->slot_count = slot_count;
+  store->index_stale = TRUE;
+
+  return (0);
+}
+
+/**************************************************************************
+*
+* Function:    history_link
+*
+* Description: Makes a record the newest of its file name and function
+*              in the index.
+*
+* Parameters:  store - reference to the results history.
+*              record - reference to the record.
+*              offset - where the record starts in the store.
+*
+* Globals:     none
+*
+* Locals:      history_grow, history_slot functions.
+*
+* Return:      offset of the record that was the newest before, or 0 if
+*              this is the first.
+*
+**************************************************************************/
+unsigned long history_link(HISTORY_STORE *store,unsigned char *record,
+  unsigned long offset)
+{
+  char *path;               /* file name in the record */
+  char *base;               /* the file name without its directories */
+  unsigned char *slot_data;
+  unsigned long hash;
+  unsigned long slot;
+  unsigned long previous;
+  size_t path_len;
+
+  /* changing the slots of a mapped index needs a copy of them */
+  if (((store->used + 1) * 2 > store->slot_count) || !store->slots_owned)
+  {
+    if (history_grow(store) != 0)
+    {
+      printf("history_link: malloc failed.\n");
+      exit(1);
+    }
+  }
+
+  path = (char *) record + HISTORY_RECORD_SIZE;
+  path_len = (size_t) get_number(record + 28,2);
+  for (base = path + path_len; base > path; base--)
+  {
+    if ((base[-1] == '/') || (base[-1] == '\\'))
+      break;
+  }
+
+  hash = get_number(record + 4,4);
+  slot = history_slot(store,hash,base,(size_t) (path + path_len - base),
+    path + path_len,(size_t) get_number(record + 30,2));
+  slot_data = store->slots + (slot * HISTORY_SLOT_SIZE);
+  previous = get_number(slot_data + 8,8);
+  if (previous == 0)
+    store->used++;
+  put_number(slot_data,hash,4);
+  put_number(slot_data + 4,0,4);
+  put_number(slot_data + 8,offset,8);
+  store->index_stale = TRUE;
+
+  return previous;
+}
+
+/**************************************************************************
+*
+* Function:    load_history_index
+*
+* Description: Maps the index of the results history.  If there is no
+*              index, or it does not cover every record in the store,
+*              the records it is missing are added to it.
+*
+* Parameters:  store - reference to the results history.
+*
+* Globals:     none
+*
+* Locals:      map_file, history_record, history_link functions.
+*
+* Return:      0 if the index is ready, 1 if the store is damaged.
+*
+**************************************************************************/
+int load_history_index(HISTORY_STORE *store)
+{
+  char index_name[MAX_LINE_SIZE * 4];
+  unsigned char *header;
+  unsigned char *record;
+  unsigned long covered = HISTORY_HEADER_SIZE; /* store bytes indexed */
+  unsigned long slot_count;
+  unsigned long offset;
+
+  if (strlen(store->filename) > (sizeof(index_name) - 5))
+    return (1);
+  sprintf(index_name,"%s.idx",store->filename);
+  store->index_map = map_file(index_name,&store->index_length);
+  header = (unsigned char *) store->index_map;
+  if ((header != NULL) && (store->index_length >= HISTORY_INDEX_HEADER_SIZE) &&
+      (memcmp(header,HISTORY_INDEX_MAGIC,8) == 0))
+  {
+    slot_count = get_number(header + 8,8);
+    if (((slot_count & (slot_count - 1)) == 0) &&
+        (store->index_length == (HISTORY_INDEX_HEADER_SIZE +
+          ((size_t) slot_count * HISTORY_SLOT_SIZE))) &&
+        (get_number(header + 24,8) <= store->length))
+    {
+      store->slots = header + HISTORY_INDEX_HEADER_SIZE;
+      store->slot_count = slot_count;
+      store->used = get_number(header + 16,8);
+      covered = get_number(header + 24,8);
+    }
+  }
+
+  /* records that were added after the index was last written */
+  for (offset = covered; offset < store->length;
+       offset += get_number(record,4))
+  {
+    record = history_record(store,offset);
+    if (record == NULL)
+    {
+      printf("load_history_index: %s is damaged after byte %lu.\n",
+        store->filename,offset);
+      return (1);
     }
+    history_link(store,record,offset);
+  }
 
-    else
+  return (0);
+}
+
+/**************************************************************************
+*
+* Function:    open_store
+*
+* Description: Maps a results history and its index, ready for records to
+*              be added or looked up.  A store that does not exist yet is
+*              empty.
+*
+* Parameters:  store - reference to the results history.
+*              filename - name of the store.
+*
+* Globals:     none
+*
+* Locals:      map_file, load_history_index functions.
+*
+* Return:      0 if the store is ready, 1 if it is not a results history.
+*
+**************************************************************************/
+int open_store(HISTORY_STORE *store,char *filename)
+{
+  memset(store,0,sizeof(HISTORY_STORE));
+  store->filename = filename;
+  store->run_time = (unsigned long) time(NULL);
+  store->data = map_file(filename,&store->length);
+  if ((store->data != NULL) && ((store->length < HISTORY_HEADER_SIZE) ||
+      (memcmp(store->data,HISTORY_MAGIC,HISTORY_HEADER_SIZE) != 0)))
+  {
+    printf("open_store: %s is not a results history.\n",filename);
+    unmap_file(store->data,store->length);
+    store->data = NULL;
+    return (1);
+  }
+
+  return load_history_index(store);
+}
+
+/**************************************************************************
+*
+* Function:    store_functions
+*
+* Description: Adds a record of each function of the file just counted to
+*              the results history, linked back to the one before it with
+*              the same file name and function.
+*
+* Parameters:  store - reference to the results history.
+*              filename - name of the file that was counted.
+*
+* Globals:     none
+*
+* Locals:      head - first ELEMENT of the linked list
+*              hash_match_key, history_link functions.
+*
+* Return:      0 if the records were added, 1 if there is no memory.
+*
+**************************************************************************/
+int store_functions(HISTORY_STORE *store,char *filename)
+{
+  ELEMENT *current;
+  unsigned char *added;
+  unsigned char *record;
+  unsigned long offset;
+  size_t path_len = strlen(filename);
+  size_t name_len;
+  size_t size;
+
+  for (current = head; current != NULL; current = current->next)
+  {
+    name_len = strlen(current->name);
+    size = HISTORY_RECORD_SIZE + path_len + name_len;
+    if ((path_len > 0xFFFF) || (name_len > 0xFFFF))
+      continue;
+    if ((store->added_length + size + HISTORY_HEADER_SIZE) > store->added_size)
     {
-      /* Turn on Comment Flag */
-      if (((new_char == '*') || (new_char == '/')) && (last_char == '/'))
-      {
-        if (new_char == '/')
-          c_plus_plus_comment = TRUE;
-        /* count comment lines of code */
-        comment_loc++;
-        /* count the number of characters in the comment */
-        comment_char++;
-        comment_char++;
-        /* turn on flag to start looking for end of comment */
-        comment = TRUE;
-        /* shrink token by 1 to remove / */
-        token_len = strlen(token);
-        /* check to see if tokens are countable */
-        switch(token_len)
-        {
-          case 0:
-            break;
-          case 1:
-            token[0] = 0;
-            break;
-          default:
-            token[token_len-1] = 0;
-            check_token(token,last_token,&loc_count,physical_loc);
-            break;
-        }
-      }
+      added = (unsigned char *) mem_realloc(MEM_CACHES,store->added,
+        store->added_size + size + 65536);
+      if (added == NULL)
+        return (1);
+      store->added = added;
+      store->added_size += size + 65536;
+    }
+    /* a new store starts with its header */
+    if ((store->length + store->added_length) == 0)
+    {
+      memcpy(store->added,HISTORY_MAGIC,HISTORY_HEADER_SIZE);
+      store->added_length = HISTORY_HEADER_SIZE;
+    }
 
-      /* Turn on Quotation Flag */
-      else if (new_char == '"')
-      {
-        quotation = TRUE;
-        check_token(token,last_token,&loc_count,physical_loc);
-      }
+    offset = (unsigned long) (store->length + store->added_length);
+    record = store->added + store->added_length;
+    put_number(record,(unsigned long) size,4);
+    put_number(record + 4,hash_match_key(base_name(filename),current->name),
+      4);
+    put_number(record + 8,0,8);
+    put_number(record + 16,store->run_time,8);
+    put_number(record + 24,current->loc_count,4);
+    put_number(record + 28,(unsigned long) path_len,2);
+    put_number(record + 30,(unsigned long) name_len,2);
+    memcpy(record + HISTORY_RECORD_SIZE,filename,path_len);
+    memcpy(record + HISTORY_RECORD_SIZE + path_len,current->name,name_len);
+    store->added_length += size;
+    put_number(record + 8,history_link(store,record,offset),8);
+  }
 
-      /* Turn on Single Quotation Flag */
-      else if (new_char == '\'')
-      {
-        single_quote = TRUE;
-        check_token(token,last_token,&loc_count,physical_loc);
-      }
+  return (0);
+}
 
-      /* Turn on Pre-compiler Flag */
-      else if (new_char == '#')
-      {
-        precompiler = TRUE;
-        precompiler_if = TRUE;
-        precompiler_else = FALSE;
-        precompiler_end = FALSE;
-        sprintf(token2,"%c",new_char);
-        check_token(token2,last_token,&loc_count,physical_loc);
-        token[0] = 0;
-      }
+/**************************************************************************
+*
+* Function:    close_store
+*
+* Description: Appends the records added by this run to the results
+*              history, writes its index again if it changed, and frees
+*              the store.  The index is written to a new file that then
+*              replaces the old one, so a run that stops part way leaves
+*              an index that is only behind, which is caught up next time.
+*
+* Parameters:  store - reference to the results history.
+*
+* Globals:     none
+*
+* Locals:      unmap_file, put_number functions.
+*
+* Return:      0 if the store was written, 1 if not.
+*
+**************************************************************************/
+int close_store(HISTORY_STORE *store)
+{
+  char index_name[MAX_LINE_SIZE * 4];
+  char temp_name[MAX_LINE_SIZE * 4];
+  unsigned char header[HISTORY_INDEX_HEADER_SIZE];
+  FILE *fp;
+  int status = 0;
 
-      /* Force token check - EOL */
-      else if (new_char == '\n')
-        check_token(token,last_token,&loc_count,physical_loc);
+  if (store->added_length > 0)
+  {
+    fp = fopen(store->filename,"ab");
+    if ((fp == NULL) || (fwrite(store->added,1,store->added_length,fp) !=
+        store->added_length))
+    {
+      printf("close_store: error writing %s.\n",store->filename);
+      status = 1;
+    }
+    if ((fp != NULL) && (fclose(fp) != 0))
+      status = 1;
+  }
 
-      /* Force token check - WHITE SPACE */
-      else if (isspace(new_char))
-        check_token(token,last_token,&loc_count,physical_loc);
+  if ((status == 0) && store->index_stale)
+  {
+    sprintf(index_name,"%s.idx",store->filename);
+    sprintf(temp_name,"%s.idx.new",store->filename);
+    memcpy(header,HISTORY_INDEX_MAGIC,8);
+    put_number(header + 8,store->slot_count,8);
+    put_number(header + 16,store->used,8);
+    put_number(header + 24,
+      (unsigned long) (store->length + store->added_length),8);
+    fp = fopen(temp_name,"wb");
+    if ((fp == NULL) ||
+        (fwrite(header,1,sizeof(header),fp) != sizeof(header)) ||
+        (fwrite(store->slots,HISTORY_SLOT_SIZE,(size_t) store->slot_count,
+          fp) != store->slot_count))
+      status = 1;
+    if ((fp != NULL) && (fclose(fp) != 0))
+      status = 1;
+    /* the index must be unmapped before it is replaced */
+    unmap_file(store->index_map,store->index_length);
+    store->index_map = NULL;
+    if (status == 0)
+    {
+      remove(index_name);
+      if (rename(temp_name,index_name) != 0)
+        status = 1;
+    }
+    if (status != 0)
+      printf("close_store: error writing %s.\n",index_name);
+  }
 
-      /* Force token check - PUNCTUATION */
-      else if (ispunct(new_char))
+  unmap_file(store->data,store->length);
+  unmap_file(store->index_map,store->index_length);
+  if (store->slots_owned)
+    mem_free(store->slots);
+  mem_free(store->added);
+  memset(store,0,sizeof(HISTORY_STORE));
+
+  return (status);
+}
+
+/**************************************************************************
+*
+* Function:    print_history
+*
+* Description: Prints the size of a function in each run that was added
+*              to the results history, oldest first.  Only the records
+*              of the file name and function are looked at, by following
+*              the links back from the newest one in the index.
+*
+* Parameters:  key - file:function, where file may leave out directories.
+*
+* Globals:     Store_File, WKS_Flag, WKS_Header_Flag
+*
+* Locals:      open_store, history_slot, history_record, close_store
+*              functions.
+*
+* Return:      0 if the history was printed, 1 if it could not be.
+*
+**************************************************************************/
+int print_history(char *key)
+{
+  HISTORY_STORE store;
+  unsigned long *found = NULL; /* records of the function, newest first */
+  unsigned long *larger;
+  size_t count = 0;
+  size_t size = 0;
+  size_t index;
+  size_t before;
+  unsigned char *record;
+  unsigned char *previous;
+  unsigned long offset;
+  unsigned long slot;
+  char *filename;
+  char *name;
+  char path[MAX_LINE_SIZE * 4];
+  char date[32];
+  time_t run_time;
+  size_t path_len;
+  size_t file_len;
+  int status = 0;
+
+  name = strrchr(key,':');
+  if ((name == NULL) || (name == key) || (name[1] == 0))
+  {
+    printf("print_history: %s is not file:function.\n",key);
+    return (1);
+  }
+  *name++ = 0;
+  filename = key;
+  file_len = strlen(filename);
+
+  if (open_store(&store,(Store_File != NULL) ? Store_File :
+      HISTORY_DEFAULT_FILE) != 0)
+  {
+    close_store(&store);
+    return (1);
+  }
+  slot = history_slot(&store,hash_match_key(base_name(filename),name),
+    base_name(filename),strlen(base_name(filename)),name,strlen(name));
+  offset = (slot < store.slot_count) ?
+    get_number(store.slots + (slot * HISTORY_SLOT_SIZE) + 8,8) : 0;
+
+  /* the links only go back, so a damaged link can not loop */
+  for (; (record = history_record(&store,offset)) != NULL;
+       offset = get_number(record + 8,8))
+  {
+    path_len = (size_t) get_number(record + 28,2);
+    if ((path_len >= file_len) &&
+        (memcmp(record + HISTORY_RECORD_SIZE + path_len - file_len,
+          filename,file_len) == 0) &&
+        ((path_len == file_len) ||
+         (record[HISTORY_RECORD_SIZE + path_len - file_len - 1] == '/') ||
+         (record[HISTORY_RECORD_SIZE + path_len - file_len - 1] == '\\')))
+    {
+      if (count == size)
       {
-        /* VALID NON-DELIMITER */
-        if ((new_char == '_') ||
-            (new_char == '~')) /* used in c++ destructors */
+        larger = (unsigned long *) mem_realloc(MEM_CACHES,found,
+          (size + 256) * sizeof(unsigned long));
+        if (larger == NULL)
         {
-          /* valid character - include with token */
-          sprintf(token1,"%s%c",token,new_char);
-          strcpy(token,token1);
+          status = 1;
+          break;
         }
-        /* DELIMITER FOUND */
-        else
-        {
-          check_token(token,last_token,&loc_count,physical_loc);
-          /* check punct to see if it is a countable token */
-          sprintf(token2,"%c",new_char);
-          check_token(token2,last_token,&loc_count,physical_loc);
-        } /* end of token delimiter */
+        found = larger;
+        size += 256;
       }
-      /* BUILD TOKEN */
-      else
+      found[count++] = offset;
+    }
+    if (get_number(record + 8,8) >= offset)
+      break;
+  }
+
+  if (count == 0)
+    printf("No history of %s in %s.\n",name,store.filename);
+  else if (WKS_Flag)
+  {
+    if (WKS_Header_Flag)
+      printf("Date,Function Name,LOC,Delta LOC,Program Name\n");
+  }
+  else
+  {
+    printf("Date             Function                         LOC      Delta"
+           "    Program\n");
+    printf("================ ================================ ======== "
+           "======== ============\n");
+  }
+  for (index = count; index > 0; index--)
+  {
+    record = history_record(&store,found[index - 1]);
+    path_len = (size_t) get_number(record + 28,2);
+    if (path_len >= sizeof(path))
+      path_len = sizeof(path) - 1;
+    memcpy(path,record + HISTORY_RECORD_SIZE,path_len);
+    path[path_len] = 0;
+    run_time = (time_t) get_number(record + 16,8);
+    strftime(date,sizeof(date),"%Y-%m-%d %H:%M",localtime(&run_time));
+    /* the change is from the run before, of the same file */
+    previous = NULL;
+    for (before = index; (previous == NULL) && (before < count); before++)
+    {
+      previous = history_record(&store,found[before]);
+      if ((get_number(previous + 28,2) != get_number(record + 28,2)) ||
+          (memcmp(previous + HISTORY_RECORD_SIZE,record + HISTORY_RECORD_SIZE,
+            (size_t) get_number(record + 28,2)) != 0))
+        previous = NULL;
+    }
+    if (WKS_Flag)
+    {
+      printf("%s,%s,%lu,",date,name,get_number(record + 24,4));
+      if (previous != NULL)
+        printf("%ld",(long) get_number(record + 24,4) -
+          (long) get_number(previous + 24,4));
+      printf(",%s\n",path);
+    }
+    else if (previous != NULL)
+      printf("%-16s %-32s %8lu %+8ld %s\n",date,name,
+        get_number(record + 24,4),(long) get_number(record + 24,4) -
+        (long) get_number(previous + 24,4),path);
+    else
+      printf("%-16s %-32s %8lu %8s %s\n",date,name,
+        get_number(record + 24,4),"",path);
+  }
+
+  mem_free(found);
+  if (close_store(&store) != 0)
+    status = 1;
+
+  return (status);
+}
+
+/**************************************************************************
+*
+* Function:    add_log_bytes
+*
+* Description: Makes room for more records in the results log.
+*
+* Parameters:  log - reference to the results log.
+*              size - number of bytes to make room for.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      reference to where the bytes go.  Exits if there is no
+*              memory.
+*
+**************************************************************************/
+unsigned char *add_log_bytes(RESULTS_LOG *log,size_t size)
+{
+  unsigned char *pending;
+  unsigned char *bytes;
+
+  if ((log->pending_length + size) > log->pending_size)
+  {
+    pending = (unsigned char *) mem_realloc(MEM_CACHES,log->pending,
+      log->pending_size + size + 65536);
+    if (pending == NULL)
+    {
+      printf("add_log_bytes: malloc failed.\n");
+      exit(1);
+    }
+    log->pending = pending;
+    log->pending_size += size + 65536;
+  }
+  bytes = log->pending + log->pending_length;
+  log->pending_length += size;
+
+  return bytes;
+}
+
+/**************************************************************************
+*
+* Function:    write_results_log
+*
+* Description: Appends the records that are pending to the results log.
+*              If the log can not be written, no more is logged, but the
+*              count carries on.
+*
+* Parameters:  log - reference to the results log.
+*
+* Globals:     none
+*
+* Locals:      none
+*
+* Return:      0 if the records were written, 1 if not.
+*
+**************************************************************************/
+int write_results_log(RESULTS_LOG *log)
+{
+  if (log->fp == NULL)
+    return (1);
+
+  if ((fwrite(log->pending,1,log->pending_length,log->fp) !=
+       log->pending_length) || (fflush(log->fp) != 0))
+  {
+    printf("write_results_log: error writing %s.\n",log->filename);
+    fclose(log->fp);
+    log->fp = NULL;
+    return (1);
+  }
+  log->pending_length = 0;
+  log->last_write = time(NULL);
+
+  return (0);
+}
+
+/**************************************************************************
+*
+* Function:    map_results_log
+*
+* Description: Maps a results log to be replayed from, and reads the
+*              inputs it lists.  If no inputs were given they are taken
+*              from the log; otherwise they must be the same.
+*
+* Parameters:  log - reference to the results log.
+*              filename - name of the log.
+*              given - number of inputs given, 0 to take them from the log.
+*              records - reference to where the records start.
+*
+* Globals:     Input_List
+*
+* Locals:      map_file, add_file_name functions.
+*
+* Return:      LOG_READY, LOG_MISSING if there is no log, LOG_CUT_SHORT if
+*              it stops part way through the inputs, or LOG_DIFFERENT if
+*              it is for other inputs or is not a results log.
+*
+**************************************************************************/
+int map_results_log(RESULTS_LOG *log,char *filename,size_t given,
+  size_t *records)
+{
+  char **maps;
+  size_t *map_lengths;
+  unsigned char *data;
+  char *name;
+  size_t length;
+  size_t count;             /* inputs in the log */
+  size_t index;
+  size_t offset;
+  size_t name_len;
+
+  data = (unsigned char *) map_file(filename,&length);
+  if (data == NULL)
+    return LOG_MISSING;
+  maps = (char **) mem_realloc(MEM_CACHES,log->maps,
+    (log->map_count + 1) * sizeof(char *));
+  if (maps != NULL)
+    log->maps = maps;
+  map_lengths = (size_t *) mem_realloc(MEM_CACHES,log->map_lengths,
+    (log->map_count + 1) * sizeof(size_t));
+  if (map_lengths != NULL)
+    log->map_lengths = map_lengths;
+  if ((maps == NULL) || (map_lengths == NULL))
+  {
+    printf("map_results_log: malloc failed.\n");
+    exit(1);
+  }
+  log->maps[log->map_count] = (char *) data;
+  log->map_lengths[log->map_count] = length;
+  log->map_count++;
+
+  if ((length < CHECKPOINT_HEADER_SIZE) ||
+      (memcmp(data,CHECKPOINT_MAGIC,8) != 0))
+    return LOG_DIFFERENT;
+
+  count = (size_t) get_number(data + 8,8);
+  log->shard_count = get_number(data + 16,4);
+  log->shard_plan = get_number(data + 20,4);
+  offset = CHECKPOINT_HEADER_SIZE;
+  for (index = 0; index < count; index++)
+  {
+    if (((offset + 2) > length) ||
+        ((offset + 2 + (size_t) get_number(data + offset,2)) > length))
+      return LOG_CUT_SHORT;
+    name_len = (size_t) get_number(data + offset,2);
+    name = (char *) data + offset + 2;
+    if (given == 0)
+    {
+      name = (char *) mem_alloc(MEM_PATHS,name_len + 1);
+      if (name == NULL)
       {
-        sprintf(token1,"%s%c",token,new_char);
-        strcpy(token,token1);
+        printf("map_results_log: malloc failed.\n");
+        exit(1);
       }
+      memcpy(name,data + offset + 2,name_len);
+      name[name_len] = 0;
+      add_file_name(&Input_List,name);
+      mem_free(name);
+    }
+    else if ((index >= given) ||
+             (strlen(Input_List.names[index]) != name_len) ||
+             (memcmp(Input_List.names[index],name,name_len) != 0))
+      return LOG_DIFFERENT;
+    offset += 2 + name_len;
+  }
+  if ((given != 0) && (given != count))
+    return LOG_DIFFERENT;
+  *records = offset;
+
+  return LOG_READY;
+}
+
+/**************************************************************************
+*
+* Function:    find_finished_inputs
+*
+* Description: Finds the inputs that a results log finished, so that they
+*              can be replayed.  A record cut short by the run stopping,
+*              and anything after it, is left out.
+*
+* Parameters:  log - reference to the results log.
+*              data - the log, from map_results_log.
+*              length - number of bytes in the log.
+*              offset - where the records start.
+*
+* Globals:     Input_List
+*
+* Locals:      get_number function.
+*
+* Return:      where the records of the last finished input end.
+*
+**************************************************************************/
+size_t find_finished_inputs(RESULTS_LOG *log,unsigned char *data,
+  size_t length,size_t offset)
+{
+  size_t first = offset;    /* first record of the input being read */
+  size_t end = offset;      /* end of the last finished input */
+  size_t size;
+  size_t input;
+
+  if (log->replay == NULL)
+  {
+    log->replay = (unsigned char **) mem_calloc(MEM_CACHES,
+      Input_List.count + 1,sizeof(unsigned char *));
+    if (log->replay == NULL)
+    {
+      printf("find_finished_inputs: malloc failed.\n");
+      exit(1);
+    }
+  }
+
+  while ((offset + 5) <= length)
+  {
+    size = (size_t) get_number(data + offset,4);
+    if ((size < 5) || (size > (length - offset)))
+      break;
+    if (data[offset + 4] == CHECKPOINT_DONE)
+    {
+      if (size < CHECKPOINT_DONE_SIZE)
+        break;
+      input = (size_t) get_number(data + offset + 8,8);
+      if (input >= Input_List.count)
+        break;
+      log->replay[input] = data + first;
+      end = offset + size;
+      first = end;
+    }
+    else if ((data[offset + 4] != CHECKPOINT_FILE) ||
+             (size < CHECKPOINT_FILE_SIZE))
+      break;
+    offset += size;
+  }
+
+  return end;
+}
+
+/**************************************************************************
+*
+* Function:    open_results_log
+*
+* Description: Starts a results log for --checkpoint.  When resuming, the
+*              log of the run that stopped is read: its inputs are the
+*              work to be done, if none were given, and the records of
+*              the inputs it finished are kept to be replayed.  The log
+*              is written again without any records after the last
+*              finished input, and the rest of the run is added to it.
+*
+* Parameters:  log - reference to the results log.
+*              filename - name of the log.
+*              resume - TRUE to carry on from the log, if there is one.
+*
+* Globals:     Input_List
+*
+* Locals:      map_results_log, find_finished_inputs, add_log_bytes,
+*              write_results_log functions.
+*
+* Return:      0 if the log is ready, 1 if it could not be used.
+*
+**************************************************************************/
+int open_results_log(RESULTS_LOG *log,char *filename,unsigned char resume)
+{
+  char temp_name[MAX_LINE_SIZE * 4];
+  unsigned char *bytes;
+  size_t given = Input_List.count; /* inputs on the command line */
+  size_t index;
+  size_t records = 0;       /* where the records start */
+  size_t end;               /* end of the last finished input */
+  size_t name_len;
+  int result = LOG_MISSING;
+  FILE *fp;
+
+  memset(log,0,sizeof(RESULTS_LOG));
+  log->filename = filename;
+  if (resume)
+    result = map_results_log(log,filename,given,&records);
+  if ((result == LOG_CUT_SHORT) && (given == 0))
+  {
+    printf("open_results_log: %s does not list its files.\n",filename);
+    return (1);
+  }
+  else if (result == LOG_DIFFERENT)
+  {
+    printf("open_results_log: %s is not a checkpoint of these files.\n",
+      filename);
+    return (1);
+  }
+
+  if (result == LOG_READY)
+  {
+    /* the old log stays mapped to be replayed from */
+    end = find_finished_inputs(log,(unsigned char *) log->maps[0],
+      log->map_lengths[0],records);
+    if (strlen(filename) > (sizeof(temp_name) - 5))
+      return (1);
+    sprintf(temp_name,"%s.new",filename);
+    fp = fopen(temp_name,"wb");
+    if ((fp == NULL) || (fwrite(log->maps[0],1,end,fp) != end))
+    {
+      printf("open_results_log: error writing %s.\n",temp_name);
+      if (fp != NULL)
+        fclose(fp);
+      return (1);
+    }
+    fclose(fp);
+    remove(filename);
+    if (rename(temp_name,filename) != 0)
+    {
+      printf("open_results_log: error writing %s.\n",filename);
+      return (1);
     }
-
-    /* update any previous variables */
-    last_char = new_char;
+    log->fp = fopen(filename,"ab");
+    log->last_write = time(NULL);
   }
-
-  /* close the file */
-  fclose(file_ptr);
-  if (Debug_Flag)
+  else if (Input_List.count > 0)
   {
-    fprintf(debug_file_ptr,"%-32s %6lu\n","PROGRAM TOTAL",loc_count);
-    fclose(debug_file_ptr);
+    /* no log, or it stopped before any input was finished */
+    log->fp = fopen(filename,"wb");
+    bytes = add_log_bytes(log,CHECKPOINT_HEADER_SIZE);
+    memcpy(bytes,CHECKPOINT_MAGIC,8);
+    put_number(bytes + 8,(unsigned long) Input_List.count,8);
+    put_number(bytes + 16,Shard_Count,4);
+    put_number(bytes + 20,Shard_Plan,4);
+    for (index = 0; index < Input_List.count; index++)
+    {
+      name_len = strlen(Input_List.names[index]);
+      if (name_len > 0xFFFF)
+        name_len = 0xFFFF;
+      bytes = add_log_bytes(log,2 + name_len);
+      put_number(bytes,(unsigned long) name_len,2);
+      memcpy(bytes + 2,Input_List.names[index],name_len);
+    }
+    if (log->fp != NULL)
+      write_results_log(log);
   }
-
-  /* Print the results */
-  if (WKS_Flag)
-    print_functions_wks(C_Filename,loc_count,WKS_Header_Flag);
   else
-    print_functions(C_Filename,loc_count,physical_loc,comment_loc);
+    return (0);
 
-  /* House Keeping */
-  delete_elements();
+  if (log->fp == NULL)
+  {
+    printf("open_results_log: error writing %s.\n",filename);
+    return (1);
+  }
 
-  return 0;
+  return (0);
 }
 
 /**************************************************************************
 *
-* Function:    create_list_element
+* Function:    open_partials
 *
-* Description: Allocates memory for a linked list element and returns
-*              a pointer to that memory.
+* Description: Maps the results logs of the shards of a run for --merge.
+*              They must all be for the same inputs, which are taken
+*              from them, and each input is replayed from whichever log
+*              finished it.  The shards share out the inputs by size, so
+*              they must also have seen the same sizes; otherwise an
+*              input could have been counted by two shards or by none.
 *
-* Parameters:  none
+* Parameters:  log - reference to the results log to replay from.
+*              partials - names of the results logs of the shards.
 *
-* Globals:     none
+* Globals:     Input_List
 *
-* Locals:      typedef of ELEMENT.
+* Locals:      map_results_log, find_finished_inputs functions.
 *
-* Return:      p - pointer to the memory allocated for that element.
+* Return:      0 if the logs are ready, 1 if one could not be used.
 *
 **************************************************************************/
-ELEMENT *create_list_element(void)
+int open_partials(RESULTS_LOG *log,FILE_LIST *partials)
 {
-  ELEMENT *p;
+  size_t index;
+  size_t records = 0;       /* where the records start */
+  unsigned long shard_count = 0; /* how the first shard shared them out */
+  unsigned long shard_plan = 0;
+  int result;
 
-  p = (ELEMENT *) malloc( sizeof(ELEMENT));
-  if (p==NULL)
+  memset(log,0,sizeof(RESULTS_LOG));
+  for (index = 0; index < partials->count; index++)
   {
-    printf("create_list_element: malloc failed.\n");
-    exit(1);
+    result = map_results_log(log,partials->names[index],Input_List.count,
+      &records);
+    if (result == LOG_MISSING)
+    {
+      printf("open_partials: %s cannot be read.\n",partials->names[index]);
+      return (1);
+    }
+    else if (result != LOG_READY)
+    {
+      printf("open_partials: %s is not a checkpoint of the same files.\n",
+        partials->names[index]);
+      return (1);
+    }
+    if (index == 0)
+    {
+      shard_count = log->shard_count;
+      shard_plan = log->shard_plan;
+    }
+    else if ((log->shard_count != shard_count) ||
+             (log->shard_plan != shard_plan))
+    {
+      printf("open_partials: %s shared out the files differently from %s"
+        " - their sizes changed between the shards.\n",
+        partials->names[index],partials->names[0]);
+      return (1);
+    }
+    find_finished_inputs(log,(unsigned char *) log->maps[log->map_count - 1],
+      log->map_lengths[log->map_count - 1],records);
   }
-  p->next = NULL;
 
-  return p;
-} /* end of function */
+  return (0);
+}
 
 /**************************************************************************
 *
-* Function:    add_element
+* Function:    add_location_bytes
 *
-* Description: Attaches an ELEMENT to the tail end of the linked list
-*              by attaching it to the first ELEMENT that is NULL.
-*              
-* Parameters:  e - reference of ELEMENT e.
+* Description: Makes room at the end of one part of the location index.
+*
+* Parameters:  data - reference to the bytes of the part.
+*              length - reference to the number of bytes used.
+*              size - reference to the number of bytes allocated.
+*              more - number of bytes wanted.
 *
 * Globals:     none
 *
-* Locals:      typedef of ELEMENT
-*              head - first ELEMENT of the linked list
+* Locals:      mem_realloc function.
 *
-* Return:      none
+* Return:      the bytes to fill in.
 *
 **************************************************************************/
-void add_element(ELEMENT *e)
+unsigned char *add_location_bytes(unsigned char **data,size_t *length,
+  size_t *size,size_t more)
 {
-  ELEMENT *p;
+  unsigned char *larger;
+  unsigned char *bytes;
 
-  /* if the first element has not been created, create it now */
-  if (head == NULL)
+  if ((*length + more) > *size)
   {
-    head = e;
-    return;
+    larger = (unsigned char *) mem_realloc(MEM_CACHES,*data,
+      (*size * 2) + more + 4096);
+    if (larger == NULL)
+    {
+      printf("add_location_bytes: malloc failed.\n");
+      exit(1);
+    }
+    *data = larger;
+    *size = (*size * 2) + more + 4096;
   }
+  bytes = *data + *length;
+  *length += more;
 
-  /* otherwise, find the last element in the list */
-  for (p=head;p->next != NULL;p=p->next) {}
-
-  p->next = e;
-  return;
+  return bytes;
 }
 
 /**************************************************************************
 *
-* Function:    delete_elements
+* Function:    index_locations
 *
-* Description: De-allocates memory for all linked list elements starting with
-*              head.
+* Description: Adds a file and where each of its functions is to the
+*              location index of --locations.
 *
-* Parameters:  none
+* Parameters:  index - reference to the location index.
+*              filename - name the file is reported under.
 *
-* Globals:     none
+* Globals:     head - first ELEMENT of the linked list
 *
-* Locals:      typedef of ELEMENT
-*              head - first ELEMENT of the linked list
+* Locals:      add_location_bytes, put_number functions.
 *
 * Return:      none
 *
 **************************************************************************/
-void delete_elements(void)
+void index_locations(LOCATION_INDEX *index,char *filename)
 {
   ELEMENT *current;
-  ELEMENT *next;
+  FUNCTION_PLACE *place;
+  unsigned char *entry;
+  size_t name_len = strlen(filename);
+  unsigned long functions = 0;
 
-  current = head;
-  while(current != NULL)
+  entry = add_location_bytes(&index->files,&index->files_length,
+    &index->files_size,LOCATION_FILE_SIZE);
+  memset(entry,0,LOCATION_FILE_SIZE);
+  put_number(entry,(unsigned long) index->names_length,8);
+  put_number(entry + 8,(unsigned long) name_len,4);
+  put_number(entry + 16,index->function_count,8);
+  memcpy(add_location_bytes(&index->names,&index->names_length,
+    &index->names_size,name_len + 1),filename,name_len + 1);
+
+  for (current = head, place = Places.items; current != NULL;
+       current = current->next, place++)
   {
-    next = current->next;
-    free(current);
-    current = next;
+    /* like the listing, prototypes and calls are left out */
+    if (current->loc_count == 0)
+      continue;
+    name_len = strlen(current->name);
+    entry = add_location_bytes(&index->functions,&index->functions_length,
+      &index->functions_size,LOCATION_FUNCTION_SIZE);
+    put_number(entry,(unsigned long) index->names_length,8);
+    put_number(entry + 8,(unsigned long) name_len,4);
+    put_number(entry + 12,current->loc_count,4);
+    put_number(entry + 16,(unsigned long) place->start,8);
+    put_number(entry + 24,(unsigned long) place->end,8);
+    put_number(entry + 32,place->first_line,4);
+    put_number(entry + 36,place->last_line,4);
+    memcpy(add_location_bytes(&index->names,&index->names_length,
+      &index->names_size,name_len + 1),current->name,name_len + 1);
+    functions++;
   }
+  put_number(index->files + index->files_length - LOCATION_FILE_SIZE + 12,
+    functions,4);
+  index->file_count++;
+  index->function_count += functions;
+
   return;
 }
 
 /**************************************************************************
 *
-* Function:    print_functions_wks
+* Function:    write_locations
 *
-* Description: Prints all linked list elements starting with head.
+* Description: Writes the location index of --locations and frees it.
+*              The offsets of the names are made relative to the start
+*              of the file, so that it can be mapped and used as it is.
+*              It is written to a new file that then replaces the old
+*              one, so a reader never sees half of it.
 *
-* Parameters:  filename (IN) name of file
-*              loc (IN) total logicial lines of code in file.
+* Parameters:  index - reference to the location index.
+*              filename - name of the index.
 *
 * Globals:     none
 *
-* Locals:      typedef of ELEMENT
-*              head - first ELEMENT of the linked list
+* Locals:      get_number, put_number functions.
 *
-* Return:      none
+* Return:      0 if the index was written, 1 if not.
 *
 **************************************************************************/
-void print_functions_wks(char *filename,COUNTER loc,unsigned char header)
+int write_locations(LOCATION_INDEX *index,char *filename)
 {
-  ELEMENT *current = NULL;
-  char *str = NULL;
-  char *name = NULL;
+  char temp_name[MAX_LINE_SIZE * 4];
+  unsigned char header[LOCATION_HEADER_SIZE];
+  unsigned long base;       /* where the names start */
+  size_t offset;
+  FILE *fp;
+  int status = 0;
 
-  /* Find the last token - that is the actual filename */
-  str = strtok(filename,":\\");
-  while (str != NULL)
-  {
-    name = str;
-    str = strtok(NULL,":\\");
-  }
+  base = (unsigned long) (LOCATION_HEADER_SIZE + index->files_length +
+    index->functions_length);
+  for (offset = 0; offset < index->files_length;
+       offset += LOCATION_FILE_SIZE)
+    put_number(index->files + offset,
+      base + get_number(index->files + offset,8),8);
+  for (offset = 0; offset < index->functions_length;
+       offset += LOCATION_FUNCTION_SIZE)
+    put_number(index->functions + offset,
+      base + get_number(index->functions + offset,8),8);
+  memcpy(header,LOCATION_MAGIC,8);
+  put_number(header + 8,index->file_count,8);
+  put_number(header + 16,index->function_count,8);
+  put_number(header + 24,base,8);
 
-  if (header)
-    printf("Program Name,Function Name,Function LOC,Total LOC\n");
-  if (name != NULL)
-    printf("%s,,,%lu\n",name,loc);
+  if (strlen(filename) > (sizeof(temp_name) - 5))
+    status = 1;
   else
-    printf("\n");
-
-  current = head;
-
-  while(current != NULL)
   {
-    if (current->loc_count > 0)
+    sprintf(temp_name,"%s.new",filename);
+    fp = fopen(temp_name,"wb");
+    if ((fp == NULL) ||
+        (fwrite(header,1,sizeof(header),fp) != sizeof(header)) ||
+        (fwrite(index->files,1,index->files_length,fp) !=
+          index->files_length) ||
+        (fwrite(index->functions,1,index->functions_length,fp) !=
+          index->functions_length) ||
+        (fwrite(index->names,1,index->names_length,fp) !=
+          index->names_length))
+      status = 1;
+    if ((fp != NULL) && (fclose(fp) != 0))
+      status = 1;
+    if (status == 0)
     {
-      printf(",%s,%lu\n",current->name,current->loc_count);
+      remove(filename);
+      if (rename(temp_name,filename) != 0)
+        status = 1;
     }
-    current = current->next;
   }
+  if (status != 0)
+    printf("write_locations: error writing %s.\n",filename);
 
-  return;
+  mem_free(index->files);
+  mem_free(index->functions);
+  mem_free(index->names);
+  memset(index,0,sizeof(LOCATION_INDEX));
+
+  return (status);
 }
 
 /**************************************************************************
 *
-* Function:    print_functions
+* Function:    compare_shard_units
 *
-* Description: Prints all linked list elements starting with head.
+* Description: qsort comparison of the inputs of a --shard run, largest
+*              first, then by name so that every shard sorts them alike.
 *
-* Parameters:  none
+* Parameters:  a, b - references to SHARD_UNIT.
 *
 * Globals:     none
 *
-* Locals:      typedef of ELEMENT
-*              head - first ELEMENT of the linked list
+* Locals:      none
 *
-* Return:      none
+* Return:      less than, equal to, or greater than zero.
 *
 **************************************************************************/
-void print_functions(char *filename,COUNTER loc,COUNTER ploc,COUNTER cloc)
+int compare_shard_units(const void *a,const void *b)
 {
-  ELEMENT *current = NULL;
-  COUNTER floc = 0; /* function line of code */
-  char *str = NULL;
-  char *name = NULL;
-  COUNTER methods = 0;
+  const SHARD_UNIT *unit_a = (const SHARD_UNIT *) a;
+  const SHARD_UNIT *unit_b = (const SHARD_UNIT *) b;
+  int result;
 
-  /* Find the last token - that is the actual filename */
-  str = strtok(filename,":\\");
-  while (str != NULL)
+  if (unit_a->bytes != unit_b->bytes)
+    return (unit_a->bytes > unit_b->bytes) ? -1 : 1;
+  result = strcmp(unit_a->name,unit_b->name);
+  if (result != 0)
+    return result;
+  if (unit_a->index != unit_b->index)
+    return (unit_a->index < unit_b->index) ? -1 : 1;
+
+  return 0;
+}
+
+/**************************************************************************
+*
+* Function:    select_shard
+*
+* Description: Shares out the inputs of a --shard run by their size, so
+*              that the shards finish at about the same time.  Largest
+*              first, each input goes to the shard with the fewest bytes
+*              so far, so a huge file is started by a shard of its own
+*              instead of being left to the end of one that is already
+*              full.  Every shard works out the same sharing from the
+*              same inputs of the same sizes, and keeps its own share.
+*
+* Parameters:  none
+*
+* Globals:     Input_List, Shard_Index, Shard_Count, Shard_Member,
+*              Shard_Plan
+*
+* Locals:      compare_shard_units, file_bytes, hash_bytes, put_number
+*              functions.
+*
+* Return:      0 if the inputs were shared out, 1 if not.
+*
+**************************************************************************/
+int select_shard(void)
+{
+  SHARD_UNIT *units;
+  unsigned long *heap;      /* shards, the one with fewest bytes first */
+  double *loads;            /* bytes given to each shard */
+  unsigned char size_bytes[8];
+  unsigned long shard;
+  unsigned long parent;
+  unsigned long child;
+  size_t index;
+
+  units = (SHARD_UNIT *) mem_calloc(MEM_CACHES,Input_List.count + 1,
+    sizeof(SHARD_UNIT));
+  heap = (unsigned long *) mem_calloc(MEM_CACHES,Shard_Count,
+    sizeof(unsigned long));
+  loads = (double *) mem_calloc(MEM_CACHES,Shard_Count,sizeof(double));
+  Shard_Member = (unsigned char *) mem_calloc(MEM_CACHES,
+    Input_List.count + 1,sizeof(unsigned char));
+  if ((units == NULL) || (heap == NULL) || (loads == NULL) ||
+      (Shard_Member == NULL))
   {
-    name = str;
-    str = strtok(NULL,":\\");
+    printf("select_shard: malloc failed.\n");
+    mem_free(units);
+    mem_free(heap);
+    mem_free(loads);
+    return (1);
   }
 
-  printf("Program      Function                         Function Total\n");
-  printf("Name         Name                             LOC      LOC\n");
-  printf("============ ================================ ======== ========\n");
-  if (name != NULL)
-    printf("%s\n",name);
-  else
-    printf("\n");
+  /* the checkpoint of each shard records the sizes it saw, so that
+     --merge can tell if the shards shared the inputs out alike */
+  Shard_Plan = 2166136261UL;
+  for (index = 0; index < Input_List.count; index++)
+  {
+    units[index].name = Input_List.names[index];
+    units[index].index = index;
+    units[index].bytes = file_bytes(Input_List.names[index]);
+    put_number(size_bytes,units[index].bytes,8);
+    Shard_Plan = hash_bytes(Shard_Plan,(char *) size_bytes,8);
+  }
+  qsort(units,Input_List.count,sizeof(SHARD_UNIT),compare_shard_units);
+  for (shard = 0; shard < Shard_Count; shard++)
+    heap[shard] = shard;
 
-  current = head;
-  floc = 0;
+  for (index = 0; index < Input_List.count; index++)
+  {
+    shard = heap[0];
+    if (shard == Shard_Index)
+      Shard_Member[units[index].index] = TRUE;
+    /* an empty file still costs something to open */
+    loads[shard] += (double) units[index].bytes + 1.0;
 
-  while(current != NULL)
+    /* the shard moves down the heap past those with fewer bytes */
+    for (parent = 0; ; parent = child)
+    {
+      child = (parent * 2) + 1;
+      if (child >= Shard_Count)
+        break;
+      if (((child + 1) < Shard_Count) &&
+          ((loads[heap[child + 1]] < loads[heap[child]]) ||
+           ((loads[heap[child + 1]] == loads[heap[child]]) &&
+            (heap[child + 1] < heap[child]))))
+        child++;
+      if ((loads[heap[child]] > loads[shard]) ||
+          ((loads[heap[child]] == loads[shard]) && (heap[child] > shard)))
+        break;
+      heap[parent] = heap[child];
+    }
+    heap[parent] = shard;
+  }
+
+  mem_free(units);
+  mem_free(heap);
+  mem_free(loads);
+
+  return (0);
+}
+
+/**************************************************************************
+*
+* Function:    in_shard
+*
+* Description: Finds if an input is counted by this shard of a --shard
+*              run, as shared out by select_shard.
+*
+* Parameters:  input - index of the input in Input_List.
+*
+* Globals:     Shard_Member
+*
+* Locals:      none
+*
+* Return:      TRUE if the input is counted, FALSE if not.
+*
+**************************************************************************/
+int in_shard(size_t input)
+{
+  if (Shard_Member == NULL)
+    return (TRUE);
+
+  return Shard_Member[input];
+}
+
+/**************************************************************************
+*
+* Function:    log_file_results
+*
+* Description: Adds the results of a file that was just counted to the
+*              results log: its totals and each of its functions, or,
+*              when it was a duplicate, only its fingerprint.
+*
+* Parameters:  log - reference to the results log.
+*              filename - name the contents are reported under.
+*              hash_a, hash_b - fingerprint of the contents, for --dedupe.
+*              length - number of characters in the contents.
+*              counts - reference to the totals, or NULL for a duplicate.
+*              limit - limit the file went over, if any.
+*
+* Globals:     Current_Input
+*
+* Locals:      head - first ELEMENT of the linked list
+*              add_log_bytes, put_number functions.
+*
+* Return:      none
+*
+**************************************************************************/
+void log_file_results(RESULTS_LOG *log,char *filename,unsigned long hash_a,
+  unsigned long hash_b,size_t length,FILE_COUNTS *counts,int limit)
+{
+  ELEMENT *current;
+  FUNCTION_PLACE *place;
+  unsigned char *record;
+  unsigned char *bytes;
+  size_t name_len = strlen(filename);
+  size_t function_len;
+  unsigned long functions = 0;
+  size_t size;
+
+  if (log->fp == NULL)
+    return;
+
+  if (name_len > 0xFFFF)
+    name_len = 0xFFFF;
+  size = CHECKPOINT_FILE_SIZE + name_len;
+  if (counts != NULL)
   {
-    if (current->loc_count > 0)
+    for (current = head; current != NULL; current = current->next)
     {
-      printf("%-12s %-32s %8lu\n"," ",current->name,current->loc_count);
-      floc += current->loc_count;
-      methods++;
+      size += CHECKPOINT_FUNCTION_SIZE + strlen(current->name);
+      functions++;
     }
-    current = current->next;
   }
 
-  printf("                                              --------         \n");
-  printf("TOTAL        %-8lu                         %8lu %8lu",
-    methods,floc,loc);
-  printf("\n");
-  printf("============ ================================ ======== ========\n");
-  printf("%-12s %-32s %-8s %8lu\n","Physical LOC"," "," ",ploc);
-  printf("%-12s %-32s %-8s %8lu\n","Comment LOC"," "," ",cloc);
+  record = add_log_bytes(log,size);
+  memset(record,0,CHECKPOINT_FILE_SIZE);
+  put_number(record,(unsigned long) size,4);
+  record[4] = CHECKPOINT_FILE;
+  record[5] = (unsigned char) limit;
+  put_number(record + 6,(unsigned long) name_len,2);
+  put_number(record + 8,(unsigned long) Current_Input,8);
+  put_number(record + 16,(unsigned long) length,8);
+  put_number(record + 24,hash_a,4);
+  put_number(record + 28,hash_b,4);
+  if (counts != NULL)
+  {
+    put_number(record + 32,counts->loc_count,4);
+    put_number(record + 36,counts->physical_loc,4);
+    put_number(record + 40,counts->comment_loc,4);
+  }
+  put_number(record + 44,functions,4);
+  memcpy(record + CHECKPOINT_FILE_SIZE,filename,name_len);
+  bytes = record + CHECKPOINT_FILE_SIZE + name_len;
+  place = Places.items;
+  for (current = (counts != NULL) ? head : NULL; current != NULL;
+       current = current->next, place++)
+  {
+    function_len = strlen(current->name);
+    put_number(bytes,current->loc_count,4);
+    put_number(bytes + 4,(unsigned long) place->start,8);
+    put_number(bytes + 12,(unsigned long) place->end,8);
+    put_number(bytes + 20,place->first_line,4);
+    put_number(bytes + 24,place->last_line,4);
+    put_number(bytes + 28,place->clone_a,4);
+    put_number(bytes + 32,place->clone_b,4);
+    put_number(bytes + 36,place->tokens,4);
+    put_number(bytes + 40,(unsigned long) function_len,2);
+    memcpy(bytes + CHECKPOINT_FUNCTION_SIZE,current->name,function_len);
+    bytes += CHECKPOINT_FUNCTION_SIZE + function_len;
+  }
 
   return;
 }
 
 /**************************************************************************
 *
-* Function:    last_element
+* Function:    log_input_done
 *
-* Description: Returns a pointer to the last element of the list. If the
-*              list is empty, it returns the NULL pointer.
+* Description: Marks an input as finished in the results log.  Records
+*              are only written out now and then, so that checkpointing
+*              costs little; an input is replayed on --resume once its
+*              mark has been written.
 *
-* Parameters:  none
+* Parameters:  log - reference to the results log.
+*              input - index of the input in Input_List.
+*              status - 0 if the input was counted, 1 if not.
 *
 * Globals:     none
 *
-* Locals:      typedef of ELEMENT.
-*              head - first ELEMENT of the linked list
+* Locals:      add_log_bytes, put_number, write_results_log functions.
 *
-* Return:      p - pointer to the last element.
+* Return:      none
 *
 **************************************************************************/
-ELEMENT *last_element(void)
+void log_input_done(RESULTS_LOG *log,size_t input,int status)
 {
-  ELEMENT *p;
+  unsigned char *record;
 
-  /* if the first element has not been created, return NULL */
-  if (head == NULL)
-  {
-    p = head;
-  }
+  if (log->fp == NULL)
+    return;
 
-  /* otherwise, find the last element in the list */
-  else
+  record = add_log_bytes(log,CHECKPOINT_DONE_SIZE);
+  memset(record,0,CHECKPOINT_DONE_SIZE);
+  put_number(record,CHECKPOINT_DONE_SIZE,4);
+  record[4] = CHECKPOINT_DONE;
+  record[5] = (unsigned char) status;
+  put_number(record + 8,(unsigned long) input,8);
+  if ((time(NULL) - log->last_write) >= CHECKPOINT_SECONDS)
+    write_results_log(log);
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    replay_input
+*
+* Description: Reports an input that was finished before the run was
+*              resumed, from its records in the results log, through the
+*              same reports as a file that is counted.
+*
+* Parameters:  log - reference to the results log.
+*              input - index of the input in Input_List.
+*
+* Globals:     Dedupe_Flag, Name_Pool
+*
+* Locals:      check_duplicate, create_list_element, add_element,
+*              intern_string, report_contents functions.
+*
+* Return:      the status that the input was finished with.
+*
+**************************************************************************/
+int replay_input(RESULTS_LOG *log,size_t input)
+{
+  unsigned char *record;
+  FILE_COUNTS counts;
+  ELEMENT *element;
+  FUNCTION_PLACE *place;
+  char *filename;
+  char name[MAX_LINE_SIZE];
+  unsigned long functions;
+  size_t position;
+  size_t place_index;
+  size_t name_len;
+  size_t size;
+
+  /* find_finished_inputs checked that the records are whole */
+  for (record = log->replay[input]; ; record += size)
   {
-    for (p=head;p->next != NULL;p=p->next) {}
+    size = (size_t) get_number(record,4);
+    if (record[4] == CHECKPOINT_DONE)
+      return record[5];
+
+    name_len = (size_t) get_number(record + 6,2);
+    if ((CHECKPOINT_FILE_SIZE + name_len) > size)
+      break;
+    filename = (char *) mem_alloc(MEM_PATHS,name_len + 1);
+    if (filename == NULL)
+    {
+      printf("replay_input: malloc failed.\n");
+      exit(1);
+    }
+    memcpy(filename,record + CHECKPOINT_FILE_SIZE,name_len);
+    filename[name_len] = 0;
+
+    if (Dedupe_Flag && check_duplicate(filename,NULL,
+        get_number(record + 24,4),
+        get_number(record + 28,4),(size_t) get_number(record + 16,8),FALSE))
+    {
+      mem_free(filename);
+      continue;
+    }
+
+    counts.loc_count = get_number(record + 32,4);
+    counts.physical_loc = get_number(record + 36,4);
+    counts.comment_loc = get_number(record + 40,4);
+    position = CHECKPOINT_FILE_SIZE + name_len;
+    for (functions = get_number(record + 44,4); functions > 0; functions--)
+    {
+      if ((position + CHECKPOINT_FUNCTION_SIZE) > size)
+        break;
+      name_len = (size_t) get_number(record + position + 40,2);
+      if (((position + CHECKPOINT_FUNCTION_SIZE + name_len) > size) ||
+          (name_len >= sizeof(name)))
+        break;
+      memcpy(name,record + position + CHECKPOINT_FUNCTION_SIZE,name_len);
+      name[name_len] = 0;
+      element = create_list_element();
+      element->name = intern_string(&Name_Pool,name);
+      element->loc_count = get_number(record + position,4);
+      add_element(element);
+      if (Places_Flag)
+      {
+        /* add_place may move Places.items, so it is called first */
+        place_index = add_place();
+        place = &Places.items[place_index];
+        place->start = (size_t) get_number(record + position + 4,8);
+        place->end = (size_t) get_number(record + position + 12,8);
+        place->first_line = get_number(record + position + 20,4);
+        place->last_line = get_number(record + position + 24,4);
+        place->clone_a = get_number(record + position + 28,4);
+        place->clone_b = get_number(record + position + 32,4);
+        place->tokens = get_number(record + position + 36,4);
+      }
+      position += CHECKPOINT_FUNCTION_SIZE + name_len;
+    }
+    report_contents(filename,&counts,(int) record[5]);
+    mem_free(filename);
   }
 
-  return p;
-} /* end of function */
+  return (0);
+}
 
 /**************************************************************************
 *
-* Function:    open_input_file
+* Function:    close_results_log
 *
-* Description: Opens a file stream for input (read only) and returns a 
-*              file pointer to that stream.
+* Description: Writes the records that are still pending to the results
+*              log and frees it.
 *
-* Parameters:  filename - string containing the name of the file to be
-*                         opened.
+* Parameters:  log - reference to the results log.
 *
 * Globals:     none
 *
-* Locals:      none
+* Locals:      write_results_log, unmap_file functions.
 *
-* Return:      fp - pointer to the stream of the file opened.
+* Return:      0 if the log was written, 1 if not.
 *
 **************************************************************************/
-FILE *open_input_file(char *filename)
+int close_results_log(RESULTS_LOG *log)
 {
-  FILE *fp;
+  size_t index;
+  int status = 0;
 
-  fp = fopen(filename,"r");
-  if (fp == NULL)
-    printf("open_input_file: error opening %s.\n",filename);
+  if (log->fp != NULL)
+  {
+    status = write_results_log(log);
+    if ((log->fp != NULL) && (fclose(log->fp) != 0))
+      status = 1;
+  }
+  for (index = 0; index < log->map_count; index++)
+    unmap_file(log->maps[index],log->map_lengths[index]);
+  mem_free(log->maps);
+  mem_free(log->map_lengths);
+  mem_free(log->replay);
+  mem_free(log->pending);
+  memset(log,0,sizeof(RESULTS_LOG));
 
-  return fp;
+  return (status);
 }
 
 /**************************************************************************
@@ -831,6 +10422,40 @@ void check_token(char *token,char *prev_token,COUNTER *count,COUNTER ploc)
   }
 }
 
+/**************************************************************************
+*
+* Function:    reset_function_state
+*
+* Description: Clears the function detector so that the next token is
+*              looked at outside of any function.  Called at the start
+*              of each file.
+*
+* Parameters:  none
+*
+* Globals:     Function_State - state of the function detector.
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void reset_function_state(void)
+{
+  Function_State.temp_node = NULL;
+  Function_State.loc_count = 0;
+  Function_State.count_flag = FALSE;
+  Function_State.start_flag = FALSE;
+  Function_State.brace_count = 0;
+  Function_State.parenthesis_count = 0;
+  Function_State.word_start = 0;
+  Function_State.word_line = 0;
+  Function_State.position = 0;
+  Function_State.line = 0;
+  Function_State.slash = FALSE;
+
+  return;
+}
+
 /**************************************************************************
 *
 * Function:    check_for_function
@@ -848,7 +10473,7 @@ void check_token(char *token,char *prev_token,COUNTER *count,COUNTER ploc)
 *              count - reference to a counter that gets incremented upon a 
 *                  match.
 *
-* Globals:     none
+* Globals:     Function_State - state of the function detector.
 *
 * Locals:      function_name_compare function.
 *
@@ -857,32 +10482,35 @@ void check_token(char *token,char *prev_token,COUNTER *count,COUNTER ploc)
 **************************************************************************/
 void check_for_function(char *token,char *prev_token)
 {
-  static ELEMENT *temp_node = {NULL};
-  static COUNTER loc_count = {0};
-  static unsigned char count_flag = {FALSE};
-  static unsigned char start_flag = {FALSE};
-  static COUNTER brace_count = {0};
-  static COUNTER parenthesis_count = {0};
+  FUNCTION_STATE *state = &Function_State;
 
   /* if a '(' is found, and last token is not a keyword,
      then load the function name, turn on the flag */
   /* === Function flag is not set === */
-  if ((start_flag == FALSE) && (brace_count == 0))
+  if ((state->start_flag == FALSE) && (state->brace_count == 0))
   {
     if (strcmp(token,"(") == 0)
     {
       if (function_name_compare(prev_token))
       {
         /* create element and load list */
-        temp_node = create_list_element();
-        /* safe string copy - in case the token is very large. */
-        strncpy(temp_node->name,prev_token,MAX_FUNCTION_NAME);
-        /*(temp_node->name+MAX_FUNCTION_NAME-1)=0;*/
-        temp_node->loc_count = 0;
-        loc_count = 0;
-        add_element(temp_node);
-        start_flag = TRUE;
-        parenthesis_count = 1;
+        state->temp_node = create_list_element();
+        /* names are shared - each different name is stored once */
+        state->temp_node->name = intern_string(&Name_Pool,prev_token);
+        state->temp_node->loc_count = 0;
+        state->loc_count = 0;
+        add_element(state->temp_node);
+        if (Places_Flag)
+        {
+          state->place = add_place();
+          /* prev_token is the last word begun */
+          Places.items[state->place].start = state->word_start;
+          Places.items[state->place].first_line = state->word_line;
+          if (Clones_Flag)
+            clone_token(state,token);
+        }
+        state->start_flag = TRUE;
+        state->parenthesis_count = 1;
         if (Debug_Flag)
         {
           fprintf(debug_file_ptr,"Possible Function=> %s\n",prev_token);
@@ -892,105 +10520,477 @@ void check_for_function(char *token,char *prev_token)
   } /* end of no function flag */
 
   /* === Function flag is set, but not a real function yet === */
-  else if (count_flag == FALSE)
+  else if (state->count_flag == FALSE)
   {
+    if (Clones_Flag && Places_Flag)
+      clone_token(state,token);
     if (strcmp(token,"(") == 0)
-      parenthesis_count++;
+      state->parenthesis_count++;
     else if (strcmp(token,")") == 0)
     {
-      if (parenthesis_count != 0)
-        parenthesis_count--;
+      if (state->parenthesis_count != 0)
+        state->parenthesis_count--;
     }
 
     if (Debug_Flag)
     {
       fprintf(debug_file_ptr,"Function Set, Parenthesis Level=> %lu "
                              "LOC Count=>%lu\n",
-              parenthesis_count,loc_count);
+              state->parenthesis_count,state->loc_count);
     }
     
-    if ((strcmp(prev_token,")") == 0) && (parenthesis_count == 0))
+    if ((strcmp(prev_token,")") == 0) && (state->parenthesis_count == 0))
     {
       /* Look for end of function call or prototype */
       if (strcmp(token,";") == 0)
       {
         /* reset the function to look for new function */
-        start_flag = FALSE;
+        state->start_flag = FALSE;
       }
 
       /* Look for end of function */
       else if (strcmp(token,"{") == 0)
       {
         /* found valid function - start counting lines */
-        count_flag = TRUE;
-        brace_count = 1;
+        state->count_flag = TRUE;
+        state->brace_count = 1;
       }
     } /* end of normal end parenthesis */
 
     /* Look for start of 'old' style of functions */   
-    else if ((strcmp(prev_token,";") == 0) && (parenthesis_count == 0))
+    else if ((strcmp(prev_token,";") == 0) && (state->parenthesis_count == 0))
     {
       if (strcmp(token,"{") == 0)
       {
         /* found valid function - start counting lines */
-        count_flag = TRUE;
-        brace_count = 1;
+        state->count_flag = TRUE;
+        state->brace_count = 1;
       }
     } /* end of old style function */
 
     /* Count valid, countable tokens, including the stuff 
        in the function call during this preliminary stage */
     if (keyword_compare(token))
-      loc_count++;
+      state->loc_count++;
     
   } /* end of function flag set */
 
   /* === Function flag is set and started counting === */
-  else if ((count_flag != FALSE) && (start_flag != FALSE))
+  else if ((state->count_flag != FALSE) && (state->start_flag != FALSE))
   {
+    if (Clones_Flag && Places_Flag)
+      clone_token(state,token);
     if (strcmp(token,"{") == 0)
-      brace_count++;
+      state->brace_count++;
     else if (strcmp(token,"}") == 0)
-      brace_count--;
+      state->brace_count--;
 
     if (Debug_Flag)
     {
       fprintf(debug_file_ptr,"Function Set, Brace Level=> %lu "
                              "LOC Count=>%lu\n",
-              brace_count,loc_count);
+              state->brace_count,state->loc_count);
     }
     
     /* Count valid, countable tokens, including the last brace */
     if (keyword_compare(token))
-      loc_count++;
+      state->loc_count++;
     
     /* Found the end of Function Method */
-    if (brace_count == 0)
+    if (state->brace_count == 0)
     {
       /* turn off the function counter */
-      count_flag = FALSE;
-      start_flag = FALSE;
+      state->count_flag = FALSE;
+      state->start_flag = FALSE;
       /* load the linked list with the results */
-      temp_node->loc_count = loc_count;
+      state->temp_node->loc_count = state->loc_count;
+      if (Places_Flag)
+      {
+        Places.items[state->place].end = state->position + 1;
+        Places.items[state->place].last_line = state->line;
+      }
     }
 
   } /* end of function flag set and count flag set */
     
 } /* end of function */
 
+/**************************************************************************
+*
+* Function:    init_dialects
+*
+* Description: Fills in the character classes that each dialect lexes
+*              with, from Char_Class.  C has no destructors, so ~ ends a
+*              word, and C89 has no // comments.
+*
+* Parameters:  none
+*
+* Globals:     Dialect_Class
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void init_dialects(void)
+{
+  int dialect;
+  int c;
+
+  for (dialect = 0; dialect < LANG_DIALECTS; dialect++)
+  {
+    for (c = 0; c < 256; c++)
+      Dialect_Class[dialect][c] = Char_Class[c];
+  }
+  Dialect_Class[LANG_C89]['~'] = CHAR_PUNCT | CHAR_DELIMITER;
+  Dialect_Class[LANG_C99]['~'] = CHAR_PUNCT | CHAR_DELIMITER;
+  Dialect_Class[LANG_C99]['/'] |= CHAR_LINE_COMMENT;
+  Dialect_Class[LANG_CPP]['/'] |= CHAR_LINE_COMMENT;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    set_dialect
+*
+* Description: Picks the dialect that a file is lexed as, from --lang.
+*              By default every file is C++, as it always was; with
+*              --lang auto it is picked by the extension: .c files are
+*              C99, and everything else, including .h files that may be
+*              in either, is C++.
+*
+* Parameters:  filename - reference to the name of the file.
+*
+* Globals:     Dialect, Lang_Option
+*
+* Locals:      has_suffix function.
+*
+* Return:      none
+*
+**************************************************************************/
+void set_dialect(char *filename)
+{
+  if (Lang_Option != LANG_AUTO)
+    Dialect = Lang_Option;
+  else if (has_suffix(filename,".c"))
+    Dialect = LANG_C99;
+  else
+    Dialect = LANG_CPP;
+
+  return;
+}
+
+/**************************************************************************
+*
+* Function:    find_keyword
+*
+* Description: Looks a word up in the keyword table.
+*
+* Parameters:  word - reference to a string that contains some characters.
+*
+* Globals:     Keywords - table of the keywords and profile rules.
+*
+* Locals:      hash_bytes function.
+*
+* Return:      the entry of the word, or NULL if it is not in the table.
+*
+**************************************************************************/
+KEYWORD_ENTRY *find_keyword(const char *word)
+{
+  KEYWORD_ENTRY *entry;     /* entry in the slot */
+  unsigned long hash;       /* hash of the word */
+  size_t slot;              /* slot being looked at */
+
+  if (Keywords.slot_count == 0)
+    return NULL;
+
+  hash = hash_bytes(2166136261UL,(char *) word,strlen(word));
+  slot = hash & (Keywords.slot_count - 1);
+  while (Keywords.slots[slot] != 0)
+  {
+    entry = &Keywords.entries[Keywords.slots[slot] - 1];
+    if ((entry->hash == hash) && (strcmp(entry->word,word) == 0))
+      return entry;
+    slot = (slot + 1) & (Keywords.slot_count - 1);
+  }
+
+  return NULL;
+}
+
+/**************************************************************************
+*
+* Function:    add_keyword
+*
+* Description: Finds a word in the keyword table, or adds it with no flags
+*              set.  The slots are grown so that no more than half of them
+*              are used.
+*
+* Parameters:  word - reference to a string that contains some characters.
+*
+* Globals:     Keywords - table of the keywords and profile rules.
+*
+* Locals:      find_keyword, hash_bytes functions.
+*
+* Return:      the entry of the word, or NULL if there is no memory.
+*
+**************************************************************************/
+KEYWORD_ENTRY *add_keyword(char *word)
+{
+  KEYWORD_ENTRY *entry;     /* the word in the table */
+  KEYWORD_ENTRY *entries;   /* entries after growing */
+  size_t *slots;            /* slots after growing */
+  size_t slot_count;        /* number of slots after growing */
+  size_t slot;              /* slot of an entry */
+  size_t index;             /* index of an entry */
+
+  entry = find_keyword(word);
+  if (entry != NULL)
+    return entry;
+
+  if (Keywords.count == Keywords.size)
+  {
+    entries = (KEYWORD_ENTRY *) mem_realloc(MEM_NAMES,Keywords.entries,
+      (Keywords.size + 64) * sizeof(KEYWORD_ENTRY));
+    if (entries == NULL)
+      return NULL;
+    Keywords.entries = entries;
+    Keywords.size += 64;
+  }
+  if ((Keywords.count + 1) * 2 > Keywords.slot_count)
+  {
+    slot_count = (Keywords.slot_count == 0) ? 256 : Keywords.slot_count * 2;
+    slots = (size_t *) mem_calloc(MEM_NAMES,slot_count,sizeof(size_t));
+    if (slots == NULL)
+      return NULL;
+    for (index = 0; index < Keywords.count; index++)
+    {
+      slot = Keywords.entries[index].hash & (slot_count - 1);
+      while (slots[slot] != 0)
+        slot = (slot + 1) & (slot_count - 1);
+      slots[slot] = index + 1;
+    }
+    mem_free(Keywords.slots);
+    Keywords.slots = slots;
+    Keywords.slot_count = slot_count;
+  }
+
+  entry = &Keywords.entries[Keywords.count];
+  entry->word = (char *) mem_alloc(MEM_NAMES,strlen(word) + 1);
+  if (entry->word == NULL)
+    return NULL;
+  strcpy(entry->word,word);
+  entry->hash = hash_bytes(2166136261UL,word,strlen(word));
+  memset(entry->flags,0,sizeof(entry->flags));
+  slot = entry->hash & (Keywords.slot_count - 1);
+  while (Keywords.slots[slot] != 0)
+    slot = (slot + 1) & (Keywords.slot_count - 1);
+  Keywords.count++;
+  Keywords.slots[slot] = Keywords.count;
+
+  return entry;
+}
+
+/**************************************************************************
+*
+* Function:    load_keywords
+*
+* Description: Compiles c_keywords into the keyword table.  In each
+*              dialect that has it, a word is reserved if it is in
+*              c_keywords at all, and counted if any of its entries is
+*              valid.
+*
+* Parameters:  none
+*
+* Globals:     Keywords - table of the keywords and profile rules.
+*
+* Locals:      c_keywords - structure containing C keywords
+*              Max_Keywords - total number of keywords
+*
+* Return:      0 if the table was built, 1 if there is no memory.
+*
+**************************************************************************/
+int load_keywords(void)
+{
+  KEYWORD_ENTRY *entry;     /* the word in the table */
+  size_t key_index;         /* index into the keyword structure */
+  int dialect;
+
+  for (key_index = 0; key_index < Max_Keywords; key_index++)
+  {
+    entry = add_keyword(c_keywords[key_index].data);
+    if (entry == NULL)
+    {
+      printf("load_keywords: out of memory.\n");
+      return (1);
+    }
+    for (dialect = 0; dialect < LANG_DIALECTS; dialect++)
+    {
+      if ((c_keywords[key_index].dialects != 0) &&
+          !(c_keywords[key_index].dialects & (1 << dialect)))
+        continue;
+      entry->flags[dialect] |= KEY_RESERVED;
+      if (c_keywords[key_index].valid_flag)
+        entry->flags[dialect] |= KEY_COUNTED;
+    }
+  }
+
+  return (0);
+}
+
+/**************************************************************************
+*
+* Function:    load_profile
+*
+* Description: Reads the counting rules of a site into the keyword table.
+*              Each line is a rule and the words it applies to:
+*                count word...     reserved and counted, like for
+*                reserve word...   reserved but not counted, like int
+*                ignore word...    neither - may be a function name
+*                alias word other  the same as the other word
+*              Lines that start with # are comments.  The rules apply
+*              to every dialect.
+*
+* Parameters:  filename - name of the profile.
+*
+* Globals:     Keywords - table of the keywords and profile rules.
+*
+* Locals:      read_input_file, add_keyword, find_keyword functions.
+*
+* Return:      0 if the profile was loaded, 1 if it has an error.
+*
+**************************************************************************/
+int load_profile(char *filename)
+{
+  char *buffer;             /* contents of the profile */
+  size_t length = 0;        /* number of bytes in buffer */
+  char *line;               /* line being read */
+  char *next;               /* line after it */
+  unsigned long line_number = 0; /* for the error messages */
+  char *rule;               /* first word of the line */
+  char *word;               /* word that the rule applies to */
+  unsigned char flags[LANG_DIALECTS]; /* flags that the rule sets */
+  KEYWORD_ENTRY *entry;     /* the word in the table */
+  KEYWORD_ENTRY *other;     /* the word that an alias is the same as */
+  int status = 0;           /* 1 if the profile has an error */
+
+  buffer = read_input_file(filename,&length);
+  if (buffer == NULL)
+    return (1);
+
+  for (line = buffer; (line != NULL) && (status == 0); line = next)
+  {
+    line_number++;
+    next = strchr(line,'\n');
+    if (next != NULL)
+      *next++ = 0;
+    rule = strtok(line," \t\r\f\v");
+    if ((rule == NULL) || (rule[0] == '#'))
+      continue;
+
+    if (strcmp(rule,"alias") == 0)
+    {
+      word = strtok(NULL," \t\r\f\v");
+      rule = strtok(NULL," \t\r\f\v");
+      other = (rule != NULL) ? find_keyword(rule) : NULL;
+      if ((other == NULL) || (strtok(NULL," \t\r\f\v") != NULL))
+      {
+        printf("load_profile: %s line %lu: alias needs a word "
+          "and a keyword.\n",filename,line_number);
+        status = 1;
+      }
+      else
+      {
+        memcpy(flags,other->flags,sizeof(flags));
+        entry = add_keyword(word);
+        if (entry == NULL)
+        {
+          printf("load_profile: out of memory.\n");
+          status = 1;
+        }
+        else
+          memcpy(entry->flags,flags,sizeof(flags));
+      }
+      continue;
+    }
+
+    if (strcmp(rule,"count") == 0)
+      memset(flags,KEY_RESERVED | KEY_COUNTED,sizeof(flags));
+    else if (strcmp(rule,"reserve") == 0)
+      memset(flags,KEY_RESERVED,sizeof(flags));
+    else if (strcmp(rule,"ignore") == 0)
+      memset(flags,0,sizeof(flags));
+    else
+    {
+      printf("load_profile: %s line %lu: unknown rule %s.\n",
+        filename,line_number,rule);
+      status = 1;
+      continue;
+    }
+    for (word = strtok(NULL," \t\r\f\v"); word != NULL;
+         word = strtok(NULL," \t\r\f\v"))
+    {
+      entry = add_keyword(word);
+      if (entry == NULL)
+      {
+        printf("load_profile: out of memory.\n");
+        status = 1;
+        break;
+      }
+      memcpy(entry->flags,flags,sizeof(flags));
+    }
+  }
+  mem_free(buffer);
+
+  return (status);
+}
+
+/**************************************************************************
+*
+* Function:    delete_keywords
+*
+* Description: Frees the keyword table.
+*
+* Parameters:  none
+*
+* Globals:     Keywords - table of the keywords and profile rules.
+*
+* Locals:      none
+*
+* Return:      none
+*
+**************************************************************************/
+void delete_keywords(void)
+{
+  size_t index;             /* index of an entry */
+
+  for (index = 0; index < Keywords.count; index++)
+    mem_free(Keywords.entries[index].word);
+  mem_free(Keywords.entries);
+  mem_free(Keywords.slots);
+  Keywords.entries = NULL;
+  Keywords.slots = NULL;
+  Keywords.count = 0;
+  Keywords.size = 0;
+  Keywords.slot_count = 0;
+
+  return;
+}
+
 /**************************************************************************
 *
 * Function:    function_name_compare
 *
 * Description: Compares a string with a list of valid strings and checks
 *              for a match.  Also checks for a punctuation or digit if
-*              it is only a digit.
+*              it is only one character, from the Char_Class table.
 *
 * Parameters:  word - reference to a string that contains some characters.
 *
-* Globals:     none
+* Globals:     Keywords - table of the keywords and profile rules.
+*              Dialect - dialect of the file being lexed.
 *
-* Locals:      c_keywords - structure containing C reserved words
+* Locals:      find_keyword function.
 *
 * Return:      status - FALSE if the reserved word or punct match is found.
 *                       TRUE if no match is found.
@@ -999,19 +10999,15 @@ void check_for_function(char *token,char *prev_token)
 int function_name_compare(char *word)
 {
   int status = TRUE;      /* FALSE if reserve word or punct found */
-  int key_index = 0;      /* index into the keyword structure */
+  KEYWORD_ENTRY *entry;   /* the word in the keyword table */
 
   if (strlen(word) > 1)
   {
-    for (key_index=0;key_index < Max_Keywords;key_index++)
-    {
-      if (strcmp(word,c_keywords[key_index].data) == 0)
-        status = FALSE;
-    }
+    entry = find_keyword(word);
+    if ((entry != NULL) && (entry->flags[Dialect] & KEY_RESERVED))
+      status = FALSE;
   }
-  else if (ispunct(word[0]))
-    status = FALSE;
-  else if (isdigit(word[0]))
+  else if (char_class(word[0]) & (CHAR_PUNCT | CHAR_DIGIT))
     status = FALSE;
 
   return status;
@@ -1026,10 +11022,10 @@ int function_name_compare(char *word)
 *
 * Parameters:  word - reference to a string that contains some characters.
 *
-* Globals:     none
+* Globals:     Keywords - table of the keywords and profile rules.
+*              Dialect - dialect of the file being lexed.
 *
-* Locals:      c_keywords - structure containing C keywords
-*              Max_Keywords - total number of keywords
+* Locals:      find_keyword function.
 *
 * Return:      status - TRUE if the keyword match is found.
 *                       FALSE if no match is found.
@@ -1038,16 +11034,11 @@ int function_name_compare(char *word)
 int keyword_compare(const char *word)
 {
   int status = FALSE;      /* TRUE if keyword match found */
-  int key_index = 0;      /* index into the keyword structure */
+  KEYWORD_ENTRY *entry;    /* the word in the keyword table */
 
-  for (key_index=0;key_index < Max_Keywords;key_index++)
-  {
-    if (c_keywords[key_index].valid_flag)
-    {
-      if (strcmp(word,c_keywords[key_index].data) == 0)
-        status = TRUE;
-    }
-  }
+  entry = find_keyword(word);
+  if ((entry != NULL) && (entry->flags[Dialect] & KEY_COUNTED))
+    status = TRUE;
 
   return status;
 }
@@ -1056,28 +11047,64 @@ int keyword_compare(const char *word)
 *
 * Function:    keyword_print
 *
-* Description: Prints a list of valid strings on the screen 5 across.
+* Description: Prints a list of valid strings on the screen 5 across,
+*              under the dialects that count them.
 *
 * Parameters:  none
 *
-* Globals:     none
+* Globals:     Keywords - table of the keywords and profile rules.
 *
-* Locals:      c_keywords - structure containing C keywords
-*              Max_Keywords - total number of keywords
+* Locals:      none
 *
 * Return:      none
 *
 **************************************************************************/
 void keyword_print(void)
 {
-  int key_index = 0;   /* index into the keyword structure */
+  static char *names[LANG_DIALECTS] = {"C89", "C99/C11", "C++"};
+  size_t key_index = 0; /* index into the keyword table */
   int count = 0;       /* counter that counts number of words across screen */
+  int dialects;        /* IN_ dialects of the words being printed */
+  int counted;         /* IN_ dialects that count a word */
+  int dialect;
+  int found;
 
-  for (key_index=0;key_index < Max_Keywords;key_index++)
+  /* the words of every dialect first, then of fewer and fewer */
+  for (dialects = (1 << LANG_DIALECTS) - 1; dialects > 0; dialects--)
   {
-    if (c_keywords[key_index].valid_flag)
+    found = FALSE;
+    for (key_index=0;key_index < Keywords.count;key_index++)
     {
-      printf("%s",c_keywords[key_index].data);
+      counted = 0;
+      for (dialect = 0; dialect < LANG_DIALECTS; dialect++)
+      {
+        if (Keywords.entries[key_index].flags[dialect] & KEY_COUNTED)
+          counted |= (1 << dialect);
+      }
+      if (counted != dialects)
+        continue;
+      if (!found)
+      {
+        if (count > 0)
+          printf("\n");
+        count = 0;
+        if (dialects == ((1 << LANG_DIALECTS) - 1))
+          printf("In every dialect:\n");
+        else
+        {
+          printf("Only in");
+          for (dialect = 0; dialect < LANG_DIALECTS; dialect++)
+          {
+            if (!(dialects & (1 << dialect)))
+              continue;
+            printf("%s%s",((dialects & ((1 << dialect) - 1)) != 0) ?
+              " and " : " ",names[dialect]);
+          }
+          printf(":\n");
+        }
+        found = TRUE;
+      }
+      printf("%s",Keywords.entries[key_index].word);
       count++;
       if (count > 4)
       {
@@ -1173,6 +11200,7 @@ void Interpret_Arguments(int argc, char *argv[])
 {
   int i = 0;
   char *p_arg = NULL;
+  char *p_end = NULL;
 
   if (argc < 2)
   {
@@ -1193,6 +11221,144 @@ void Interpret_Arguments(int argc, char *argv[])
     {
       switch(p_arg[1])
       {
+        /* long options */
+        case '-':
+          if (strcmp(p_arg,"--dedupe") == 0)
+            Dedupe_Flag = TRUE;
+          else if ((strcmp(p_arg,"--git-diff") == 0) && ((i + 1) < argc))
+            Git_Range = argv[++i];
+          else if ((strcmp(p_arg,"--sample") == 0) && ((i + 1) < argc))
+          {
+            Sample_Size = atof(argv[++i]);
+            Sample_Fraction = (strpbrk(argv[i],".%") != NULL);
+            if (strchr(argv[i],'%') != NULL)
+              Sample_Size /= 100.0;
+            File_Report_Flag = FALSE;
+          }
+          else if ((strcmp(p_arg,"--seed") == 0) && ((i + 1) < argc))
+            Sample_Seed = strtoul(argv[++i],NULL,10);
+          else if ((strcmp(p_arg,"--max-bytes") == 0) && ((i + 1) < argc))
+            Limit_Bytes = strtoul(argv[++i],NULL,10);
+          else if ((strcmp(p_arg,"--max-time") == 0) && ((i + 1) < argc))
+            Limit_Seconds = atof(argv[++i]);
+          else if ((strcmp(p_arg,"--max-depth") == 0) && ((i + 1) < argc))
+            Limit_Depth = strtoul(argv[++i],NULL,10);
+          else if ((strcmp(p_arg,"--max-token") == 0) && ((i + 1) < argc))
+          {
+            Limit_Token = (size_t) strtoul(argv[++i],NULL,10);
+            /* the token buffer can not hold any more */
+            if ((Limit_Token == 0) || (Limit_Token > (MAX_LINE_SIZE - 2)))
+              Limit_Token = MAX_LINE_SIZE - 2;
+          }
+          else if ((strcmp(p_arg,"--relex") == 0) && ((i + 2) < argc))
+          {
+            Relex_Old_File = argv[++i];
+            Relex_New_File = argv[++i];
+          }
+          else if (strcmp(p_arg,"--mem-stats") == 0)
+            Mem_Stats_Flag = TRUE;
+          else if ((strcmp(p_arg,"--profile") == 0) && ((i + 1) < argc))
+            Profile_File = argv[++i];
+          else if ((strcmp(p_arg,"--store") == 0) && ((i + 1) < argc))
+            Store_File = argv[++i];
+          else if ((strcmp(p_arg,"--history") == 0) && ((i + 1) < argc))
+            History_Key = argv[++i];
+          else if ((strcmp(p_arg,"--checkpoint") == 0) && ((i + 1) < argc))
+            Results_File = argv[++i];
+          else if (strcmp(p_arg,"--resume") == 0)
+            Resume_Flag = TRUE;
+          else if ((strcmp(p_arg,"--shard") == 0) && ((i + 1) < argc))
+          {
+            i++;
+            if ((sscanf(argv[i],"%lu/%lu",&Shard_Index,&Shard_Count) != 2) ||
+                (Shard_Index < 1) || (Shard_Index > Shard_Count))
+            {
+              printf("--shard: %s is not i/N with 1 <= i <= N.\n",argv[i]);
+              exit(1);
+            }
+            Shard_Index--;
+          }
+          else if (strcmp(p_arg,"--merge") == 0)
+            Merge_Flag = TRUE;
+          else if ((strcmp(p_arg,"--locations") == 0) && ((i + 1) < argc))
+            Locations_File = argv[++i];
+          else if ((strcmp(p_arg,"--microbench") == 0) && ((i + 1) < argc))
+            Microbench_File = argv[++i];
+          else if ((strcmp(p_arg,"--lang") == 0) && ((i + 1) < argc))
+          {
+            i++;
+            if (stricmp(argv[i],"c89") == 0)
+              Lang_Option = LANG_C89;
+            else if ((stricmp(argv[i],"c99") == 0) ||
+                     (stricmp(argv[i],"c11") == 0))
+              Lang_Option = LANG_C99;
+            else if ((stricmp(argv[i],"c++") == 0) ||
+                     (stricmp(argv[i],"cpp") == 0))
+              Lang_Option = LANG_CPP;
+            else if (stricmp(argv[i],"auto") == 0)
+              Lang_Option = LANG_AUTO;
+            else
+            {
+              printf("--lang: %s is not c89, c99, c11, c++ or auto.\n",
+                argv[i]);
+              exit(1);
+            }
+          }
+          else if (strcmp(p_arg,"--perf-counters") == 0)
+            Perf_Flag = TRUE;
+          else if (strcmp(p_arg,"--lines-only") == 0)
+            Lines_Only_Flag = TRUE;
+          else if (strcmp(p_arg,"--rollup") == 0)
+          {
+            Rollup_Flag = TRUE;
+            File_Report_Flag = FALSE;
+          }
+          else if (strcmp(p_arg,"--histogram") == 0)
+          {
+            Histogram_Flag = TRUE;
+            File_Report_Flag = FALSE;
+          }
+          else if (strcmp(p_arg,"--clones") == 0)
+          {
+            Clones_Flag = TRUE;
+            File_Report_Flag = FALSE;
+          }
+          else if ((strcmp(p_arg,"--top") == 0) && ((i + 1) < argc))
+          {
+            i++;
+            Top_Count = strtoul(argv[i],&p_end,10);
+            if ((p_end == argv[i]) || (*p_end != 0) || (Top_Count == 0))
+            {
+              printf("--top: %s is not a number of 1 or more.\n",argv[i]);
+              exit(1);
+            }
+            if (Sort_Key == SORT_NONE)
+              Sort_Key = SORT_LOC;
+            File_Report_Flag = FALSE;
+          }
+          else if ((strcmp(p_arg,"--sort") == 0) && ((i + 1) < argc))
+          {
+            File_Report_Flag = FALSE;
+            i++;
+            if (stricmp(argv[i],"name") == 0)
+              Sort_Key = SORT_NAME;
+            else if (stricmp(argv[i],"file") == 0)
+              Sort_Key = SORT_FILE;
+            else if (stricmp(argv[i],"loc") == 0)
+              Sort_Key = SORT_LOC;
+            else
+            {
+              printf("--sort: %s is not loc, name or file.\n",argv[i]);
+              exit(1);
+            }
+          }
+          else if ((strcmp(p_arg,"--compare") == 0) && ((i + 2) < argc))
+          {
+            Compare_Old_Tree = argv[++i];
+            Compare_New_Tree = argv[++i];
+          }
+          break;
+
         /* debug */
         case 'd':
         case 'D':
@@ -1209,6 +11375,7 @@ void Interpret_Arguments(int argc, char *argv[])
         case 'h':
         case 'H':
           WKS_Header_Flag = TRUE;
+          WKS_Summary_Header_Flag = TRUE;
           WKS_Flag = TRUE;
           break;
 
@@ -1224,8 +11391,8 @@ void Interpret_Arguments(int argc, char *argv[])
     } /* dash arguments */
     else
     {
-      /* standard arg is the C filename to be counted */
-      sscanf(p_arg,"%s",&C_Filename[0]);
+      /* standard args are the C filenames or directories to be counted */
+      add_input_name(&Input_List,p_arg);
     }
   } /* end of arg loop */
 }
@@ -1274,13 +11441,52 @@ void Usage(char *filename)
   printf("\n");
   printf("Usage:\n");
   if (name != NULL)
-    printf("%s filename [-f] [-d]\n",name);
+    printf("%s filename [filename...] [-f] [-d]\n",name);
   else
-    printf("FCLOC filename [[d]ebug]\n");
+    printf("FCLOC filename [filename...] [[d]ebug]\n");
   printf("-f  place into a file\n");
   printf("-w  WKS format (CSV)\n");
   printf("-h  WKS format with header (CSV)\n");
   printf("-d  place debug info into a file\n");
+  printf("--dedupe  count files with identical contents only once\n");
+  printf("filename may be a .tar, .tar.gz or .tar.zst archive\n");
+  printf("--git-diff old..new  size changes of functions in files that\n");
+  printf("            changed between two commits of the git repository\n");
+  printf("--compare old_dir new_dir  functions added, removed or resized\n");
+  printf("            between two source trees, largest growth first\n");
+  printf("filename may be a directory, which is searched for C/C++ files\n");
+  printf("--top N     only the N largest functions of all the files\n");
+  printf("--sort loc|name|file  one report of all the functions, sorted\n");
+  printf("--histogram  function size percentiles by directory and overall\n");
+  printf("--clones    groups of copied functions, largest first\n");
+  printf("--rollup    totals of every directory, including subdirectories\n");
+  printf("--sample FRACTION|N  estimate the totals from a random sample\n");
+  printf("            of the files [--seed N to repeat a sample]\n");
+  printf("--max-bytes N  --max-time SECONDS  --max-depth N  --max-token N\n");
+  printf("            count only the physical and comment LOC of a file\n");
+  printf("            over a limit [--max-time: wall clock time]\n");
+  printf("--lines-only  only the physical and comment LOC, quickly\n");
+  printf("--perf-counters  cycles, instructions and misses of each phase\n");
+  printf("--mem-stats  memory used by each part of the program\n");
+  printf("--profile file  keywords to count, reserve, ignore or alias\n");
+  printf("--store file  add the results of this run to a history\n");
+  printf("--history file:function  size of a function in each run\n");
+  printf("            [from --store file, or %s]\n",HISTORY_DEFAULT_FILE);
+  printf("--checkpoint file  save the results of each finished input\n");
+  printf("--resume    carry on from the checkpoint after its finished\n");
+  printf("            inputs [from --checkpoint file, or %s]\n",
+    CHECKPOINT_DEFAULT_FILE);
+  printf("--shard i/N  count only the i-th of N shares of the inputs\n");
+  printf("--merge     report the checkpoints of the shards named, as if\n");
+  printf("            the inputs had been counted in one run\n");
+  printf("--locations file  write the byte offsets and lines of each\n");
+  printf("            function to an index in file\n");
+  printf("--microbench file  time the inner routines against the\n");
+  printf("            baseline in file [written if there is none]\n");
+  printf("--lang c89|c99|c11|c++|auto  dialect to lex the files as\n");
+  printf("            [c++ if not given; auto: .c files are C99, others C++]\n");
+  printf("--relex old_file new_file  count an edited file again from\n");
+  printf("            the functions that the edit did not change\n");
   printf("\n");
   return;
 }
@@ -0,0 +1,218 @@
+#!/bin/sh
+# Checks of fcloc for make check: each option is run on the small files in
+# tests and its report compared with the one saved in tests/expected.
+# Some options are also checked against another way of getting the same
+# numbers.  Run with UPDATE=1 to save the reports of a changed fcloc as the
+# new expected ones, then look over the differences before committing them.
+#
+# usage: sh tests/check.sh path/to/fcloc
+
+if [ $# -ne 1 ]; then
+  echo "usage: $0 path/to/fcloc"
+  exit 2
+fi
+FCLOC="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+cd "$(dirname "$0")" || exit 2
+rm -rf out
+mkdir out
+
+PASSED=0
+FAILED=0
+
+# pass and fail name [diff]: record the result of a check
+pass()
+{
+  PASSED=$((PASSED + 1))
+}
+
+fail()
+{
+  FAILED=$((FAILED + 1))
+  echo "FAIL: $1"
+}
+
+# expect name command...: the output of the command must be the same as
+# expected/name.txt
+expect()
+{
+  name=$1
+  shift
+  "$@" > out/$name.txt 2>&1
+  if [ -n "$UPDATE" ]; then
+    cp out/$name.txt expected/$name.txt
+  fi
+  if cmp -s expected/$name.txt out/$name.txt; then
+    pass
+  else
+    fail $name
+    diff expected/$name.txt out/$name.txt | head -20
+  fi
+}
+
+# same name first second: two files of output must be the same
+same()
+{
+  if cmp -s $2 $3; then
+    pass
+  else
+    fail $1
+    diff $2 $3 | head -20
+  fi
+}
+
+# the dates of a history change from run to run
+no_dates()
+{
+  "$@" | sed 's/^[0-9][0-9-]* [0-9][0-9]:[0-9][0-9]/YYYY-MM-DD HH:MM/'
+}
+
+# the physical and comment LOC of each file of a full count
+full_lines()
+{
+  "$FCLOC" "$@" | awk '
+    /^[^ =]/ && $1 != "Program" && $1 != "TOTAL" && $1 != "Physical" &&
+      $1 != "Comment" { file = $1 }
+    /^Physical LOC/ { physical = $3 }
+    /^Comment LOC/ { print file, physical, $3 }'
+}
+
+# the physical and comment LOC of each file of --lines-only, which names
+# the members of an archive after the archive too
+quick_lines()
+{
+  "$FCLOC" --lines-only "$@" | awk '
+    /^[^ =]/ && NF == 3 && $1 != "TOTAL" { print $1, $2, $3 }' |
+    sed 's/^[^ ]*\.tar://'
+}
+
+# the inputs are also counted from an archive; tar keeps the order given
+tar cf out/src.tar $(find src -type f | sort)
+
+# reports
+expect default "$FCLOC" src
+expect wks "$FCLOC" -w src
+expect wks_header "$FCLOC" -h src
+expect archive "$FCLOC" out/src.tar
+# damaged archives are reported, not read past the memory they were given
+expect archive_bad_size "$FCLOC" archives/bad_size.tar
+expect archive_big_size "$FCLOC" archives/big_size.tar
+expect archive_bad_pax "$FCLOC" archives/bad_pax.tar
+expect dedupe "$FCLOC" --dedupe src src/lib/table.c
+# members of an archive are compared with the copy kept of the first one
+mkdir out/dup
+cp src/lib/table.c out/dup/a.c
+cp src/lib/table.c out/dup/b.c
+(cd out && tar cf dup.tar dup/a.c dup/b.c)
+expect dedupe_archive "$FCLOC" --dedupe out/dup.tar
+expect top "$FCLOC" --top 4 src
+expect sort_loc "$FCLOC" --sort loc src
+expect sort_name "$FCLOC" --sort name src
+expect sort_file "$FCLOC" -w --sort file src
+expect top_bad "$FCLOC" --top src
+expect top_zero "$FCLOC" --top 0 src
+expect sort_bad "$FCLOC" --sort size src
+expect histogram "$FCLOC" --histogram src
+expect clones "$FCLOC" --clones src
+expect rollup "$FCLOC" --rollup src out/src.tar
+# an archive in the current directory rolls up into "." with the files
+cp src/main.c out/main.c
+expect rollup_here sh -c "cd out && \"$FCLOC\" --rollup src.tar main.c"
+expect sample "$FCLOC" --sample 0.5 --seed 7 src
+expect sample_count "$FCLOC" -w --sample 4 --seed 11 src
+expect lines_only "$FCLOC" --lines-only src
+expect limits "$FCLOC" --max-bytes 700 --max-depth 2 src
+# the clock is read every 64K characters, and that takes more than 1us
+i=0
+while [ $i -lt 100 ]; do
+  cat src/lib/list.c
+  i=$((i + 1))
+done > out/long.c
+expect limits_time "$FCLOC" --max-time 0.000001 out/long.c
+expect profile "$FCLOC" --profile profile.txt src/main.c src/lib/list.c
+# without --lang every file is C++, as it always was
+expect lang_default "$FCLOC" lang/legacy.c
+expect lang_auto_c "$FCLOC" --lang auto lang/legacy.c
+expect lang_c89 "$FCLOC" --lang c89 src/modern.c src/shape.cpp
+expect lang_c11 "$FCLOC" --lang c11 src/modern.c src/shape.cpp
+expect lang_auto "$FCLOC" --lang auto src/modern.c src/shape.cpp
+expect lang_bad "$FCLOC" --lang c90 src/modern.c
+expect compare "$FCLOC" --compare old new
+expect relex "$FCLOC" --relex old/list.c new/list.c
+# the times and counters change, but -h still heads the summaries
+expect summary_headers sh -c "\"$FCLOC\" -h --perf-counters --mem-stats \
+  src/main.c | grep -e '^Phase,' -e '^Memory,'"
+"$FCLOC" --store out/history src > /dev/null
+"$FCLOC" --store out/history new > /dev/null
+expect history no_dates "$FCLOC" --store out/history --history list.c:list_sum
+expect history_wks no_dates "$FCLOC" -w --store out/history \
+  --history list.c:list_sum
+"$FCLOC" --locations out/locations src > /dev/null
+expect locations od -A d -t x1 out/locations
+
+# a --lines-only count has the same physical and comment LOC as a full one
+full_lines src out/src.tar > out/full_lines.txt
+quick_lines src out/src.tar > out/quick_lines.txt
+same lines_only_full out/full_lines.txt out/quick_lines.txt
+
+# --relex reports the same as counting the edited file from the start
+"$FCLOC" --relex old/list.c new/list.c | grep -v '^Relexed' \
+  > out/relexed.txt
+"$FCLOC" new/list.c > out/counted.txt
+same relex_full out/relexed.txt out/counted.txt
+
+# shards merged report the same as one run
+"$FCLOC" src out/src.tar > out/single.txt
+"$FCLOC" --shard 1/2 --checkpoint out/shard1 src out/src.tar > /dev/null
+"$FCLOC" --shard 2/2 --checkpoint out/shard2 src out/src.tar > /dev/null
+"$FCLOC" --merge out/shard1 out/shard2 > out/merged.txt
+same shard_merge out/single.txt out/merged.txt
+"$FCLOC" -w --histogram src out/src.tar > out/single_histogram.txt
+"$FCLOC" -w --histogram --shard 1/3 --checkpoint out/shard1 src \
+  out/src.tar > /dev/null
+"$FCLOC" -w --histogram --shard 2/3 --checkpoint out/shard2 src \
+  out/src.tar > /dev/null
+"$FCLOC" -w --histogram --shard 3/3 --checkpoint out/shard3 src \
+  out/src.tar > /dev/null
+"$FCLOC" -w --histogram --merge out/shard1 out/shard2 out/shard3 \
+  > out/merged_histogram.txt
+same shard_merge_histogram out/single_histogram.txt \
+  out/merged_histogram.txt
+
+# shards that saw the inputs at different sizes may have shared them out
+# differently, so they are not merged
+mkdir out/grown
+cp src/main.c src/modern.c src/lib/list.c out/grown
+"$FCLOC" --shard 1/2 --checkpoint out/grown/shard1 out/grown/*.c \
+  > /dev/null
+echo "int grown(void) { return 1; }" >> out/grown/main.c
+"$FCLOC" --shard 2/2 --checkpoint out/grown/shard2 out/grown/*.c \
+  > /dev/null
+expect shard_grown "$FCLOC" --merge out/grown/shard1 out/grown/shard2
+
+# a run resumed from a checkpoint cut short reports the same as one run
+"$FCLOC" --checkpoint out/checkpoint src out/src.tar > out/checkpoint.txt
+same checkpoint out/single.txt out/checkpoint.txt
+head -c 1500 out/checkpoint > out/checkpoint_cut
+"$FCLOC" --resume --checkpoint out/checkpoint_cut src out/src.tar \
+  > out/resumed.txt
+same resume out/single.txt out/resumed.txt
+
+# --git-diff needs git and a repository with two commits
+if command -v git > /dev/null 2>&1; then
+  mkdir out/git
+  cp old/*.c out/git
+  (cd out/git && git init -q && git add . &&
+    git -c user.name=check -c user.email=check@localhost commit -q -m old &&
+    rm *.c && cp ../../new/*.c . && git add -A . &&
+    git -c user.name=check -c user.email=check@localhost commit -q -m new)
+  expect git_diff sh -c "cd out/git && \"$FCLOC\" --git-diff HEAD~1..HEAD"
+else
+  echo "skipped: git_diff (no git)"
+fi
+
+echo "$PASSED passed, $FAILED failed"
+if [ $FAILED -ne 0 ]; then
+  exit 1
+fi
+rm -rf out
+exit 0
@@ -0,0 +1,15 @@
+/* C that uses C++ keywords as names - counted differently by dialect */
+struct shape
+{
+  int class;
+  int new;
+};
+
+int shape_class(struct shape *this)
+{
+  int try = this->class;
+
+  if (try > 0)
+    try = ~try;
+  return try;
+}
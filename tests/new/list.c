@@ -0,0 +1,58 @@
+#include <stdlib.h>
+#include "list.h"
+
+/* adds a value at the head of the list */
+void list_push(LIST *list, int value)
+{
+  NODE *node = malloc(sizeof(NODE));
+
+  if (node == NULL)
+    return;
+  node->value = value;
+  node->next = list->head;
+  list->head = node;
+  list->count++;
+}
+
+void list_free(LIST *list)
+{
+  NODE *next;
+
+  while (list->head != NULL)
+  {
+    next = list->head->next;
+    free(list->head);
+    list->head = next;
+  }
+  list->count = 0;
+}
+
+/* counts the values that are even */
+int list_even(const LIST *list)
+{
+  const NODE *node;
+  int total = 0;
+
+  for (node = list->head; node != NULL; node = node->next)
+    if ((node->value % 2) == 0)
+      total++;
+  return total;
+}
+
+/* adds up the positive values, and takes one off for the others */
+int list_sum(const LIST *list)
+{
+  const NODE *node;
+  int total = 0;
+
+  for (node = list->head; node != NULL; node = node->next)
+  {
+    if (node->value > 0)
+      total += node->value;
+    else if (node->value < 0)
+      total -= 1;
+    else
+      total += 0;
+  }
+  return total;
+}
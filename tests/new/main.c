@@ -0,0 +1,46 @@
+/* small program used by the fcloc checks */
+#include <stdio.h>
+#include "lib/list.h"
+
+static int verbose = 0;
+
+/* prints each value of the list */
+static void print_list(const LIST *list)
+{
+  const NODE *node;
+
+  for (node = list->head; node != NULL; node = node->next)
+  {
+    if (verbose)
+      printf("value %d\n", node->value);
+    else
+      printf("%d\n", node->value);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  LIST list = { NULL, 0 };
+  int i;
+
+  if (argc > 1)
+    verbose = 1;
+  for (i = 0; i < 10; i++)
+  {
+    switch (i % 3)
+    {
+      case 0:
+        list_push(&list, i);
+        break;
+      case 1:
+        list_push(&list, -i);
+        break;
+      default:
+        break;
+    }
+  }
+  print_list(&list);
+  list_free(&list);
+
+  return 0;
+}
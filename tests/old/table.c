@@ -0,0 +1,31 @@
+/*
+ * table helpers - the sum below was copied from list.c with the
+ * names changed
+ */
+#include "table.h"
+
+int table_sum(const int *values, unsigned count)
+{
+  unsigned index;
+  int total = 0;
+
+  for (index = 0; index < count; index++)
+  {
+    if (values[index] > 0)
+      total += values[index];
+    else
+      total -= 1;
+  }
+  return total;
+}
+
+int table_max(const int *values, unsigned count)
+{
+  unsigned index;
+  int best = values[0];
+
+  for (index = 1; index < count; index++)
+    if (values[index] > best)
+      best = values[index];
+  return best;
+}
@@ -0,0 +1,20 @@
+#ifndef LIST_H
+#define LIST_H
+
+typedef struct node
+{
+  int value;
+  struct node *next;
+} NODE;
+
+typedef struct list
+{
+  NODE *head;
+  unsigned count;
+} LIST;
+
+extern void list_push(LIST *list, int value);
+extern void list_free(LIST *list);
+extern int list_sum(const LIST *list);
+
+#endif
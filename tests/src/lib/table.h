@@ -0,0 +1,2 @@
+extern int table_sum(const int *values, unsigned count);
+extern int table_max(const int *values, unsigned count);
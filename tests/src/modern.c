@@ -0,0 +1,21 @@
+#include <stdbool.h>
+
+/* C99 and C11 words, which C89 does not know */
+static inline bool is_even(int value)
+{
+  return (value % 2) == 0;
+}
+
+_Static_assert(sizeof(int) >= 2, "int too small");
+
+int count_even(const int *restrict values, int count)
+{
+  int total = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    if (is_even(values[i]))
+      total++;
+  }
+  return total;
+}
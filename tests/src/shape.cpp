@@ -0,0 +1,30 @@
+// shapes for the C++ checks
+#include "shape.hpp"
+
+namespace geometry {
+
+double Square::area() const
+{
+  return side * side;
+}
+
+double Circle::area() const
+{
+  try
+  {
+    return 3.14159 * radius * radius;
+  }
+  catch (...)
+  {
+    return 0.0;
+  }
+}
+
+template <class T> T largest(T a, T b)
+{
+  if (a > b)
+    return a;
+  return b;
+}
+
+}
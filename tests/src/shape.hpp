@@ -0,0 +1,28 @@
+namespace geometry {
+
+class Shape
+{
+public:
+  virtual double area() const = 0;
+  virtual ~Shape() {}
+};
+
+class Square : public Shape
+{
+public:
+  explicit Square(double s) : side(s) {}
+  double area() const;
+private:
+  double side;
+};
+
+class Circle : public Shape
+{
+public:
+  explicit Circle(double r) : radius(r) {}
+  double area() const;
+private:
+  double radius;
+};
+
+}